@@ -0,0 +1,51 @@
+// 单趟扫描的 decoupled look-back
+// 各工作组以原子计数器按启动顺序取得分块序号，发布本块的和后向前查看前面各块的状态，
+// 累加各块的和，遇到已发布包含前缀的块即停止；取得序号的顺序保证了前面的块已在执行，不会死锁
+// 须在包含此文件前定义 LOOKBACK_BINDING，缓冲区在每次 dispatch 前清零
+#define TILE_FLAG_AGGREGATE 1u
+#define TILE_FLAG_PREFIX 2u
+
+layout(binding = LOOKBACK_BINDING) coherent buffer tileStateBuffer {
+    uint tileCounter;
+    uint tileStates[];  // 每块三个字：标志、本块的和、包含本块在内的前缀和
+};
+shared uint sharedTileIndex;
+shared uint sharedTilePrefix;
+
+// 须由整个工作组调用
+uint AcquireTileIndex()
+{
+    if (gl_LocalInvocationIndex == 0) sharedTileIndex = atomicAdd(tileCounter, 1);
+    barrier();
+    return sharedTileIndex;
+}
+// 返回本块之前所有块的和，aggregate 为本块的和，须由整个工作组调用
+uint LookBack(uint tileIndex, uint aggregate)
+{
+    if (gl_LocalInvocationIndex == 0) {
+        uint state = tileIndex * 3;
+        uint prefix = 0;
+        if (tileIndex != 0) {
+            tileStates[state + 1] = aggregate;
+            memoryBarrierBuffer();
+            atomicExchange(tileStates[state], TILE_FLAG_AGGREGATE);
+            for (int i = int(tileIndex) - 1; i >= 0;) {
+                uint flag = atomicOr(tileStates[i * 3], 0);
+                if (flag == 0) continue;  // 该块尚未发布，等待
+                memoryBarrierBuffer();
+                if (flag == TILE_FLAG_PREFIX) {
+                    prefix += tileStates[i * 3 + 2];
+                    break;
+                }
+                prefix += tileStates[i * 3 + 1];
+                i--;
+            }
+        }
+        tileStates[state + 2] = prefix + aggregate;
+        memoryBarrierBuffer();
+        atomicExchange(tileStates[state], TILE_FLAG_PREFIX);
+        sharedTilePrefix = prefix;
+    }
+    barrier();
+    return sharedTilePrefix;
+}
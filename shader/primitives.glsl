@@ -0,0 +1,58 @@
+// 并行原语共用的工作组级前缀和
+// 以 -DUSE_SUBGROUP 编译时使用子组运算，否则以共享内存完成，适用于不支持子组运算的设备
+#ifndef WG_SIZE
+#define WG_SIZE 256
+#endif
+
+#ifdef USE_SUBGROUP
+#extension GL_KHR_shader_subgroup_basic : require
+#extension GL_KHR_shader_subgroup_arithmetic : require
+shared uint scanSubgroupSums[WG_SIZE];  // 子组个数不超过工作组的调用数
+shared uint scanTotal;
+#else
+shared uint scanShared[WG_SIZE];
+#endif
+
+// 工作组内的排他前缀和，total 为整个工作组的和
+// 须由工作组的所有调用在一致的控制流中调用，返回前所有调用均已读完调用前写入的共享内存
+uint WorkgroupExclusiveScan(uint value, out uint total)
+{
+#ifdef USE_SUBGROUP
+    uint exclusive = subgroupExclusiveAdd(value);
+    uint subgroupSum = subgroupAdd(value);
+    if (subgroupElect()) scanSubgroupSums[gl_SubgroupID] = subgroupSum;
+    barrier();
+    // 由第一个子组对各子组的和求前缀和，子组个数多于子组大小时分段进行
+    if (gl_SubgroupID == 0) {
+        uint carry = 0;
+        for (uint i = 0; i < gl_NumSubgroups; i += gl_SubgroupSize) {
+            uint index = i + gl_SubgroupInvocationID;
+            uint sum = index < gl_NumSubgroups ? scanSubgroupSums[index] : 0;
+            uint prefix = subgroupExclusiveAdd(sum);
+            if (index < gl_NumSubgroups) scanSubgroupSums[index] = carry + prefix;
+            carry += subgroupAdd(sum);
+        }
+        if (subgroupElect()) scanTotal = carry;
+    }
+    barrier();
+    uint result = scanSubgroupSums[gl_SubgroupID] + exclusive;
+    total = scanTotal;
+    barrier();
+    return result;
+#else
+    // Hillis-Steele 扫描，每步读写之间以屏障隔开
+    uint index = gl_LocalInvocationIndex;
+    scanShared[index] = value;
+    barrier();
+    for (uint offset = 1; offset < WG_SIZE; offset <<= 1) {
+        uint addend = index >= offset ? scanShared[index - offset] : 0;
+        barrier();
+        scanShared[index] += addend;
+        barrier();
+    }
+    uint result = scanShared[index] - value;
+    total = scanShared[WG_SIZE - 1];
+    barrier();
+    return result;
+#endif
+}
@@ -1,18 +1,26 @@
 #pragma once
 // 可能会用上的C++标准库
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <concepts>
+#include <condition_variable>
+#include <deque>
 #include <format>
 #include <fstream>
 #include <functional>
+#include <iomanip>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <numbers>
 #include <numeric>
+#include <random>
 #include <span>
 #include <sstream>
 #include <stack>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
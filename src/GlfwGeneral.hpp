@@ -1,4 +1,11 @@
-#include "VKBase.h"
+#include "VKBindless.h"
+#include "VKDescriptorBuffer.h"
+#include "VKDynamicRendering.h"
+#include "VKExternalMemoryHost.h"
+#include "VKHostImageCopy.h"
+#include "VKPipelineLibrary.h"
+#include "VKShaderModule.h"
+#include "VKShaderObject.h"
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 #pragma comment(lib, "glfw3.lib")
@@ -80,11 +87,28 @@ bool InitializeWindow(VkExtent2D size, bool fullScreen = false, bool isResizable
 
     // 查询获取物理设备
     // 选择一个物理设备
-    // 创建逻辑设备
     if (vulkan::graphicsBase::Base().GetPhysicalDevices() ||
-        vulkan::graphicsBase::Base().DeterminePhysicalDevice(0, true, false) ||
-        vulkan::graphicsBase::Base().CreateDevice())
+        vulkan::graphicsBase::Base().DeterminePhysicalDevice(0, true, false))
         return false;
+    // 使用动态渲染，不创建 render pass 和帧缓冲，重建交换链时无需重建帧缓冲
+    // 需在创建逻辑设备前调用，以添加所需的扩展和特性
+    dynamicRendering::Base().Enable();
+    // 为 bindless 描述符堆添加描述符索引所需的扩展和特性
+    bindlessHeap::Base().Enable();
+    // 设备支持时以 VK_EXT_descriptor_buffer 管理描述符，否则使用描述符集
+    descriptorBackend::Base().Enable();
+    // 设备支持时由 CPU 直接写入纹理，不支持时纹理经由暂存缓冲区上传
+    hostImageCopy::Base().Enable();
+    // 设备支持时，大型只读资产可将映射的文件直接导入为设备内存
+    externalMemoryHost::Base().Enable();
+    // 设备支持时，图形管线分部分编译后快速链接，不支持时整体编译
+    graphicsPipelineLibrary::Base().Enable();
+    // 设备支持时，工具、UI 等可不创建管线，以着色器对象绘制
+    shaderObject::Base().Enable();
+    // 设备支持 maintenance5 时，SPIR-V 直接内联到管线的创建信息中，不创建着色器模块
+    shaderModuleRegistry::Base().Enable();
+    // 创建逻辑设备
+    if (vulkan::graphicsBase::Base().CreateDevice()) return false;
 
     // 创建交换链
     if (graphicsBase::Base().CreateSwapchain(limitFrameRate)) return false;
@@ -94,6 +118,8 @@ bool InitializeWindow(VkExtent2D size, bool fullScreen = false, bool isResizable
 void TerminateWindow()
 {
     vulkan::graphicsBase::Base().WaitIdle();
+    // 在静态对象析构前销毁设备，使各子系统的回调在其单例仍存在时执行
+    vulkan::graphicsBase::Base().Terminate();
     glfwTerminate();
 }
 void MakeWindowFullScreen()
@@ -0,0 +1,83 @@
+#pragma once
+#include "EasyVKStart.h"
+
+// 固定数量的工作线程，每个线程有一个从 0 开始的编号
+// 编号可直接作为 commandPoolManager 等按线程划分资源的类的 threadIndex
+class threadPool {
+    std::vector<std::thread> workers;
+    std::deque<std::function<void(uint32_t)>> tasks;  // 参数为执行该任务的工作线程编号
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+
+    void WorkerLoop(uint32_t workerIndex)
+    {
+        while (true) {
+            std::function<void(uint32_t)> task;
+            {
+                std::unique_lock lock(mutex);
+                condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task(workerIndex);
+        }
+    }
+
+public:
+    // workerCount 为 0 时使用硬件线程数
+    threadPool(uint32_t workerCount = 0)
+    {
+        if (!workerCount) workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+        workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++)
+            workers.emplace_back(&threadPool::WorkerLoop, this, i);
+    }
+    threadPool(threadPool&&) = delete;
+    ~threadPool()
+    {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        for (auto& i : workers) i.join();
+    }
+    // Getter
+    uint32_t WorkerCount() const
+    {
+        return uint32_t(workers.size());
+    }
+    // Non-const Function
+    // 异步执行，不等待完成
+    void Enqueue(std::function<void(uint32_t workerIndex)> task)
+    {
+        {
+            std::lock_guard lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        condition.notify_one();
+    }
+    // 将 [0, taskCount) 分发到各工作线程，阻塞直到全部完成
+    // 不可在工作线程中调用，否则可能因所有线程都在等待而死锁
+    void ParallelFor(uint32_t taskCount,
+                     const std::function<void(uint32_t taskIndex, uint32_t workerIndex)>& function)
+    {
+        if (!taskCount) return;
+        std::atomic<uint32_t> nextTask = 0;
+        uint32_t finishedWorkers = 0;
+        std::mutex mutex_finished;
+        std::condition_variable condition_finished;
+        // 每个工作线程领取一个循环任务，从共享计数器中取下标，直到取完
+        uint32_t launchCount = std::min(taskCount, WorkerCount());
+        for (uint32_t i = 0; i < launchCount; i++)
+            Enqueue([&](uint32_t workerIndex) {
+                for (uint32_t task; (task = nextTask++) < taskCount;) function(task, workerIndex);
+                std::lock_guard lock(mutex_finished);
+                if (++finishedWorkers == launchCount) condition_finished.notify_one();
+            });
+        std::unique_lock lock(mutex_finished);
+        condition_finished.wait(lock, [&] { return finishedWorkers == launchCount; });
+    }
+};
@@ -0,0 +1,366 @@
+#pragma once
+#include "VKCompute.h"
+#include "VKShaderModule.h"
+#include <gtc/packing.hpp>
+
+namespace vulkan {
+// GPU 上的自动曝光：统计 HDR 图像的亮度直方图，在 GPU 上求出曝光并写入 ExposureBuffer，
+// 色调映射的着色器在下一帧（或同一帧中随后）读取，CPU 不回读也不等待
+// 色调映射的着色器中以如下布局读取（可作为 uniform 或 storage 缓冲区绑定）：
+//   layout(binding = N) readonly buffer exposureBuffer { float exposure; float averageLuminance; };
+// 着色器为 shader/luminance_histogram.comp 与 shader/exposure.comp，编译方式同 parallelPrimitives，
+// 两者均有 _subgroup 版本；luminance_histogram 的子组版本还需要 vote 运算
+// 1. 直方图按 pixelStride 隔行隔列采样，默认每 2x2 个像素取一个，4K 图像只需读取约 200 万个像素
+// 2. 先在共享内存中统计，整个子组落入同一个桶时只做一次原子加法，减少大片相近亮度区域的争用
+// 3. 曝光由单个工作组求出，忽略最暗与最亮的一部分像素，随时间平滑过渡，并清零直方图供下一帧使用
+// 4. Benchmark 以随机亮度的 4K 图像测量两次计算的耗时，目标为远低于 0.1 ms
+class autoExposure {
+public:
+    struct parameters {
+        float minLog2Luminance = -10.f;
+        float maxLog2Luminance = 8.f;
+        float lowPercentile = 0.5f;    // 忽略最暗的这部分像素
+        float highPercentile = 0.02f;  // 忽略最亮的这部分像素
+        float keyValue = 0.18f;        // 平均亮度映射到的值
+        float minExposure = 1.f / 64;
+        float maxExposure = 64.f;
+        float adaptationSpeed = 1.5f;  // 每秒，越大过渡越快
+        uint32_t pixelStride = 2;
+    };
+
+private:
+    struct frameDescriptors {
+        VkDescriptorSet histogramSet = VK_NULL_HANDLE;
+        VkImageView imageView = VK_NULL_HANDLE;  // 上次写入 histogramSet 的图像视图
+    };
+    bool useSubgroup = false;
+    parameters params;
+    computeKernel histogramKernel;
+    computeKernel exposureKernel;
+    computeBuffer<uint32_t> histogram;
+    computeBuffer<float> exposure;
+    VkSampler sampler = VK_NULL_HANDLE;  // 由 samplerCache 持有
+    descriptorPool pool;
+    VkDescriptorSet exposureSet = VK_NULL_HANDLE;
+    std::vector<frameDescriptors> frames;
+    bool buffersInitialized = false;  // 直方图是否已清零、曝光是否已写入初始值
+
+    //--------------------
+    VkResult LoadKernel(const char* directory, const char* name, computeKernel& kernel) const
+    {
+        std::string filepath =
+            std::format("{}/{}{}.spv", directory, name, useSubgroup ? "_subgroup" : "");
+        shaderModuleRegistry::handle_t handle;
+        if (VkResult result = shaderModuleRegistry::Base().Load(filepath.c_str(), handle))
+            return result;
+        VkResult result = kernel.Create(shaderModuleRegistry::Base().Code(handle));
+        shaderModuleRegistry::Base().Release(handle);
+        return result;
+    }
+    // 图像视图变更时更新该帧的描述符集，该帧此前的命令须已执行完毕
+    void UpdateHistogramSet(frameDescriptors& frame, VkImageView imageView,
+                            VkImageLayout imageLayout) const
+    {
+        VkDescriptorImageInfo imageInfo = {sampler, imageView, imageLayout};
+        VkDescriptorBufferInfo bufferInfo = {histogram, 0, VK_WHOLE_SIZE};
+        VkWriteDescriptorSet writes[] = {
+            {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+             .dstSet = frame.histogramSet,
+             .dstBinding = 0,
+             .descriptorCount = 1,
+             .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+             .pImageInfo = &imageInfo},
+            {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+             .dstSet = frame.histogramSet,
+             .dstBinding = 1,
+             .descriptorCount = 1,
+             .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+             .pBufferInfo = &bufferInfo}};
+        vkUpdateDescriptorSets(graphicsBase::Base().Device(), 2, writes, 0, nullptr);
+        frame.imageView = imageView;
+    }
+
+public:
+    autoExposure() = default;
+    autoExposure(autoExposure&&) = default;
+    // Getter
+    // 内容为 { float exposure; float averageLuminance; }，首次 CmdDispatch 时以曝光 1 开始过渡
+    const computeBuffer<float>& ExposureBuffer() const
+    {
+        return exposure;
+    }
+    parameters& Parameters()
+    {
+        return params;
+    }
+    bool UseSubgroup() const
+    {
+        return useSubgroup;
+    }
+    // Non-const Function
+    // 录制直方图与曝光的计算，frameIndex 为当前飞行中的帧的索引，deltaTime 的单位为秒
+    // hdrImageView 须处于 hdrImageLayout，且写入已对计算着色器可见，
+    // 例如在 renderGraph 中将其声明为 usage_sampledCompute
+    // 录制的屏障使 ExposureBuffer 的写入对此后的片段与计算着色器可见
+    VkResult CmdDispatch(VkCommandBuffer commandBuffer, uint32_t frameIndex,
+                         VkImageView hdrImageView, VkExtent2D extent, float deltaTime,
+                         VkImageLayout hdrImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        if (frameIndex >= frames.size()) {
+            std::cout << std::format("[ autoExposure ] ERROR\nInvalid frame index: {}\n",
+                                     frameIndex);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        frameDescriptors& frame = frames[frameIndex];
+        if (frame.imageView != hdrImageView)
+            UpdateHistogramSet(frame, hdrImageView, hdrImageLayout);
+        // 此前读取 ExposureBuffer 的着色器执行完毕后才写入；直方图只在首次使用前清零，
+        // 此后由 exposure.comp 在读取后清零，ExposureBuffer 也在首次使用前写入初始值
+        VkMemoryBarrier memoryBarrier = {.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                                         .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                                         .dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+                                                          VK_ACCESS_SHADER_WRITE_BIT};
+        if (!buffersInitialized) {
+            vkCmdFillBuffer(commandBuffer, histogram, 0, VK_WHOLE_SIZE, 0);
+            float initialValues[] = {1.f, 0.f};
+            vkCmdUpdateBuffer(commandBuffer, exposure, 0, sizeof initialValues, initialValues);
+            buffersInitialized = true;
+        }
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0,
+                             nullptr, 0, nullptr);
+        uint32_t pixelStride = std::max(params.pixelStride, 1u);
+        float log2LuminanceRange = std::max(params.maxLog2Luminance - params.minLog2Luminance,
+                                            std::numeric_limits<float>::epsilon());
+        struct {
+            VkExtent2D extent;
+            uint32_t pixelStride;
+            float minLog2Luminance;
+            float inverseLog2LuminanceRange;
+        } histogramPushConstants = {extent, pixelStride, params.minLog2Luminance,
+                                    1.f / log2LuminanceRange};
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, histogramKernel);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                histogramKernel.Layout(), 0, 1, &frame.histogramSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, histogramKernel.Layout(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                           sizeof histogramPushConstants, &histogramPushConstants);
+        uint32_t sampledWidth = (extent.width + pixelStride - 1) / pixelStride;
+        uint32_t sampledHeight = (extent.height + pixelStride - 1) / pixelStride;
+        vkCmdDispatch(commandBuffer, histogramKernel.GroupCount(sampledWidth, 0),
+                      histogramKernel.GroupCount(sampledHeight, 1), 1);
+        memoryBarrier = {.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                         .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+                         .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0,
+                             nullptr, 0, nullptr);
+        float exposurePushConstants[] = {
+            params.minLog2Luminance,
+            log2LuminanceRange,
+            std::clamp(params.lowPercentile, 0.f, 1.f),
+            std::clamp(params.highPercentile, 0.f, 1.f),
+            params.keyValue,
+            params.minExposure,
+            params.maxExposure,
+            1.f - std::exp(-std::max(deltaTime, 0.f) * params.adaptationSpeed)};
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, exposureKernel);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                exposureKernel.Layout(), 0, 1, &exposureSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, exposureKernel.Layout(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                           sizeof exposurePushConstants, exposurePushConstants);
+        vkCmdDispatch(commandBuffer, 1, 1, 1);
+        memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+                                      VK_ACCESS_UNIFORM_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+            &memoryBarrier, 0, nullptr, 0, nullptr);
+        return VK_SUCCESS;
+    }
+    // frameCount 为飞行中的帧数，directory 为编译好的 SPIR-V 文件所在的目录
+    VkResult Create(uint32_t frameCount, const char* directory = "shader")
+    {
+        graphicsBase& base = graphicsBase::Base();
+        useSubgroup = SubgroupSupported();
+        if (VkResult result = LoadKernel(directory, "luminance_histogram", histogramKernel))
+            return result;
+        if (VkResult result = LoadKernel(directory, "exposure", exposureKernel)) return result;
+        if (VkResult result = histogram.Create(256)) return result;
+        // 初始值由首次 CmdDispatch 写入
+        if (VkResult result = exposure.Create(2, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)) return result;
+        VkSamplerCreateInfo samplerCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+            .magFilter = VK_FILTER_NEAREST,
+            .minFilter = VK_FILTER_NEAREST,
+            .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+            .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+            .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+            .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+            .maxLod = VK_LOD_CLAMP_NONE};
+        if (VkResult result = samplerCache::Base().Get(samplerCreateInfo, sampler)) return result;
+        VkDescriptorPoolSize poolSizes[] = {
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frameCount},
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frameCount + 2}};
+        if (VkResult result = pool.Create(frameCount + 1, poolSizes)) return result;
+        std::vector<VkDescriptorSet> sets(frameCount + 1);
+        std::vector<VkDescriptorSetLayout> setLayouts(frameCount,
+                                                      histogramKernel.SetLayouts()[0]);
+        setLayouts.push_back(exposureKernel.SetLayouts()[0]);
+        if (VkResult result = pool.AllocateSets(sets, setLayouts)) return result;
+        frames.resize(frameCount);
+        for (uint32_t i = 0; i < frameCount; i++) frames[i].histogramSet = sets[i];
+        exposureSet = sets.back();
+        VkDescriptorBufferInfo bufferInfos[] = {{histogram, 0, VK_WHOLE_SIZE},
+                                                {exposure, 0, VK_WHOLE_SIZE}};
+        VkWriteDescriptorSet write = {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                                      .dstSet = exposureSet,
+                                      .dstBinding = 0,
+                                      .descriptorCount = 2,
+                                      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                      .pBufferInfo = bufferInfos};
+        vkUpdateDescriptorSets(base.Device(), 1, &write, 0, nullptr);
+        buffersInitialized = false;
+        return VK_SUCCESS;
+    }
+    // 在图形队列上测量 extent 大小的 R16G16B16A16_SFLOAT 图像上直方图与曝光的耗时，
+    // time 为 repeatCount 次测量的中位数，单位为毫秒
+    // 需要图形队列支持时间戳，会使用第 0 帧的描述符集，调用前该帧的命令须已执行完毕，
+    // 测量后曝光在下一次 CmdDispatch 时重新从 1 开始过渡
+    VkResult Benchmark(double& time, VkExtent2D extent = {3840, 2160}, uint32_t repeatCount = 10)
+    {
+        if (frames.empty()) {
+            std::cout << std::format("[ autoExposure ] ERROR\nNot created yet!\n");
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        graphicsBase& base = graphicsBase::Base();
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(base.PhysicalDevice(), &queueFamilyCount,
+                                                 nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilyPropertieses(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(base.PhysicalDevice(), &queueFamilyCount,
+                                                 queueFamilyPropertieses.data());
+        uint32_t timestampValidBits =
+            queueFamilyPropertieses[base.QueueFamilyIndex_Graphics()].timestampValidBits;
+        if (!timestampValidBits) {
+            std::cout << std::format(
+                "[ autoExposure ] ERROR\nThe graphics queue does not support timestamps!\n");
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        uint64_t timestampMask =
+            timestampValidBits == 64 ? UINT64_MAX : (uint64_t(1) << timestampValidBits) - 1;
+        repeatCount = std::max(repeatCount, 1u);
+        // 亮度在对数域内均匀分布于直方图的范围，使各个桶都有像素落入
+        size_t pixelCount = size_t(extent.width) * extent.height;
+        computeBuffer<uint64_t> stagingBuffer;
+        if (VkResult result = stagingBuffer.Create(pixelCount, 0, true)) return result;
+        void* pData;
+        if (VkResult result = stagingBuffer.Memory().MapMemory(pData, stagingBuffer.Size()))
+            return result;
+        std::mt19937 random(0);
+        std::uniform_real_distribution<float> log2Luminance(params.minLog2Luminance,
+                                                            params.maxLog2Luminance);
+        for (size_t i = 0; i < pixelCount; i++) {
+            float luminance = std::exp2(log2Luminance(random));
+            static_cast<uint64_t*>(pData)[i] =
+                glm::packHalf4x16({luminance, luminance, luminance, 1.f});
+        }
+        if (VkResult result = stagingBuffer.Memory().UnmapMemory(stagingBuffer.Size()))
+            return result;
+        computeImage hdrImage;
+        if (VkResult result =
+                hdrImage.Create(VK_FORMAT_R16G16B16A16_SFLOAT, extent, VK_IMAGE_USAGE_SAMPLED_BIT))
+            return result;
+        commandPool pool;
+        VkCommandBuffer commandBuffer;
+        queryPool queries;
+        fence fence;
+        if (VkResult result = pool.Create(base.QueueFamilyIndex_Graphics())) return result;
+        if (VkResult result = pool.AllocateBuffers({&commandBuffer, 1})) return result;
+        if (VkResult result = queries.Create(VK_QUERY_TYPE_TIMESTAMP, repeatCount * 2))
+            return result;
+        if (VkResult result = fence.Create()) return result;
+        VkCommandBufferBeginInfo beginInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        VkImageMemoryBarrier imageMemoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = hdrImage,
+            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &imageMemoryBarrier);
+        VkBufferImageCopy region = {.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+                                    .imageExtent = {extent.width, extent.height, 1}};
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, hdrImage,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &imageMemoryBarrier);
+        queries.CmdReset(commandBuffer, 0, repeatCount * 2);
+        // 首次执行用于预热缓存，不计时
+        VkResult result = CmdDispatch(commandBuffer, 0, hdrImage.View(), extent, 1.f / 60);
+        for (uint32_t i = 0; i < repeatCount && !result; i++) {
+            // 起始时间戳等到此前的计算全部结束
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, queries, i * 2);
+            result = CmdDispatch(commandBuffer, 0, hdrImage.View(), extent, 1.f / 60);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queries,
+                                i * 2 + 1);
+        }
+        if (VkResult endResult = vkEndCommandBuffer(commandBuffer); !result) result = endResult;
+        // 测试图像的视图即将销毁，其句柄值可能被重用，须使第 0 帧的描述符集在下次使用时重新写入
+        frames[0].imageView = VK_NULL_HANDLE;
+        buffersInitialized = false;
+        if (result) return result;
+        VkSubmitInfo submitInfo = {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                                   .commandBufferCount = 1,
+                                   .pCommandBuffers = &commandBuffer};
+        if (VkResult result = vkQueueSubmit(base.Queue_Graphics(), 1, &submitInfo, fence)) {
+            std::cout << std::format(
+                "[ autoExposure ] ERROR\nFailed to submit the command buffer!\nError code: {}\n",
+                int32_t(result));
+            return result;
+        }
+        if (VkResult result = fence.WaitAndReset()) return result;
+        std::vector<uint64_t> timestamps(repeatCount * 2);
+        if (VkResult result = queries.GetResults(0, timestamps)) return result;
+        std::vector<double> times(repeatCount);
+        double timestampPeriod = base.PhysicalDeviceProperties().limits.timestampPeriod;
+        for (uint32_t i = 0; i < repeatCount; i++)
+            times[i] = ((timestamps[i * 2 + 1] - timestamps[i * 2]) & timestampMask) *
+                       timestampPeriod / 1e6;
+        std::ranges::nth_element(times, times.begin() + repeatCount / 2);
+        time = times[repeatCount / 2];
+        return VK_SUCCESS;
+    }
+    // Static Function
+    // 设备的计算着色器是否支持子组的 basic、vote、arithmetic 运算（Vulkan 1.1）
+    static bool SubgroupSupported()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        if (base.DeviceApiVersion() < VK_API_VERSION_1_1) return false;
+        VkPhysicalDeviceSubgroupProperties subgroupProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES};
+        VkPhysicalDeviceProperties2 properties2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &subgroupProperties};
+        vkGetPhysicalDeviceProperties2(base.PhysicalDevice(), &properties2);
+        VkSubgroupFeatureFlags requiredOperations = VK_SUBGROUP_FEATURE_BASIC_BIT |
+                                                    VK_SUBGROUP_FEATURE_VOTE_BIT |
+                                                    VK_SUBGROUP_FEATURE_ARITHMETIC_BIT;
+        return subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT &&
+               (subgroupProperties.supportedOperations & requiredOperations) == requiredOperations;
+    }
+};
+}  // namespace vulkan
@@ -0,0 +1,366 @@
+#pragma once
+#include "VKShaderReflection.h"
+
+namespace vulkan {
+// 计算着色器工作组大小的自动调优：最优的工作组大小与子组大小因设备而异
+// 1. RegisterKernel 登记内核，其工作组大小须由特化常量决定（GLSL 中的 local_size_x_id 等），
+//    各维对应的 constant_id 由 shaderReflection 自动取得
+// 2. Tune 在计算队列上以 GPU 时间戳逐个测量候选的工作组大小（设备支持 subgroupSizeControl 时
+//    也测量各子组大小），取多次测量的中位数，保留最快者
+// 3. 结果按 vendorID、deviceID、driverVersion 及内核代码的哈希值保存，SaveResults 写入文件后，
+//    之后启动时 LoadResults 即可直接取得调优结果，Tune 跳过已有结果的内核
+// Tune 会阻塞至测量结束，且会占用计算队列，宜在启动时、其他线程尚未提交命令前调用
+class computeAutotuner {
+public:
+    struct variant {
+        uint32_t localSize[3];
+        uint32_t subgroupSize;  // 为 0 表示不指定
+        bool operator==(const variant&) const = default;
+    };
+    // 在已绑定管线的命令缓冲区中绑定描述符、推送常量，按 localSize 算出工作组数并调用 vkCmdDispatch
+    // 调优时会被多次调用，须使每次调用处理相同的数据量
+    using record_t = std::function<void(VkCommandBuffer commandBuffer, const variant& variant)>;
+
+private:
+    struct kernel {
+        std::span<const uint32_t> code;
+        uint64_t codeHash;
+        VkPipelineLayout layout;
+        uint32_t specIds[3];  // 各维对应的 constant_id，为 UINT32_MAX 表示该维不调
+        variant defaultVariant;
+        std::vector<variant> candidates;
+        record_t record;
+    };
+    struct result {
+        variant best;
+        double time;  // 单位为毫秒
+    };
+    // 设备的 vendorID、deviceID、driverVersion，内核代码的哈希值，内核名称
+    using resultKey_t = std::tuple<uint32_t, uint32_t, uint32_t, uint64_t, std::string>;
+    std::map<std::string, kernel> kernels;
+    std::map<resultKey_t, result> results;
+    uint32_t repeatCount = 5;
+
+    //--------------------
+    resultKey_t ResultKey(const std::string& name, const kernel& kernel) const
+    {
+        const VkPhysicalDeviceProperties& properties =
+            graphicsBase::Base().PhysicalDeviceProperties();
+        return {properties.vendorID, properties.deviceID, properties.driverVersion,
+                kernel.codeHash, name};
+    }
+    // 未指定候选时，按可调的维数生成常见的工作组大小，并按设备的限制筛选
+    std::vector<variant> Candidates(const kernel& kernel) const
+    {
+        const VkPhysicalDeviceLimits& limits =
+            graphicsBase::Base().PhysicalDeviceProperties().limits;
+        std::vector<variant> candidates = kernel.candidates;
+        if (candidates.empty()) {
+            constexpr uint32_t sizes[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
+            bool tuneY = kernel.specIds[1] != UINT32_MAX;
+            for (auto x : sizes)
+                for (auto y : sizes) {
+                    if (!tuneY && y > 1) break;
+                    // 不调的维取默认的大小，Z 总是不调
+                    uint32_t localY = tuneY ? y : kernel.defaultVariant.localSize[1];
+                    uint32_t localZ = kernel.defaultVariant.localSize[2];
+                    uint64_t invocationCount = uint64_t(x) * localY * localZ;
+                    // 太小的工作组填不满一个子组，不值得测量
+                    if (invocationCount < 32 || (tuneY && (x < 4 || y < 2))) continue;
+                    if (invocationCount > limits.maxComputeWorkGroupInvocations) continue;
+                    if (kernel.specIds[0] == UINT32_MAX && x != kernel.defaultVariant.localSize[0])
+                        continue;
+                    candidates.push_back({{x, localY, localZ}});
+                }
+            candidates.push_back(kernel.defaultVariant);
+        }
+        std::erase_if(candidates, [&limits](const variant& i) {
+            return i.localSize[0] > limits.maxComputeWorkGroupSize[0] ||
+                   i.localSize[1] > limits.maxComputeWorkGroupSize[1] ||
+                   i.localSize[2] > limits.maxComputeWorkGroupSize[2] ||
+                   uint64_t(i.localSize[0]) * i.localSize[1] * i.localSize[2] >
+                       limits.maxComputeWorkGroupInvocations;
+        });
+        // 设备允许在计算着色器中指定子组大小时，每个候选再按各子组大小展开
+        if (!graphicsBase::Base().PhysicalDeviceVulkan13Features().subgroupSizeControl)
+            return candidates;
+        VkPhysicalDeviceVulkan13Properties properties13 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_PROPERTIES};
+        VkPhysicalDeviceProperties2 properties2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &properties13};
+        vkGetPhysicalDeviceProperties2(graphicsBase::Base().PhysicalDevice(), &properties2);
+        if (!(properties13.requiredSubgroupSizeStages & VK_SHADER_STAGE_COMPUTE_BIT) ||
+            properties13.minSubgroupSize == properties13.maxSubgroupSize)
+            return candidates;
+        std::vector<variant> expanded;
+        for (auto& i : candidates) {
+            expanded.push_back(i);
+            if (i.subgroupSize) continue;
+            uint32_t invocationCount = i.localSize[0] * i.localSize[1] * i.localSize[2];
+            for (uint32_t j = properties13.minSubgroupSize; j <= properties13.maxSubgroupSize;
+                 j *= 2)
+                if (invocationCount <= properties13.maxComputeWorkgroupSubgroups * j)
+                    expanded.push_back({{i.localSize[0], i.localSize[1], i.localSize[2]}, j});
+        }
+        return expanded;
+    }
+    VkResult CreatePipeline(const kernel& kernel, const variant& variant, pipeline& pipeline,
+                            VkPipelineCache cache) const
+    {
+        VkShaderModuleCreateInfo moduleCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .codeSize = kernel.code.size_bytes(),
+            .pCode = kernel.code.data()};
+        VkShaderModule module;
+        VkDevice device = graphicsBase::Base().Device();
+        if (VkResult result = vkCreateShaderModule(device, &moduleCreateInfo, nullptr, &module)) {
+            std::cout << std::format(
+                "[ computeAutotuner ] ERROR\nFailed to create a shader module!\nError code: {}\n",
+                int32_t(result));
+            return result;
+        }
+        VkSpecializationMapEntry mapEntries[3];
+        uint32_t mapEntryCount = 0;
+        for (uint32_t i = 0; i < 3; i++)
+            if (kernel.specIds[i] != UINT32_MAX)
+                mapEntries[mapEntryCount++] = {kernel.specIds[i], uint32_t(i * sizeof(uint32_t)),
+                                               sizeof(uint32_t)};
+        VkSpecializationInfo specializationInfo = {.mapEntryCount = mapEntryCount,
+                                                   .pMapEntries = mapEntries,
+                                                   .dataSize = sizeof variant.localSize,
+                                                   .pData = variant.localSize};
+        VkPipelineShaderStageRequiredSubgroupSizeCreateInfo requiredSubgroupSizeCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_REQUIRED_SUBGROUP_SIZE_CREATE_INFO,
+            .requiredSubgroupSize = variant.subgroupSize};
+        VkComputePipelineCreateInfo createInfo = {
+            .stage = {.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                      .pNext = variant.subgroupSize ? &requiredSubgroupSizeCreateInfo : nullptr,
+                      .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                      .module = module,
+                      .pName = "main",
+                      .pSpecializationInfo = &specializationInfo},
+            .layout = kernel.layout};
+        VkResult result = pipeline.Create(createInfo, cache);
+        vkDestroyShaderModule(device, module, nullptr);
+        return result;
+    }
+    // 测量一个候选，time 为 repeatCount 次测量的中位数，单位为毫秒
+    VkResult Measure(const kernel& kernel, const variant& variant, VkCommandBuffer commandBuffer,
+                     const queryPool& queries, const fence& fence, uint64_t timestampMask,
+                     double& time) const
+    {
+        pipeline pipeline;
+        if (VkResult result = CreatePipeline(kernel, variant, pipeline, VK_NULL_HANDLE))
+            return result;
+        // 前后两次执行之间的屏障，使每次测量只包含一次执行
+        VkMemoryBarrier memoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+        auto Barrier = [&] {
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0,
+                                 nullptr, 0, nullptr);
+        };
+        VkCommandBufferBeginInfo beginInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        queries.CmdReset(commandBuffer, 0, repeatCount * 2);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        // 首次执行用于预热缓存，不计时
+        kernel.record(commandBuffer, variant);
+        for (uint32_t i = 0; i < repeatCount; i++) {
+            Barrier();
+            // 在计算着色器阶段写入，使起始时间戳等到上一次执行结束，TOP_OF_PIPE 不受屏障约束
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, queries,
+                                i * 2);
+            kernel.record(commandBuffer, variant);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queries,
+                                i * 2 + 1);
+        }
+        if (VkResult result = vkEndCommandBuffer(commandBuffer)) return result;
+        graphicsBase& base = graphicsBase::Base();
+        VkQueue queue = base.Queue_Compute() ? base.Queue_Compute() : base.Queue_Graphics();
+        VkSubmitInfo submitInfo = {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                                   .commandBufferCount = 1,
+                                   .pCommandBuffers = &commandBuffer};
+        if (VkResult result = vkQueueSubmit(queue, 1, &submitInfo, fence)) {
+            std::cout << std::format(
+                "[ computeAutotuner ] ERROR\nFailed to submit the command buffer!\nError code: "
+                "{}\n",
+                int32_t(result));
+            return result;
+        }
+        if (VkResult result = fence.WaitAndReset()) return result;
+        std::vector<uint64_t> timestamps(repeatCount * 2);
+        if (VkResult result = queries.GetResults(0, timestamps)) return result;
+        std::vector<double> times(repeatCount);
+        double timestampPeriod = base.PhysicalDeviceProperties().limits.timestampPeriod;
+        for (uint32_t i = 0; i < repeatCount; i++)
+            times[i] = ((timestamps[i * 2 + 1] - timestamps[i * 2]) & timestampMask) *
+                       timestampPeriod / 1e6;
+        std::ranges::nth_element(times, times.begin() + repeatCount / 2);
+        time = times[repeatCount / 2];
+        return VK_SUCCESS;
+    }
+
+public:
+    // Getter
+    // 已调优的内核返回其结果，否则返回着色器中的默认工作组大小
+    variant Variant(const std::string& name) const
+    {
+        auto it = kernels.find(name);
+        if (it == kernels.end()) return {};
+        auto result = results.find(ResultKey(name, it->second));
+        return result == results.end() ? it->second.defaultVariant : result->second.best;
+    }
+    bool Tuned(const std::string& name) const
+    {
+        auto it = kernels.find(name);
+        return it != kernels.end() && results.contains(ResultKey(name, it->second));
+    }
+    // Const Function
+    // 以调优所得的（或默认的）工作组大小创建计算管线
+    VkResult CreatePipeline(const std::string& name, pipeline& pipeline,
+                            VkPipelineCache cache = VK_NULL_HANDLE) const
+    {
+        auto it = kernels.find(name);
+        if (it == kernels.end()) {
+            std::cout << std::format("[ computeAutotuner ] ERROR\nUnknown kernel: {}\n", name);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        return CreatePipeline(it->second, Variant(name), pipeline, cache);
+    }
+    // 写入所有设备的调优结果，每行一个内核
+    VkResult SaveResults(const char* filepath) const
+    {
+        std::ofstream file(filepath);
+        if (!file) {
+            std::cout << std::format("[ computeAutotuner ] ERROR\nFailed to open the file: {}\n",
+                                     filepath);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        file << "# vendorID deviceID driverVersion codeHash name localSize subgroupSize time\n";
+        for (auto& [key, result] : results) {
+            auto& [vendorID, deviceID, driverVersion, codeHash, name] = key;
+            const variant& best = result.best;
+            file << std::format("{} {} {} {} ", vendorID, deviceID, driverVersion, codeHash)
+                 << std::quoted(name)
+                 << std::format(" {} {} {} {} {}\n", best.localSize[0], best.localSize[1],
+                                best.localSize[2], best.subgroupSize, result.time);
+        }
+        return file ? VK_SUCCESS : VK_ERROR_INITIALIZATION_FAILED;
+    }
+    // Non-const Function
+    // 每个候选测量的次数，取中位数
+    void RepeatCount(uint32_t count)
+    {
+        repeatCount = std::max(count, 1u);
+    }
+    // code 须在 computeAutotuner 的生命周期内保持有效，如 shaderModuleRegistry::Base().Code()
+    // candidates 为空时自动生成；layout 须与 record 所绑定的资源相符
+    VkResult RegisterKernel(const std::string& name, std::span<const uint32_t> code,
+                            VkPipelineLayout layout, record_t record,
+                            std::vector<variant> candidates = {})
+    {
+        spirvReflection reflection;
+        if (VkResult result = shaderReflection::Base().Reflect(code, reflection)) return result;
+        if (reflection.stage != VK_SHADER_STAGE_COMPUTE_BIT ||
+            std::ranges::all_of(reflection.workgroupSizeSpecIds,
+                                [](uint32_t i) { return i == UINT32_MAX; })) {
+            std::cout << std::format(
+                "[ computeAutotuner ] ERROR\nKernel {} is not a compute shader with "
+                "specializable local size!\n",
+                name);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        kernel& kernel = kernels[name];
+        kernel = {.code = code,
+                  .codeHash = HashSpirv(code),
+                  .layout = layout,
+                  .defaultVariant = {{reflection.workgroupSize[0], reflection.workgroupSize[1],
+                                      reflection.workgroupSize[2]}},
+                  .candidates = std::move(candidates),
+                  .record = std::move(record)};
+        std::ranges::copy(reflection.workgroupSizeSpecIds, kernel.specIds);
+        return VK_SUCCESS;
+    }
+    // 测量所有尚无当前设备结果的内核，retune 为 true 时重新测量全部内核
+    VkResult Tune(bool retune = false)
+    {
+        graphicsBase& base = graphicsBase::Base();
+        uint32_t queueFamilyIndex = base.Queue_Compute() ? base.QueueFamilyIndex_Compute()
+                                                         : base.QueueFamilyIndex_Graphics();
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(base.PhysicalDevice(), &queueFamilyCount,
+                                                 nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilyPropertieses(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(base.PhysicalDevice(), &queueFamilyCount,
+                                                 queueFamilyPropertieses.data());
+        uint32_t timestampValidBits = queueFamilyPropertieses[queueFamilyIndex].timestampValidBits;
+        if (!timestampValidBits) {
+            std::cout << std::format(
+                "[ computeAutotuner ] ERROR\nThe compute queue does not support timestamps!\n");
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        uint64_t timestampMask =
+            timestampValidBits == 64 ? UINT64_MAX : (uint64_t(1) << timestampValidBits) - 1;
+        commandPool pool;
+        VkCommandBuffer commandBuffer;
+        queryPool queries;
+        fence fence;
+        if (VkResult result =
+                pool.Create(queueFamilyIndex, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT))
+            return result;
+        if (VkResult result = pool.AllocateBuffers({&commandBuffer, 1})) return result;
+        if (VkResult result = queries.Create(VK_QUERY_TYPE_TIMESTAMP, repeatCount * 2))
+            return result;
+        if (VkResult result = fence.Create()) return result;
+        for (auto& [name, kernel] : kernels) {
+            resultKey_t key = ResultKey(name, kernel);
+            if (!retune && results.contains(key)) continue;
+            result best = {kernel.defaultVariant, std::numeric_limits<double>::infinity()};
+            for (auto& i : Candidates(kernel)) {
+                double time;
+                if (Measure(kernel, i, commandBuffer, queries, fence, timestampMask, time))
+                    continue;
+                if (time < best.time) best = {i, time};
+            }
+            if (std::isinf(best.time)) {
+                std::cout << std::format(
+                    "[ computeAutotuner ] ERROR\nNo variant of kernel {} could be measured!\n",
+                    name);
+                continue;
+            }
+            results[key] = best;
+        }
+        return VK_SUCCESS;
+    }
+    // 读取 SaveResults 写入的文件，与已有结果合并，文件中的结果优先
+    VkResult LoadResults(const char* filepath)
+    {
+        std::ifstream file(filepath);
+        if (!file) return VK_ERROR_INITIALIZATION_FAILED;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream stream(line);
+            uint32_t vendorID, deviceID, driverVersion;
+            uint64_t codeHash;
+            std::string name;
+            result result;
+            stream >> vendorID >> deviceID >> driverVersion >> codeHash >> std::quoted(name) >>
+                result.best.localSize[0] >> result.best.localSize[1] >>
+                result.best.localSize[2] >> result.best.subgroupSize >> result.time;
+            if (!stream) {
+                std::cout << std::format(
+                    "[ computeAutotuner ] ERROR\nMalformed line in {}: {}\n", filepath, line);
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+            results[{vendorID, deviceID, driverVersion, codeHash, std::move(name)}] = result;
+        }
+        return VK_SUCCESS;
+    }
+};
+}  // namespace vulkan
@@ -1,3 +1,4 @@
+#pragma once
 #include "EasyVKStart.h"
 
 namespace vulkan {
@@ -11,13 +12,25 @@ class graphicsBase {
     VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties;  // 物理设备内存属性
     std::vector<VkPhysicalDevice> availablePhysicalDevices;           // 可用的物理设备
 
+    VkPhysicalDeviceFeatures physicalDeviceFeatures;  // 物理设备特性
+    VkPhysicalDeviceVulkan11Features physicalDeviceVulkan11Features = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES};  // Vulkan 1.1 特性
+    VkPhysicalDeviceVulkan12Features physicalDeviceVulkan12Features = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};  // Vulkan 1.2 特性
+    VkPhysicalDeviceVulkan13Features physicalDeviceVulkan13Features = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES};  // Vulkan 1.3 特性
+    void* pNext_physicalDeviceFeatures = nullptr;  // 扩展的特性结构体链，由各扩展自行添加
+    bool robustAccessEnabled = false;              // 是否保留越界访问检查等有开销的特性
+
     VkDevice device;                                                   // 逻辑设备
     uint32_t queueFamilyIndex_graphics = VK_QUEUE_FAMILY_IGNORED;      // 图形 队列族 idx
     uint32_t queueFamilyIndex_presentation = VK_QUEUE_FAMILY_IGNORED;  // 呈现 队列族 idx
     uint32_t queueFamilyIndex_compute = VK_QUEUE_FAMILY_IGNORED;       // 计算 队列组 idx
+    uint32_t queueFamilyIndex_transfer = VK_QUEUE_FAMILY_IGNORED;      // 传输 队列族 idx
     VkQueue queue_graphics;                                            // 图形 队列
     VkQueue queue_presentation;                                        // 呈现 队列
     VkQueue queue_compute;                                             // 计算 队列
+    VkQueue queue_transfer;                                            // 传输 队列
 
     VkSurfaceKHR surface;                                     // surface
     std::vector<VkSurfaceFormatKHR> availableSurfaceFormats;  // 可用的 surface 格式
@@ -43,6 +56,11 @@ class graphicsBase {
     graphicsBase() = default;
     graphicsBase(graphicsBase&&) = delete;
     ~graphicsBase()
+    {
+        Destroy();
+    }
+    // 销毁交换链、逻辑设备与实例，销毁前执行回调；不析构成员，以便 Terminate 后再次初始化
+    void Destroy()
     {
         if (!instance) return;
         if (device) {
@@ -132,6 +150,29 @@ class graphicsBase {
         std::cout << "ic : " << queueFamilyIndex_compute << std::endl;
         return VK_SUCCESS;
     }
+    // 选择用于上传数据的队列族，优先级：仅支持传输的队列族 > 不支持图形的队列族 > 图形队列族
+    // 专用的传输队列族通常对应 DMA 引擎，可与图形队列上的渲染并行执行
+    uint32_t GetTransferQueueFamilyIndex() const
+    {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilyPropertieses(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount,
+                                                 queueFamilyPropertieses.data());
+        uint32_t withoutGraphics = VK_QUEUE_FAMILY_IGNORED;
+        for (uint32_t i = 0; i < queueFamilyCount; i++) {
+            VkQueueFlags flags = queueFamilyPropertieses[i].queueFlags;
+            // 支持图形或计算的队列族隐含支持传输，未必置位 VK_QUEUE_TRANSFER_BIT
+            if (!(flags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+                continue;
+            if (!(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) return i;
+            if (!(flags & VK_QUEUE_GRAPHICS_BIT) && withoutGraphics == VK_QUEUE_FAMILY_IGNORED)
+                withoutGraphics = i;
+        }
+        if (withoutGraphics != VK_QUEUE_FAMILY_IGNORED) return withoutGraphics;
+        return queueFamilyIndex_graphics != VK_QUEUE_FAMILY_IGNORED ? queueFamilyIndex_graphics
+                                                                    : queueFamilyIndex_compute;
+    }
     VkResult CreateSwapchain_Internal()
     {
         // 创建 swapchain
@@ -228,6 +269,55 @@ class graphicsBase {
             "vkCreateDebugUtilsMessengerEXT!\n");
         return VK_RESULT_MAX_ENUM;
     }
+    // 查询物理设备支持的特性，创建逻辑设备时开启其中除 DisableCostlyFeatures 所关闭者外的特性
+    // 物理设备支持 Vulkan 1.1 以上时，用 vkGetPhysicalDeviceFeatures2 一并查询各版本及扩展的特性
+    // 返回 false 表示只能使用 VkPhysicalDeviceFeatures
+    bool GetPhysicalDeviceFeatures(VkPhysicalDeviceFeatures2& physicalDeviceFeatures2)
+    {
+        uint32_t deviceApiVersion = DeviceApiVersion();
+        if (deviceApiVersion < VK_API_VERSION_1_1) {
+            vkGetPhysicalDeviceFeatures(physicalDevice, &physicalDeviceFeatures);
+            DisableCostlyFeatures(physicalDeviceFeatures);
+            return false;
+        }
+        // 依次链接 1.1 -> 1.2 -> 1.3 -> 扩展的特性结构体
+        void** ppNext = &physicalDeviceFeatures2.pNext;
+        auto Link = [&ppNext](auto& next) {
+            *ppNext = &next;
+            ppNext = &next.pNext;
+        };
+        physicalDeviceFeatures2 = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+        physicalDeviceVulkan11Features.pNext = nullptr;
+        physicalDeviceVulkan12Features.pNext = nullptr;
+        physicalDeviceVulkan13Features.pNext = nullptr;
+        // VkPhysicalDeviceVulkan11Features 始于 Vulkan 1.2
+        if (deviceApiVersion >= VK_API_VERSION_1_2) {
+            Link(physicalDeviceVulkan11Features);
+            Link(physicalDeviceVulkan12Features);
+        }
+        if (deviceApiVersion >= VK_API_VERSION_1_3) Link(physicalDeviceVulkan13Features);
+        *ppNext = pNext_physicalDeviceFeatures;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &physicalDeviceFeatures2);
+        DisableCostlyFeatures(physicalDeviceFeatures2.features);
+        physicalDeviceFeatures = physicalDeviceFeatures2.features;
+        return true;
+    }
+    // 关闭有运行时开销、且本框架不需要的特性：越界访问检查与用于捕获回放的地址固定
+    // 调用 EnableRobustAccess 后保留越界访问检查
+    void DisableCostlyFeatures(VkPhysicalDeviceFeatures& features)
+    {
+        if (!robustAccessEnabled) {
+            features.robustBufferAccess = VK_FALSE;
+            physicalDeviceVulkan13Features.robustImageAccess = VK_FALSE;
+        }
+        physicalDeviceVulkan12Features.bufferDeviceAddressCaptureReplay = VK_FALSE;
+        physicalDeviceVulkan12Features.bufferDeviceAddressMultiDevice = VK_FALSE;
+        for (auto i = reinterpret_cast<VkBaseOutStructure*>(pNext_physicalDeviceFeatures); i;
+             i = i->pNext)
+            if (i->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT)
+                reinterpret_cast<VkPhysicalDeviceDescriptorBufferFeaturesEXT*>(i)
+                    ->descriptorBufferCaptureReplay = VK_FALSE;
+    }
     // Static Function
     static void AddLayerOrExtension(std::vector<const char*>& container, const char* name)
     {
@@ -264,6 +354,29 @@ public:
     {
         return physicalDeviceMemoryProperties;
     }
+    // 实例与物理设备所支持版本中的较低者，物理设备的属性在 CreateDevice 中获取
+    uint32_t DeviceApiVersion() const
+    {
+        return std::min(apiVersion, physicalDeviceProperties.apiVersion);
+    }
+    // 以下特性在 CreateDevice 中获取，即逻辑设备上开启的特性
+    // 除越界访问检查等有开销的特性（见 DisableCostlyFeatures）外，支持的特性都会被开启
+    constexpr const VkPhysicalDeviceFeatures& PhysicalDeviceFeatures() const
+    {
+        return physicalDeviceFeatures;
+    }
+    constexpr const VkPhysicalDeviceVulkan11Features& PhysicalDeviceVulkan11Features() const
+    {
+        return physicalDeviceVulkan11Features;
+    }
+    constexpr const VkPhysicalDeviceVulkan12Features& PhysicalDeviceVulkan12Features() const
+    {
+        return physicalDeviceVulkan12Features;
+    }
+    constexpr const VkPhysicalDeviceVulkan13Features& PhysicalDeviceVulkan13Features() const
+    {
+        return physicalDeviceVulkan13Features;
+    }
     VkPhysicalDevice AvailablePhysicalDevice(uint32_t index) const
     {
         return availablePhysicalDevices[index];
@@ -301,6 +414,15 @@ public:
     {
         return queue_compute;
     }
+    // 传输队列可能与图形或计算队列是同一个 VkQueue，此时需与其一同进行外部同步
+    uint32_t QueueFamilyIndex_Transfer() const
+    {
+        return queueFamilyIndex_transfer;
+    }
+    VkQueue Queue_Transfer() const
+    {
+        return queue_transfer;
+    }
 
     VkSurfaceKHR Surface() const
     {
@@ -508,6 +630,25 @@ public:
     {
         AddLayerOrExtension(deviceExtensions, extensionName);
     }
+    // 在 CreateDevice 前调用，开启 robustBufferAccess 与 robustImageAccess（若支持）
+    // 默认关闭，越界访问检查会增加每次缓冲区与图像访问的开销，一般只在调试时开启
+    void EnableRobustAccess(bool enable = true)
+    {
+        robustAccessEnabled = enable;
+    }
+    // 在 CreateDevice 前添加扩展的特性结构体，如 VkPhysicalDeviceDescriptorBufferFeaturesEXT
+    // 结构体需已填写 sType，且在逻辑设备的生命周期内保持有效
+    // CreateDevice 会查询并开启其中所有支持的特性
+    // 不要添加已被 Vulkan11/12/13Features 包含的结构体，如 VkPhysicalDevice16BitStorageFeatures
+    template <typename T>
+    void AddNextStructure_PhysicalDeviceFeatures(T& next)
+    {
+        for (auto i = reinterpret_cast<VkBaseOutStructure*>(pNext_physicalDeviceFeatures); i;
+             i = i->pNext)
+            if (i == reinterpret_cast<VkBaseOutStructure*>(&next)) return;
+        next.pNext = pNext_physicalDeviceFeatures;
+        pNext_physicalDeviceFeatures = &next;
+    }
     VkResult GetPhysicalDevices()
     {
         uint32_t deviceCount;
@@ -571,21 +712,28 @@ public:
             queueFamilyIndex_compute = enableComputeQueue ? ic : VK_QUEUE_FAMILY_IGNORED;
         }
         physicalDevice = availablePhysicalDevices[deviceIndex];
+        // 获取物理设备属性，其中的 apiVersion 决定了能使用哪些版本的功能
+        // 在此获取，以便在 CreateDevice 前根据 DeviceApiVersion() 决定要添加的扩展
+        vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
         return VK_SUCCESS;
     }
     VkResult CreateDevice(VkDeviceCreateFlags flags = 0)
     {
         float queuePriority = 1.f;
-        VkDeviceQueueCreateInfo queueCreateInfos[3] = {
+        VkDeviceQueueCreateInfo queueCreateInfos[4] = {
             {.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,  // 指示结构体类型
              .queueCount = 1,  // 该队列族索引下，要创建的队列个数，需小于该队列族下的队列数量
              .pQueuePriorities = &queuePriority},  // 队列优先级，范围 [0,1]，1 优先级最高
             {.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
              .queueCount = 1,
              .pQueuePriorities = &queuePriority},
+            {.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+             .queueCount = 1,
+             .pQueuePriorities = &queuePriority},
             {.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
              .queueCount = 1,
              .pQueuePriorities = &queuePriority}};
+        queueFamilyIndex_transfer = GetTransferQueueFamilyIndex();
         uint32_t queueCreateInfoCount = 0;
         if (queueFamilyIndex_graphics != VK_QUEUE_FAMILY_IGNORED)
             queueCreateInfos[queueCreateInfoCount++].queueFamilyIndex =
@@ -598,18 +746,26 @@ public:
             queueFamilyIndex_compute != queueFamilyIndex_graphics &&
             queueFamilyIndex_compute != queueFamilyIndex_presentation)
             queueCreateInfos[queueCreateInfoCount++].queueFamilyIndex = queueFamilyIndex_compute;
-        VkPhysicalDeviceFeatures physicalDeviceFeatures;
+        if (queueFamilyIndex_transfer != VK_QUEUE_FAMILY_IGNORED &&
+            queueFamilyIndex_transfer != queueFamilyIndex_graphics &&
+            queueFamilyIndex_transfer != queueFamilyIndex_presentation &&
+            queueFamilyIndex_transfer != queueFamilyIndex_compute)
+            queueCreateInfos[queueCreateInfoCount++].queueFamilyIndex = queueFamilyIndex_transfer;
         // 获取物理设备支持的特性
-        vkGetPhysicalDeviceFeatures(physicalDevice, &physicalDeviceFeatures);
+        VkPhysicalDeviceFeatures2 physicalDeviceFeatures2;
+        bool useFeatures2 = GetPhysicalDeviceFeatures(physicalDeviceFeatures2);
         VkDeviceCreateInfo deviceCreateInfo = {
             .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,  // 指示结构体类型
+            // 使用 VkPhysicalDeviceFeatures2 时，特性经由 pNext 指定，pEnabledFeatures 须为空
+            .pNext = useFeatures2 ? &physicalDeviceFeatures2 : nullptr,
             .flags = flags,
             .queueCreateInfoCount = queueCreateInfoCount,  // 队列创建信息的个数
             .pQueueCreateInfos = queueCreateInfos,         // 队列创建信息结构体首地址
             .enabledExtensionCount =
                 uint32_t(deviceExtensions.size()),               // （已弃用）设备级 layer 个数
             .ppEnabledExtensionNames = deviceExtensions.data(),  // （已弃用）设备级 layer 首地址
-            .pEnabledFeatures = &physicalDeviceFeatures};        // 指明需要开启哪些特性
+            .pEnabledFeatures =
+                useFeatures2 ? nullptr : &physicalDeviceFeatures};  // 指明需要开启哪些特性
         // 创建逻辑设备
         if (VkResult result = vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device)) {
             std::cout << std::format(
@@ -625,18 +781,67 @@ public:
             vkGetDeviceQueue(device, queueFamilyIndex_presentation, 0, &queue_presentation);
         if (queueFamilyIndex_compute != VK_QUEUE_FAMILY_IGNORED)
             vkGetDeviceQueue(device, queueFamilyIndex_compute, 0, &queue_compute);
+        if (queueFamilyIndex_transfer != VK_QUEUE_FAMILY_IGNORED)
+            vkGetDeviceQueue(device, queueFamilyIndex_transfer, 0, &queue_transfer);
 
         // 逻辑设备创建成功，说明物理设备已确定、不会变更，所以在这里获取物理设备的其他属性
-        // 获取物理设备属性
-        vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
         // 获取物理设备内存属性
         vkGetPhysicalDeviceMemoryProperties(physicalDevice, &physicalDeviceMemoryProperties);
         std::cout << std::format("Renderer: {}\n", physicalDeviceProperties.deviceName);
+        // 创建逻辑设备时的回调函数
+        ExecuteCallbacks(callbacks_createDevice);
         return VK_SUCCESS;
     }
+    // 在 memoryTypeBits 允许的内存类型中，找到具有 desiredMemoryProperties 全部属性的内存类型
+    // 找不到则返回 UINT32_MAX
+    uint32_t MemoryTypeIndex(uint32_t memoryTypeBits,
+                             VkMemoryPropertyFlags desiredMemoryProperties) const
+    {
+        for (uint32_t i = 0; i < physicalDeviceMemoryProperties.memoryTypeCount; i++)
+            if (memoryTypeBits & 1 << i &&
+                (physicalDeviceMemoryProperties.memoryTypes[i].propertyFlags &
+                 desiredMemoryProperties) == desiredMemoryProperties)
+                return i;
+        return UINT32_MAX;
+    }
+    // 检查物理设备是否支持 extensionsToCheck 中的扩展，不支持的扩展会被置为 nullptr
     VkResult CheckDeviceExtensions(std::span<const char*> extensionsToCheck,
                                    const char* layerName = nullptr) const
     {
+        uint32_t extensionCount;
+        std::vector<VkExtensionProperties> availableExtensions;
+        if (VkResult result = vkEnumerateDeviceExtensionProperties(physicalDevice, layerName,
+                                                                   &extensionCount, nullptr)) {
+            layerName
+                ? std::cout << std::format(
+                      "[ graphicsBase ] ERROR\nFailed to get the count of device "
+                      "extensions!\nLayer name:{}\n",
+                      layerName)
+                : std::cout << std::format(
+                      "[ graphicsBase ] ERROR\nFailed to get the count of device extensions!\n");
+            return result;
+        }
+        if (extensionCount) {
+            availableExtensions.resize(extensionCount);
+            if (VkResult result = vkEnumerateDeviceExtensionProperties(
+                    physicalDevice, layerName, &extensionCount, availableExtensions.data())) {
+                std::cout << std::format(
+                    "[ graphicsBase ] ERROR\nFailed to enumerate device extension "
+                    "properties!\nError code: {}\n",
+                    int32_t(result));
+                return result;
+            }
+            for (auto& i : extensionsToCheck) {
+                bool found = false;
+                for (auto& j : availableExtensions)
+                    if (!strcmp(i, j.extensionName)) {
+                        found = true;
+                        break;
+                    }
+                if (!found) i = nullptr;
+            }
+        } else
+            for (auto& i : extensionsToCheck) i = nullptr;
         return VK_SUCCESS;
     }
     void DeviceExtensions(const std::vector<const char*>& extensionNames)
@@ -811,9 +1016,11 @@ public:
     }
 
     //                    After Initialization
+    // 应在 main 返回前调用：各子系统的单例是函数内的静态对象，先于 graphicsBase 析构，
+    // 若等到 graphicsBase 析构时才执行回调，回调访问的单例已不存在
     void Terminate()
     {
-        this->~graphicsBase();
+        Destroy();
         instance = VK_NULL_HANDLE;
         physicalDevice = VK_NULL_HANDLE;
         device = VK_NULL_HANDLE;
@@ -912,4 +1119,954 @@ public:
     }
 };
 inline graphicsBase graphicsBase::singleton;
+
+class fence {
+    VkFence handle = VK_NULL_HANDLE;
+
+public:
+    fence() = default;
+    // 若需在第一次等待前就处于置位状态（如每帧开头等待上一轮的 fence），flags 传入
+    // VK_FENCE_CREATE_SIGNALED_BIT
+    fence(VkFenceCreateFlags flags)
+    {
+        Create(flags);
+    }
+    fence(fence&& other) noexcept
+    {
+        handle = other.handle;
+        other.handle = VK_NULL_HANDLE;
+    }
+    ~fence()
+    {
+        if (handle) vkDestroyFence(graphicsBase::Base().Device(), handle, nullptr);
+        handle = VK_NULL_HANDLE;
+    }
+    // Getter
+    operator VkFence() const
+    {
+        return handle;
+    }
+    const VkFence* Address() const
+    {
+        return &handle;
+    }
+    // Const Function
+    VkResult Wait() const
+    {
+        VkResult result =
+            vkWaitForFences(graphicsBase::Base().Device(), 1, &handle, false, UINT64_MAX);
+        if (result)
+            std::cout << std::format(
+                "[ fence ] ERROR\nFailed to wait for the fence!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    VkResult Reset() const
+    {
+        VkResult result = vkResetFences(graphicsBase::Base().Device(), 1, &handle);
+        if (result)
+            std::cout << std::format(
+                "[ fence ] ERROR\nFailed to reset the fence!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    VkResult WaitAndReset() const
+    {
+        VkResult result = Wait();
+        result || (result = Reset());
+        return result;
+    }
+    // 返回 VK_SUCCESS 表示已置位，VK_NOT_READY 表示尚未置位
+    VkResult Status() const
+    {
+        VkResult result = vkGetFenceStatus(graphicsBase::Base().Device(), handle);
+        if (result < 0)
+            std::cout << std::format(
+                "[ fence ] ERROR\nFailed to get the status of the fence!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // Non-const Function
+    VkResult Create(VkFenceCreateFlags flags = 0)
+    {
+        VkFenceCreateInfo createInfo = {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+                                        .flags = flags};
+        VkResult result =
+            vkCreateFence(graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+        if (result)
+            std::cout << std::format(
+                "[ fence ] ERROR\nFailed to create a fence!\nError code: {}\n", int32_t(result));
+        return result;
+    }
+};
+
+class semaphore {
+    VkSemaphore handle = VK_NULL_HANDLE;
+
+public:
+    semaphore() = default;
+    semaphore(VkSemaphoreCreateInfo& createInfo)
+    {
+        Create(createInfo);
+    }
+    semaphore(semaphore&& other) noexcept
+    {
+        handle = other.handle;
+        other.handle = VK_NULL_HANDLE;
+    }
+    ~semaphore()
+    {
+        if (handle) vkDestroySemaphore(graphicsBase::Base().Device(), handle, nullptr);
+        handle = VK_NULL_HANDLE;
+    }
+    // Getter
+    operator VkSemaphore() const
+    {
+        return handle;
+    }
+    const VkSemaphore* Address() const
+    {
+        return &handle;
+    }
+    // Non-const Function
+    VkResult Create(VkSemaphoreCreateInfo& createInfo)
+    {
+        createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        VkResult result =
+            vkCreateSemaphore(graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+        if (result)
+            std::cout << std::format(
+                "[ semaphore ] ERROR\nFailed to create a semaphore!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    VkResult Create()
+    {
+        VkSemaphoreCreateInfo createInfo = {};
+        return Create(createInfo);
+    }
+};
+
+// 时间线信号量，其值单调递增，需开启 timelineSemaphore 特性（Vulkan 1.2）
+class timelineSemaphore : public semaphore {
+public:
+    timelineSemaphore() = default;
+    timelineSemaphore(uint64_t initialValue)
+    {
+        Create(initialValue);
+    }
+    // Const Function
+    // 当前已被置到的值
+    VkResult Value(uint64_t& value) const
+    {
+        VkResult result = vkGetSemaphoreCounterValue(graphicsBase::Base().Device(), *this, &value);
+        if (result)
+            std::cout << std::format(
+                "[ timelineSemaphore ] ERROR\nFailed to get the value of a timeline "
+                "semaphore!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // 阻塞直到值不小于 value，超时返回 VK_TIMEOUT
+    VkResult Wait(uint64_t value, uint64_t timeout = UINT64_MAX) const
+    {
+        VkSemaphoreWaitInfo waitInfo = {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                                        .semaphoreCount = 1,
+                                        .pSemaphores = Address(),
+                                        .pValues = &value};
+        VkResult result = vkWaitSemaphores(graphicsBase::Base().Device(), &waitInfo, timeout);
+        if (result < 0)
+            std::cout << std::format(
+                "[ timelineSemaphore ] ERROR\nFailed to wait for a timeline semaphore!\nError "
+                "code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // 从 CPU 端置值
+    VkResult Signal(uint64_t value) const
+    {
+        VkSemaphoreSignalInfo signalInfo = {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO,
+                                            .semaphore = *this,
+                                            .value = value};
+        VkResult result = vkSignalSemaphore(graphicsBase::Base().Device(), &signalInfo);
+        if (result)
+            std::cout << std::format(
+                "[ timelineSemaphore ] ERROR\nFailed to signal a timeline semaphore!\nError "
+                "code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // Non-const Function
+    VkResult Create(uint64_t initialValue = 0)
+    {
+        VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+            .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+            .initialValue = initialValue};
+        VkSemaphoreCreateInfo createInfo = {.pNext = &semaphoreTypeCreateInfo};
+        return semaphore::Create(createInfo);
+    }
+};
+
+// 命令缓冲区不单独销毁，其生命周期由分配它的命令池管理
+class commandBuffer {
+    friend class commandPool;
+    VkCommandBuffer handle = VK_NULL_HANDLE;
+
+public:
+    commandBuffer() = default;
+    commandBuffer(VkCommandBuffer handle) : handle(handle) {}
+    commandBuffer(commandBuffer&& other) noexcept
+    {
+        handle = other.handle;
+        other.handle = VK_NULL_HANDLE;
+    }
+    // Getter
+    operator VkCommandBuffer() const
+    {
+        return handle;
+    }
+    const VkCommandBuffer* Address() const
+    {
+        return &handle;
+    }
+    // Const Function
+    // 二级命令缓冲区需要提供继承信息
+    VkResult Begin(VkCommandBufferUsageFlags usageFlags,
+                   const VkCommandBufferInheritanceInfo& inheritanceInfo) const
+    {
+        VkCommandBufferBeginInfo beginInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                              .flags = usageFlags,
+                                              .pInheritanceInfo = &inheritanceInfo};
+        VkResult result = vkBeginCommandBuffer(handle, &beginInfo);
+        if (result)
+            std::cout << std::format(
+                "[ commandBuffer ] ERROR\nFailed to begin a command buffer!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    VkResult Begin(VkCommandBufferUsageFlags usageFlags = 0) const
+    {
+        VkCommandBufferBeginInfo beginInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                              .flags = usageFlags};
+        VkResult result = vkBeginCommandBuffer(handle, &beginInfo);
+        if (result)
+            std::cout << std::format(
+                "[ commandBuffer ] ERROR\nFailed to begin a command buffer!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    VkResult End() const
+    {
+        VkResult result = vkEndCommandBuffer(handle);
+        if (result)
+            std::cout << std::format(
+                "[ commandBuffer ] ERROR\nFailed to end a command buffer!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+};
+
+class commandPool {
+    VkCommandPool handle = VK_NULL_HANDLE;
+
+public:
+    commandPool() = default;
+    commandPool(uint32_t queueFamilyIndex, VkCommandPoolCreateFlags flags = 0)
+    {
+        Create(queueFamilyIndex, flags);
+    }
+    commandPool(commandPool&& other) noexcept
+    {
+        handle = other.handle;
+        other.handle = VK_NULL_HANDLE;
+    }
+    ~commandPool()
+    {
+        if (handle) vkDestroyCommandPool(graphicsBase::Base().Device(), handle, nullptr);
+        handle = VK_NULL_HANDLE;
+    }
+    // Getter
+    operator VkCommandPool() const
+    {
+        return handle;
+    }
+    const VkCommandPool* Address() const
+    {
+        return &handle;
+    }
+    // Const Function
+    VkResult AllocateBuffers(std::span<VkCommandBuffer> buffers,
+                             VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY) const
+    {
+        VkCommandBufferAllocateInfo allocateInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = handle,
+            .level = level,
+            .commandBufferCount = uint32_t(buffers.size())};
+        VkResult result =
+            vkAllocateCommandBuffers(graphicsBase::Base().Device(), &allocateInfo, buffers.data());
+        if (result)
+            std::cout << std::format(
+                "[ commandPool ] ERROR\nFailed to allocate command buffers!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    VkResult AllocateBuffers(std::span<commandBuffer> buffers,
+                             VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY) const
+    {
+        // commandBuffer 仅包含一个 VkCommandBuffer 成员，内存布局相同
+        static_assert(sizeof(commandBuffer) == sizeof(VkCommandBuffer));
+        return AllocateBuffers(
+            {reinterpret_cast<VkCommandBuffer*>(buffers.data()), buffers.size()}, level);
+    }
+    void FreeBuffers(std::span<VkCommandBuffer> buffers) const
+    {
+        vkFreeCommandBuffers(graphicsBase::Base().Device(), handle, uint32_t(buffers.size()),
+                             buffers.data());
+        for (auto& i : buffers) i = VK_NULL_HANDLE;
+    }
+    void FreeBuffers(std::span<commandBuffer> buffers) const
+    {
+        FreeBuffers({reinterpret_cast<VkCommandBuffer*>(buffers.data()), buffers.size()});
+    }
+    // 重置整个命令池，池中所有命令缓冲区回到初始状态，但仍保持已分配
+    VkResult Reset(VkCommandPoolResetFlags flags = 0) const
+    {
+        VkResult result = vkResetCommandPool(graphicsBase::Base().Device(), handle, flags);
+        if (result)
+            std::cout << std::format(
+                "[ commandPool ] ERROR\nFailed to reset a command pool!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // Non-const Function
+    VkResult Create(uint32_t queueFamilyIndex, VkCommandPoolCreateFlags flags = 0)
+    {
+        VkCommandPoolCreateInfo createInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                                              .flags = flags,
+                                              .queueFamilyIndex = queueFamilyIndex};
+        VkResult result =
+            vkCreateCommandPool(graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+        if (result)
+            std::cout << std::format(
+                "[ commandPool ] ERROR\nFailed to create a command pool!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+};
+
+class deviceMemory {
+    VkDeviceMemory handle = VK_NULL_HANDLE;
+    VkDeviceSize allocationSize = 0;            // 实际分配的大小
+    VkMemoryPropertyFlags memoryProperties = 0;  // 内存属性
+
+    // 映射非 host coherent 的内存时，需将范围对齐到 nonCoherentAtomSize
+    // size 先被钳制到分配的末尾再取整，VK_WHOLE_SIZE 因此不会在相加时溢出
+    VkDeviceSize AdjustNonCoherentMemoryRange(VkDeviceSize& size, VkDeviceSize& offset) const
+    {
+        const VkDeviceSize& nonCoherentAtomSize =
+            graphicsBase::Base().PhysicalDeviceProperties().limits.nonCoherentAtomSize;
+        size = std::min(size, allocationSize - std::min(offset, allocationSize));
+        VkDeviceSize _offset = offset;
+        offset = offset / nonCoherentAtomSize * nonCoherentAtomSize;
+        size = std::min((_offset + size + nonCoherentAtomSize - 1) / nonCoherentAtomSize *
+                            nonCoherentAtomSize,
+                        allocationSize) -
+               offset;
+        return _offset - offset;
+    }
+
+public:
+    deviceMemory() = default;
+    deviceMemory(VkMemoryAllocateInfo& allocateInfo)
+    {
+        Allocate(allocateInfo);
+    }
+    deviceMemory(deviceMemory&& other) noexcept
+    {
+        handle = other.handle;
+        allocationSize = other.allocationSize;
+        memoryProperties = other.memoryProperties;
+        other.handle = VK_NULL_HANDLE;
+        other.allocationSize = 0;
+        other.memoryProperties = 0;
+    }
+    ~deviceMemory()
+    {
+        if (handle) vkFreeMemory(graphicsBase::Base().Device(), handle, nullptr);
+        handle = VK_NULL_HANDLE;
+        allocationSize = 0;
+        memoryProperties = 0;
+    }
+    // Getter
+    operator VkDeviceMemory() const
+    {
+        return handle;
+    }
+    const VkDeviceMemory* Address() const
+    {
+        return &handle;
+    }
+    VkDeviceSize AllocationSize() const
+    {
+        return allocationSize;
+    }
+    VkMemoryPropertyFlags MemoryProperties() const
+    {
+        return memoryProperties;
+    }
+    // Const Function
+    // 映射 [offset, offset + size)，pData 指向 offset 处
+    // 非 host coherent 的内存会先使映射范围失效，以读取设备写入的最新内容
+    VkResult MapMemory(void*& pData, VkDeviceSize size, VkDeviceSize offset = 0) const
+    {
+        VkDeviceSize inverseDeltaOffset = 0;
+        if (!(memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+            inverseDeltaOffset = AdjustNonCoherentMemoryRange(size, offset);
+        if (VkResult result =
+                vkMapMemory(graphicsBase::Base().Device(), handle, offset, size, 0, &pData)) {
+            std::cout << std::format(
+                "[ deviceMemory ] ERROR\nFailed to map the memory!\nError code: {}\n",
+                int32_t(result));
+            return result;
+        }
+        if (!(memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+            pData = static_cast<uint8_t*>(pData) + inverseDeltaOffset;
+            VkMappedMemoryRange mappedMemoryRange = {.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+                                                     .memory = handle,
+                                                     .offset = offset,
+                                                     .size = size};
+            if (VkResult result = vkInvalidateMappedMemoryRanges(graphicsBase::Base().Device(), 1,
+                                                                 &mappedMemoryRange)) {
+                std::cout << std::format(
+                    "[ deviceMemory ] ERROR\nFailed to invalidate the memory!\nError code: {}\n",
+                    int32_t(result));
+                return result;
+            }
+        }
+        return VK_SUCCESS;
+    }
+    // 取消映射，非 host coherent 的内存会先刷新 [offset, offset + size) 以使写入对设备可见
+    VkResult UnmapMemory(VkDeviceSize size, VkDeviceSize offset = 0) const
+    {
+        if (VkResult result = FlushMemory(size, offset)) return result;
+        vkUnmapMemory(graphicsBase::Base().Device(), handle);
+        return VK_SUCCESS;
+    }
+    // 刷新仍处于映射状态的内存，host coherent 的内存无需刷新
+    VkResult FlushMemory(VkDeviceSize size, VkDeviceSize offset = 0) const
+    {
+        if (memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) return VK_SUCCESS;
+        AdjustNonCoherentMemoryRange(size, offset);
+        VkMappedMemoryRange mappedMemoryRange = {.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+                                                 .memory = handle,
+                                                 .offset = offset,
+                                                 .size = size};
+        VkResult result =
+            vkFlushMappedMemoryRanges(graphicsBase::Base().Device(), 1, &mappedMemoryRange);
+        if (result)
+            std::cout << std::format(
+                "[ deviceMemory ] ERROR\nFailed to flush the memory!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // Non-const Function
+    VkResult Allocate(VkMemoryAllocateInfo& allocateInfo)
+    {
+        if (allocateInfo.memoryTypeIndex >=
+            graphicsBase::Base().PhysicalDeviceMemoryProperties().memoryTypeCount) {
+            std::cout << std::format("[ deviceMemory ] ERROR\nInvalid memory type index!\n");
+            return VK_RESULT_MAX_ENUM;
+        }
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        if (VkResult result =
+                vkAllocateMemory(graphicsBase::Base().Device(), &allocateInfo, nullptr, &handle)) {
+            std::cout << std::format(
+                "[ deviceMemory ] ERROR\nFailed to allocate memory!\nError code: {}\n",
+                int32_t(result));
+            return result;
+        }
+        allocationSize = allocateInfo.allocationSize;
+        memoryProperties = graphicsBase::Base()
+                               .PhysicalDeviceMemoryProperties()
+                               .memoryTypes[allocateInfo.memoryTypeIndex]
+                               .propertyFlags;
+        return VK_SUCCESS;
+    }
+    // 按内存需求分配，找不到具有全部 desiredMemoryProperties 的内存类型时返回 VK_RESULT_MAX_ENUM
+    VkResult Allocate(const VkMemoryRequirements& memoryRequirements,
+                      VkMemoryPropertyFlags desiredMemoryProperties)
+    {
+        VkMemoryAllocateInfo allocateInfo = {
+            .allocationSize = memoryRequirements.size,
+            .memoryTypeIndex = graphicsBase::Base().MemoryTypeIndex(
+                memoryRequirements.memoryTypeBits, desiredMemoryProperties)};
+        return Allocate(allocateInfo);
+    }
+};
+
+class buffer {
+    VkBuffer handle = VK_NULL_HANDLE;
+
+public:
+    buffer() = default;
+    buffer(VkBufferCreateInfo& createInfo)
+    {
+        Create(createInfo);
+    }
+    buffer(buffer&& other) noexcept
+    {
+        handle = other.handle;
+        other.handle = VK_NULL_HANDLE;
+    }
+    ~buffer()
+    {
+        if (handle) vkDestroyBuffer(graphicsBase::Base().Device(), handle, nullptr);
+        handle = VK_NULL_HANDLE;
+    }
+    // Getter
+    operator VkBuffer() const
+    {
+        return handle;
+    }
+    const VkBuffer* Address() const
+    {
+        return &handle;
+    }
+    // Const Function
+    VkMemoryRequirements MemoryRequirements() const
+    {
+        VkMemoryRequirements memoryRequirements;
+        vkGetBufferMemoryRequirements(graphicsBase::Base().Device(), handle, &memoryRequirements);
+        return memoryRequirements;
+    }
+    // 需以 VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT 创建，并开启 bufferDeviceAddress 特性
+    VkDeviceAddress DeviceAddress() const
+    {
+        VkBufferDeviceAddressInfo addressInfo = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO, .buffer = handle};
+        return vkGetBufferDeviceAddress(graphicsBase::Base().Device(), &addressInfo);
+    }
+    VkResult BindMemory(VkDeviceMemory deviceMemory, VkDeviceSize memoryOffset = 0) const
+    {
+        VkResult result =
+            vkBindBufferMemory(graphicsBase::Base().Device(), handle, deviceMemory, memoryOffset);
+        if (result)
+            std::cout << std::format(
+                "[ buffer ] ERROR\nFailed to attach the memory!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // Non-const Function
+    VkResult Create(VkBufferCreateInfo& createInfo)
+    {
+        createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        VkResult result =
+            vkCreateBuffer(graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+        if (result)
+            std::cout << std::format(
+                "[ buffer ] ERROR\nFailed to create a buffer!\nError code: {}\n", int32_t(result));
+        return result;
+    }
+};
+
+class image {
+    VkImage handle = VK_NULL_HANDLE;
+
+public:
+    image() = default;
+    image(VkImageCreateInfo& createInfo)
+    {
+        Create(createInfo);
+    }
+    image(image&& other) noexcept
+    {
+        handle = other.handle;
+        other.handle = VK_NULL_HANDLE;
+    }
+    ~image()
+    {
+        if (handle) vkDestroyImage(graphicsBase::Base().Device(), handle, nullptr);
+        handle = VK_NULL_HANDLE;
+    }
+    // Getter
+    operator VkImage() const
+    {
+        return handle;
+    }
+    const VkImage* Address() const
+    {
+        return &handle;
+    }
+    // Const Function
+    VkMemoryRequirements MemoryRequirements() const
+    {
+        VkMemoryRequirements memoryRequirements;
+        vkGetImageMemoryRequirements(graphicsBase::Base().Device(), handle, &memoryRequirements);
+        return memoryRequirements;
+    }
+    VkResult BindMemory(VkDeviceMemory deviceMemory, VkDeviceSize memoryOffset = 0) const
+    {
+        VkResult result =
+            vkBindImageMemory(graphicsBase::Base().Device(), handle, deviceMemory, memoryOffset);
+        if (result)
+            std::cout << std::format(
+                "[ image ] ERROR\nFailed to attach the memory!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // Non-const Function
+    VkResult Create(VkImageCreateInfo& createInfo)
+    {
+        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        VkResult result =
+            vkCreateImage(graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+        if (result)
+            std::cout << std::format(
+                "[ image ] ERROR\nFailed to create an image!\nError code: {}\n", int32_t(result));
+        return result;
+    }
+};
+
+class imageView {
+    VkImageView handle = VK_NULL_HANDLE;
+
+public:
+    imageView() = default;
+    imageView(VkImageViewCreateInfo& createInfo)
+    {
+        Create(createInfo);
+    }
+    imageView(VkImage image, VkImageViewType viewType, VkFormat format,
+              const VkImageSubresourceRange& subresourceRange, VkImageViewCreateFlags flags = 0)
+    {
+        Create(image, viewType, format, subresourceRange, flags);
+    }
+    imageView(imageView&& other) noexcept
+    {
+        handle = other.handle;
+        other.handle = VK_NULL_HANDLE;
+    }
+    ~imageView()
+    {
+        if (handle) vkDestroyImageView(graphicsBase::Base().Device(), handle, nullptr);
+        handle = VK_NULL_HANDLE;
+    }
+    // Getter
+    operator VkImageView() const
+    {
+        return handle;
+    }
+    const VkImageView* Address() const
+    {
+        return &handle;
+    }
+    // Non-const Function
+    VkResult Create(VkImageViewCreateInfo& createInfo)
+    {
+        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        VkResult result =
+            vkCreateImageView(graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+        if (result)
+            std::cout << std::format(
+                "[ imageView ] ERROR\nFailed to create an image view!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    VkResult Create(VkImage image, VkImageViewType viewType, VkFormat format,
+                    const VkImageSubresourceRange& subresourceRange,
+                    VkImageViewCreateFlags flags = 0)
+    {
+        VkImageViewCreateInfo createInfo = {.flags = flags,
+                                            .image = image,
+                                            .viewType = viewType,
+                                            .format = format,
+                                            .subresourceRange = subresourceRange};
+        return Create(createInfo);
+    }
+};
+
+class descriptorPool {
+    VkDescriptorPool handle = VK_NULL_HANDLE;
+
+public:
+    descriptorPool() = default;
+    descriptorPool(uint32_t maxSetCount, std::span<const VkDescriptorPoolSize> poolSizes,
+                   VkDescriptorPoolCreateFlags flags = 0)
+    {
+        Create(maxSetCount, poolSizes, flags);
+    }
+    descriptorPool(descriptorPool&& other) noexcept
+    {
+        handle = other.handle;
+        other.handle = VK_NULL_HANDLE;
+    }
+    ~descriptorPool()
+    {
+        if (handle) vkDestroyDescriptorPool(graphicsBase::Base().Device(), handle, nullptr);
+        handle = VK_NULL_HANDLE;
+    }
+    // Getter
+    operator VkDescriptorPool() const
+    {
+        return handle;
+    }
+    const VkDescriptorPool* Address() const
+    {
+        return &handle;
+    }
+    // Const Function
+    // 池中空间不足时返回 VK_ERROR_OUT_OF_POOL_MEMORY 或 VK_ERROR_FRAGMENTED_POOL，
+    // 这两种情况不输出错误信息，由调用方换用其他池
+    VkResult AllocateSets(std::span<VkDescriptorSet> sets,
+                          std::span<const VkDescriptorSetLayout> setLayouts,
+                          const void* pNext = nullptr) const
+    {
+        if (sets.size() != setLayouts.size()) {
+            std::cout << std::format(
+                "[ descriptorPool ] ERROR\nFor each descriptor set, must provide its "
+                "corresponding layout!\n");
+            return VK_RESULT_MAX_ENUM;
+        }
+        VkDescriptorSetAllocateInfo allocateInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .pNext = pNext,
+            .descriptorPool = handle,
+            .descriptorSetCount = uint32_t(sets.size()),
+            .pSetLayouts = setLayouts.data()};
+        VkResult result =
+            vkAllocateDescriptorSets(graphicsBase::Base().Device(), &allocateInfo, sets.data());
+        if (result && result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL)
+            std::cout << std::format(
+                "[ descriptorPool ] ERROR\nFailed to allocate descriptor sets!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // 需以 VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT 创建
+    VkResult FreeSets(std::span<VkDescriptorSet> sets) const
+    {
+        VkResult result = vkFreeDescriptorSets(graphicsBase::Base().Device(), handle,
+                                               uint32_t(sets.size()), sets.data());
+        for (auto& i : sets) i = VK_NULL_HANDLE;
+        return result;
+    }
+    // 回收池中所有的描述符集
+    VkResult Reset() const
+    {
+        VkResult result = vkResetDescriptorPool(graphicsBase::Base().Device(), handle, 0);
+        if (result)
+            std::cout << std::format(
+                "[ descriptorPool ] ERROR\nFailed to reset a descriptor pool!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // Non-const Function
+    VkResult Create(VkDescriptorPoolCreateInfo& createInfo)
+    {
+        createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        VkResult result =
+            vkCreateDescriptorPool(graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+        if (result)
+            std::cout << std::format(
+                "[ descriptorPool ] ERROR\nFailed to create a descriptor pool!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    VkResult Create(uint32_t maxSetCount, std::span<const VkDescriptorPoolSize> poolSizes,
+                    VkDescriptorPoolCreateFlags flags = 0)
+    {
+        VkDescriptorPoolCreateInfo createInfo = {.flags = flags,
+                                                 .maxSets = maxSetCount,
+                                                 .poolSizeCount = uint32_t(poolSizes.size()),
+                                                 .pPoolSizes = poolSizes.data()};
+        return Create(createInfo);
+    }
+};
+
+class pipelineCache {
+    VkPipelineCache handle = VK_NULL_HANDLE;
+
+public:
+    pipelineCache() = default;
+    pipelineCache(pipelineCache&& other) noexcept
+    {
+        handle = other.handle;
+        other.handle = VK_NULL_HANDLE;
+    }
+    ~pipelineCache()
+    {
+        if (handle) vkDestroyPipelineCache(graphicsBase::Base().Device(), handle, nullptr);
+        handle = VK_NULL_HANDLE;
+    }
+    // Getter
+    operator VkPipelineCache() const
+    {
+        return handle;
+    }
+    const VkPipelineCache* Address() const
+    {
+        return &handle;
+    }
+    // Const Function
+    // 取得缓存的数据，可写入文件，下次启动时作为 initialData 传入 Create
+    VkResult GetData(std::vector<uint8_t>& data) const
+    {
+        size_t dataSize = 0;
+        VkResult result =
+            vkGetPipelineCacheData(graphicsBase::Base().Device(), handle, &dataSize, nullptr);
+        if (!result) {
+            data.resize(dataSize);
+            result = vkGetPipelineCacheData(graphicsBase::Base().Device(), handle, &dataSize,
+                                            data.data());
+        }
+        if (result)
+            std::cout << std::format(
+                "[ pipelineCache ] ERROR\nFailed to get the data of a pipeline cache!\nError "
+                "code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // 将 srcCaches 的内容并入此缓存
+    VkResult Merge(std::span<const VkPipelineCache> srcCaches) const
+    {
+        VkResult result = vkMergePipelineCaches(graphicsBase::Base().Device(), handle,
+                                                uint32_t(srcCaches.size()), srcCaches.data());
+        if (result)
+            std::cout << std::format(
+                "[ pipelineCache ] ERROR\nFailed to merge pipeline caches!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // Non-const Function
+    // initialData 与设备不匹配时会被驱动忽略，得到空的缓存
+    VkResult Create(std::span<const uint8_t> initialData = {},
+                    VkPipelineCacheCreateFlags flags = 0)
+    {
+        VkPipelineCacheCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .flags = flags,
+            .initialDataSize = initialData.size(),
+            .pInitialData = initialData.data()};
+        VkResult result =
+            vkCreatePipelineCache(graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+        if (result)
+            std::cout << std::format(
+                "[ pipelineCache ] ERROR\nFailed to create a pipeline cache!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+};
+
+class pipeline {
+    VkPipeline handle = VK_NULL_HANDLE;
+
+public:
+    pipeline() = default;
+    pipeline(pipeline&& other) noexcept
+    {
+        handle = other.handle;
+        other.handle = VK_NULL_HANDLE;
+    }
+    ~pipeline()
+    {
+        if (handle) vkDestroyPipeline(graphicsBase::Base().Device(), handle, nullptr);
+        handle = VK_NULL_HANDLE;
+    }
+    // Getter
+    operator VkPipeline() const
+    {
+        return handle;
+    }
+    const VkPipeline* Address() const
+    {
+        return &handle;
+    }
+    // Non-const Function
+    VkResult Create(VkGraphicsPipelineCreateInfo& createInfo,
+                    VkPipelineCache cache = VK_NULL_HANDLE)
+    {
+        createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        VkResult result = vkCreateGraphicsPipelines(graphicsBase::Base().Device(), cache, 1,
+                                                    &createInfo, nullptr, &handle);
+        if (result)
+            std::cout << std::format(
+                "[ pipeline ] ERROR\nFailed to create a graphics pipeline!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    VkResult Create(VkComputePipelineCreateInfo& createInfo,
+                    VkPipelineCache cache = VK_NULL_HANDLE)
+    {
+        createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        VkResult result = vkCreateComputePipelines(graphicsBase::Base().Device(), cache, 1,
+                                                   &createInfo, nullptr, &handle);
+        if (result)
+            std::cout << std::format(
+                "[ pipeline ] ERROR\nFailed to create a compute pipeline!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+};
+
+class queryPool {
+    VkQueryPool handle = VK_NULL_HANDLE;
+
+public:
+    queryPool() = default;
+    queryPool(queryPool&& other) noexcept
+    {
+        handle = other.handle;
+        other.handle = VK_NULL_HANDLE;
+    }
+    ~queryPool()
+    {
+        if (handle) vkDestroyQueryPool(graphicsBase::Base().Device(), handle, nullptr);
+        handle = VK_NULL_HANDLE;
+    }
+    // Getter
+    operator VkQueryPool() const
+    {
+        return handle;
+    }
+    const VkQueryPool* Address() const
+    {
+        return &handle;
+    }
+    // Const Function
+    void CmdReset(VkCommandBuffer commandBuffer, uint32_t firstQuery, uint32_t queryCount) const
+    {
+        vkCmdResetQueryPool(commandBuffer, handle, firstQuery, queryCount);
+    }
+    // 默认以 64 位整数取得结果并等待其可用，results 的大小即所取的查询个数
+    VkResult GetResults(uint32_t firstQuery, std::span<uint64_t> results,
+                        VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT |
+                                                   VK_QUERY_RESULT_WAIT_BIT) const
+    {
+        VkResult result = vkGetQueryPoolResults(
+            graphicsBase::Base().Device(), handle, firstQuery, uint32_t(results.size()),
+            results.size_bytes(), results.data(), sizeof(uint64_t), flags);
+        if (result < 0)
+            std::cout << std::format(
+                "[ queryPool ] ERROR\nFailed to get the results of queries!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    // Non-const Function
+    VkResult Create(VkQueryType queryType, uint32_t queryCount,
+                    VkQueryPipelineStatisticFlags pipelineStatistics = 0)
+    {
+        VkQueryPoolCreateInfo createInfo = {.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                            .queryType = queryType,
+                                            .queryCount = queryCount,
+                                            .pipelineStatistics = pipelineStatistics};
+        VkResult result =
+            vkCreateQueryPool(graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+        if (result)
+            std::cout << std::format(
+                "[ queryPool ] ERROR\nFailed to create a query pool!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+};
 }  // namespace vulkan
@@ -0,0 +1,320 @@
+#pragma once
+#include "VKObjectCache.h"
+
+namespace vulkan {
+// 全局的 bindless 描述符堆：一个描述符集中包含三个很大的描述符数组，
+// 每帧只需绑定一次，着色器以分配所得的槽位下标直接访问资源，无需逐次绘制更新或绑定描述符集
+// binding 0：带采样器的图像（VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER）
+// binding 1：storage image
+// binding 2：storage 缓冲区
+// 对应的 GLSL 声明（需 GL_EXT_nonuniform_qualifier）：
+//     layout(set = 0, binding = 0) uniform sampler2D textures[];
+//     layout(set = 0, binding = 1, rgba8) uniform image2D storageImages[];
+//     layout(set = 0, binding = 2) buffer storageBuffer { uint data[]; } storageBuffers[];
+// 下标可能因调用而异时，以 nonuniformEXT(index) 访问
+// 各数组以 UPDATE_AFTER_BIND 和 PARTIALLY_BOUND 创建：
+// 已绑定的描述符集仍可写入新的槽位，着色器未访问的槽位可以不含有效的描述符
+class bindlessHeap {
+public:
+    enum slotType : uint32_t {
+        slot_sampledImage,
+        slot_storageImage,
+        slot_storageBuffer,
+        slotType_count
+    };
+    static constexpr VkDescriptorType descriptorTypes[slotType_count] = {
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER};
+    static constexpr uint32_t invalidSlot = UINT32_MAX;
+
+private:
+    // 槽位的空闲链表，优先复用已释放的槽位
+    struct slotAllocator {
+        uint32_t capacity = 0;
+        uint32_t nextSlot = 0;  // 从未使用过的槽位从此处开始
+        std::vector<uint32_t> freeSlots;
+    };
+    bool useExtension = false;  // 是否经由 VK_EXT_descriptor_indexing 使用
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES};
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;  // 由 descriptorSetLayoutCache 持有
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    slotAllocator slotAllocators[slotType_count];
+    mutable std::mutex mutex;  // 保护槽位的分配，以及对 set 的写入（dstSet 须由外部同步）
+
+    //--------------------
+    bindlessHeap() = default;
+    bindlessHeap(bindlessHeap&&) = delete;
+    // Const Function
+    // 逻辑设备上开启的特性，使用扩展时取自扩展的特性结构体，否则取自 Vulkan12Features
+    bool FeaturesEnabled() const
+    {
+        auto Check = [](const auto& features) {
+            return features.runtimeDescriptorArray && features.descriptorBindingPartiallyBound &&
+                   features.descriptorBindingUpdateUnusedWhilePending &&
+                   features.descriptorBindingSampledImageUpdateAfterBind &&
+                   features.descriptorBindingStorageImageUpdateAfterBind &&
+                   features.descriptorBindingStorageBufferUpdateAfterBind &&
+                   features.shaderSampledImageArrayNonUniformIndexing &&
+                   features.shaderStorageImageArrayNonUniformIndexing &&
+                   features.shaderStorageBufferArrayNonUniformIndexing;
+        };
+        return useExtension ? Check(descriptorIndexingFeatures)
+                            : Check(graphicsBase::Base().PhysicalDeviceVulkan12Features());
+    }
+    void Write(slotType type, uint32_t slot, const VkDescriptorImageInfo* pImageInfo,
+               const VkDescriptorBufferInfo* pBufferInfo) const
+    {
+        VkWriteDescriptorSet write = {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                                      .dstSet = set,
+                                      .dstBinding = type,
+                                      .dstArrayElement = slot,
+                                      .descriptorCount = 1,
+                                      .descriptorType = descriptorTypes[type],
+                                      .pImageInfo = pImageInfo,
+                                      .pBufferInfo = pBufferInfo};
+        std::lock_guard lock(mutex);
+        vkUpdateDescriptorSets(graphicsBase::Base().Device(), 1, &write, 0, nullptr);
+    }
+    // Non-const Function
+    uint32_t AllocateSlot(slotType type)
+    {
+        std::lock_guard lock(mutex);
+        slotAllocator& allocator = slotAllocators[type];
+        if (!allocator.freeSlots.empty()) {
+            uint32_t slot = allocator.freeSlots.back();
+            allocator.freeSlots.pop_back();
+            return slot;
+        }
+        if (allocator.nextSlot < allocator.capacity) return allocator.nextSlot++;
+        std::cout << std::format(
+            "[ bindlessHeap ] ERROR\nRun out of slots of type {}, capacity: {}\n", uint32_t(type),
+            allocator.capacity);
+        return invalidSlot;
+    }
+
+public:
+    // Getter
+    VkDescriptorSetLayout SetLayout() const
+    {
+        return setLayout;
+    }
+    VkDescriptorSet Set() const
+    {
+        return set;
+    }
+    uint32_t Capacity(slotType type) const
+    {
+        return slotAllocators[type].capacity;
+    }
+    // 正在使用的槽位个数
+    uint32_t UsedSlotCount(slotType type)
+    {
+        std::lock_guard lock(mutex);
+        return slotAllocators[type].nextSlot - uint32_t(slotAllocators[type].freeSlots.size());
+    }
+    // Const Function
+    // 将堆绑定到 firstSet，每个命令缓冲区（及每次更换了不兼容的管线布局后）只需绑定一次
+    void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint,
+              VkPipelineLayout pipelineLayout, uint32_t firstSet = 0) const
+    {
+        vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, firstSet, 1, &set, 0,
+                                nullptr);
+    }
+    // 覆写槽位中的描述符，需确保 GPU 上正在执行的命令不会访问该槽位
+    void UpdateSampledImage(uint32_t slot, VkImageView view, VkSampler sampler,
+                            VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) const
+    {
+        VkDescriptorImageInfo imageInfo = {sampler, view, layout};
+        Write(slot_sampledImage, slot, &imageInfo, nullptr);
+    }
+    void UpdateStorageImage(uint32_t slot, VkImageView view,
+                            VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL) const
+    {
+        VkDescriptorImageInfo imageInfo = {VK_NULL_HANDLE, view, layout};
+        Write(slot_storageImage, slot, &imageInfo, nullptr);
+    }
+    void UpdateStorageBuffer(uint32_t slot, VkBuffer buffer, VkDeviceSize offset = 0,
+                             VkDeviceSize range = VK_WHOLE_SIZE) const
+    {
+        VkDescriptorBufferInfo bufferInfo = {buffer, offset, range};
+        Write(slot_storageBuffer, slot, nullptr, &bufferInfo);
+    }
+    // Non-const Function
+    // 在 DeterminePhysicalDevice 后、CreateDevice 前调用
+    // 设备支持 Vulkan 1.2 时，CreateDevice 会自动开启 Vulkan12Features 中的描述符索引特性
+    // 否则添加 VK_EXT_descriptor_indexing，并链接其特性结构体
+    VkResult Enable()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        uint32_t deviceApiVersion = base.DeviceApiVersion();
+        useExtension = deviceApiVersion < VK_API_VERSION_1_2;
+        if (!useExtension) return VK_SUCCESS;
+        // 查询扩展特性需要 vkGetPhysicalDeviceFeatures2，VK_EXT_descriptor_indexing 依赖的
+        // VK_KHR_maintenance3 在 Vulkan 1.1 中成为核心功能
+        if (deviceApiVersion < VK_API_VERSION_1_1) {
+            std::cout << std::format(
+                "[ bindlessHeap ] ERROR\nDescriptor indexing requires Vulkan 1.1 or above!\n");
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        const char* extensionNames[] = {VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME};
+        if (VkResult result = base.CheckDeviceExtensions(extensionNames)) return result;
+        if (!extensionNames[0]) {
+            std::cout << std::format(
+                "[ bindlessHeap ] ERROR\nVK_EXT_descriptor_indexing is not supported!\n");
+            return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+        base.AddDeviceExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        base.AddNextStructure_PhysicalDeviceFeatures(descriptorIndexingFeatures);
+        return VK_SUCCESS;
+    }
+    // 在 CreateDevice 后调用，各类型的容量会被限制在设备所允许的范围内
+    VkResult Create(uint32_t sampledImageCount = 65536, uint32_t storageImageCount = 4096,
+                    uint32_t storageBufferCount = 16384)
+    {
+        graphicsBase& base = graphicsBase::Base();
+        // 首次调用时注册回调，销毁逻辑设备前销毁描述符池
+        static bool callbackAdded = false;
+        if (!callbackAdded) {
+            base.AddCallback_DestroyDevice([] { Base().Destroy(); });
+            callbackAdded = true;
+        }
+        if (!FeaturesEnabled()) {
+            std::cout << std::format(
+                "[ bindlessHeap ] ERROR\nDescriptor indexing features are not supported!\n");
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        Destroy();
+        // 以 UPDATE_AFTER_BIND 创建的描述符集受另一组上限约束
+        VkPhysicalDeviceDescriptorIndexingProperties indexingProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES};
+        VkPhysicalDeviceProperties2 properties2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &indexingProperties};
+        vkGetPhysicalDeviceProperties2(base.PhysicalDevice(), &properties2);
+        const auto& p = indexingProperties;
+        uint32_t capacities[slotType_count] = {
+            std::min({sampledImageCount, p.maxDescriptorSetUpdateAfterBindSampledImages,
+                      p.maxDescriptorSetUpdateAfterBindSamplers,
+                      p.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                      p.maxPerStageDescriptorUpdateAfterBindSamplers}),
+            std::min({storageImageCount, p.maxDescriptorSetUpdateAfterBindStorageImages,
+                      p.maxPerStageDescriptorUpdateAfterBindStorageImages}),
+            std::min({storageBufferCount, p.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                      p.maxPerStageDescriptorUpdateAfterBindStorageBuffers})};
+        // 单个着色器阶段可访问的描述符总数也有上限，超出时按比例缩减
+        uint64_t total = uint64_t(capacities[0]) + capacities[1] + capacities[2];
+        if (total > p.maxPerStageUpdateAfterBindResources)
+            for (auto& i : capacities)
+                i = uint32_t(uint64_t(i) * p.maxPerStageUpdateAfterBindResources / total);
+
+        VkDescriptorSetLayoutBinding bindings[slotType_count];
+        VkDescriptorBindingFlags bindingFlags[slotType_count];
+        VkDescriptorPoolSize poolSizes[slotType_count];
+        for (uint32_t i = 0; i < slotType_count; i++) {
+            bindings[i] = {.binding = i,
+                           .descriptorType = descriptorTypes[i],
+                           .descriptorCount = capacities[i],
+                           .stageFlags = VK_SHADER_STAGE_ALL};
+            bindingFlags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                              VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                              VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+            poolSizes[i] = {descriptorTypes[i], capacities[i]};
+            slotAllocators[i] = {.capacity = capacities[i]};
+        }
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+            .bindingCount = slotType_count,
+            .pBindingFlags = bindingFlags};
+        VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .pNext = &bindingFlagsCreateInfo,
+            .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+            .bindingCount = slotType_count,
+            .pBindings = bindings};
+        if (VkResult result = descriptorSetLayoutCache::Base().Get(setLayoutCreateInfo, setLayout))
+            return result;
+        VkDescriptorPoolCreateInfo poolCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+            .maxSets = 1,
+            .poolSizeCount = slotType_count,
+            .pPoolSizes = poolSizes};
+        if (VkResult result =
+                vkCreateDescriptorPool(base.Device(), &poolCreateInfo, nullptr, &pool)) {
+            std::cout << std::format(
+                "[ bindlessHeap ] ERROR\nFailed to create a descriptor pool!\nError code: {}\n",
+                int32_t(result));
+            return result;
+        }
+        VkDescriptorSetAllocateInfo allocateInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = pool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &setLayout};
+        if (VkResult result = vkAllocateDescriptorSets(base.Device(), &allocateInfo, &set)) {
+            std::cout << std::format(
+                "[ bindlessHeap ] ERROR\nFailed to allocate the descriptor set!\nError code: {}\n",
+                int32_t(result));
+            return result;
+        }
+        return VK_SUCCESS;
+    }
+    // 以堆作为第 0 个描述符集，取得（经由 pipelineLayoutCache 去重的）管线布局
+    VkResult PipelineLayout(VkPipelineLayout& pipelineLayout,
+                            std::span<const VkPushConstantRange> pushConstantRanges = {})
+    {
+        VkPipelineLayoutCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .setLayoutCount = 1,
+            .pSetLayouts = &setLayout,
+            .pushConstantRangeCount = uint32_t(pushConstantRanges.size()),
+            .pPushConstantRanges = pushConstantRanges.data()};
+        return pipelineLayoutCache::Base().Get(createInfo, pipelineLayout);
+    }
+    // 分配槽位并写入描述符，返回供着色器使用的下标，槽位用尽时返回 invalidSlot
+    uint32_t AddSampledImage(VkImageView view, VkSampler sampler,
+                             VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        uint32_t slot = AllocateSlot(slot_sampledImage);
+        if (slot != invalidSlot) UpdateSampledImage(slot, view, sampler, layout);
+        return slot;
+    }
+    uint32_t AddStorageImage(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL)
+    {
+        uint32_t slot = AllocateSlot(slot_storageImage);
+        if (slot != invalidSlot) UpdateStorageImage(slot, view, layout);
+        return slot;
+    }
+    uint32_t AddStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0,
+                              VkDeviceSize range = VK_WHOLE_SIZE)
+    {
+        uint32_t slot = AllocateSlot(slot_storageBuffer);
+        if (slot != invalidSlot) UpdateStorageBuffer(slot, buffer, offset, range);
+        return slot;
+    }
+    // 归还槽位，之后它可能被立即重新分配并覆写
+    // 需确保已提交的命令不会再访问该槽位，可借助 deletionQueue::Push(function, ...) 延迟调用
+    void Remove(slotType type, uint32_t slot)
+    {
+        if (slot == invalidSlot) return;
+        std::lock_guard lock(mutex);
+        slotAllocators[type].freeSlots.push_back(slot);
+    }
+    // 销毁描述符池，调用前需确保设备不再使用该描述符集
+    void Destroy()
+    {
+        if (pool) vkDestroyDescriptorPool(graphicsBase::Base().Device(), pool, nullptr);
+        pool = VK_NULL_HANDLE;
+        set = VK_NULL_HANDLE;
+        setLayout = VK_NULL_HANDLE;
+        for (auto& i : slotAllocators) i = {};
+    }
+    // Static Function
+    static bindlessHeap& Base()
+    {
+        static bindlessHeap singleton;
+        return singleton;
+    }
+};
+}  // namespace vulkan
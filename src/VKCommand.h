@@ -0,0 +1,478 @@
+#pragma once
+#include "ThreadPool.hpp"
+#include "VKDynamicRendering.h"
+
+namespace vulkan {
+// 每个 (飞行中的帧, 录制线程, 队列族) 组合独占一个命令池
+// 1. 各线程只访问自己的命令池，录制时无需加锁
+// 2. 帧的 fence 置位后整池重置，不单独重置命令缓冲区，所以命令池不带
+//    VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
+// 3. 重置后命令缓冲区仍保持已分配，下一轮同一帧直接复用，不会每帧重新分配
+class commandPoolManager {
+    // 对齐到缓存行，避免相邻线程的计数器出现伪共享
+    struct alignas(64) poolSlot {
+        commandPool pool;
+        std::vector<VkCommandBuffer> buffers[2];  // 下标为 VkCommandBufferLevel
+        uint32_t usedCounts[2] = {};              // 本轮已取出的命令缓冲区个数
+    };
+    uint32_t frameCount = 0;                   // 飞行中的帧数
+    uint32_t threadCount = 0;                  // 录制线程数
+    std::vector<uint32_t> queueFamilyIndices;  // 需要命令池的队列族，已去重
+    std::vector<poolSlot> slots;               // 按 [帧][线程][队列族] 排列
+    uint32_t currentFrame = 0;                 // 当前正在录制的帧
+
+    // Non-const Function
+    // 队列族未在 Create 时登记，或帧、线程下标越界时返回 nullptr
+    poolSlot* Slot(uint32_t frameIndex, uint32_t threadIndex, uint32_t queueFamilyIndex)
+    {
+        uint32_t familyIndex = 0;
+        while (familyIndex < queueFamilyIndices.size() &&
+               queueFamilyIndices[familyIndex] != queueFamilyIndex)
+            familyIndex++;
+        if (familyIndex == queueFamilyIndices.size()) {
+            std::cout << std::format(
+                "[ commandPoolManager ] ERROR\nNo command pool for the queue family: {}\n",
+                queueFamilyIndex);
+            return nullptr;
+        }
+        if (frameIndex >= frameCount) {
+            std::cout << std::format("[ commandPoolManager ] ERROR\nInvalid frame index: {}\n",
+                                     frameIndex);
+            return nullptr;
+        }
+        if (threadIndex >= threadCount) {
+            std::cout << std::format(
+                "[ commandPoolManager ] ERROR\nInvalid thread index: {}\n", threadIndex);
+            return nullptr;
+        }
+        return &slots[(frameIndex * threadCount + threadIndex) * queueFamilyIndices.size() +
+                      familyIndex];
+    }
+
+public:
+    // 一次为命令池追加分配的命令缓冲区个数，减少分配次数
+    static constexpr uint32_t allocationBatchSize = 4;
+
+    commandPoolManager() = default;
+    commandPoolManager(uint32_t frameCount, uint32_t threadCount,
+                       std::span<const uint32_t> queueFamilyIndices = {})
+    {
+        Create(frameCount, threadCount, queueFamilyIndices);
+    }
+    commandPoolManager(commandPoolManager&&) = default;
+    // Getter
+    uint32_t FrameCount() const
+    {
+        return frameCount;
+    }
+    uint32_t ThreadCount() const
+    {
+        return threadCount;
+    }
+    uint32_t CurrentFrame() const
+    {
+        return currentFrame;
+    }
+    const std::vector<uint32_t>& QueueFamilyIndices() const
+    {
+        return queueFamilyIndices;
+    }
+    // Non-const Function
+    // queueFamilyIndices 为空时，为 graphicsBase 的 图形/计算 队列族创建命令池
+    VkResult Create(uint32_t frameCount, uint32_t threadCount,
+                    std::span<const uint32_t> queueFamilyIndices = {})
+    {
+        this->frameCount = frameCount;
+        this->threadCount = threadCount;
+        this->queueFamilyIndices.clear();
+        auto AddQueueFamily = [this](uint32_t index) {
+            if (index == VK_QUEUE_FAMILY_IGNORED) return;
+            for (auto i : this->queueFamilyIndices)
+                if (i == index) return;
+            this->queueFamilyIndices.push_back(index);
+        };
+        if (queueFamilyIndices.empty()) {
+            AddQueueFamily(graphicsBase::Base().QueueFamilyIndex_Graphics());
+            AddQueueFamily(graphicsBase::Base().QueueFamilyIndex_Compute());
+        } else
+            for (auto i : queueFamilyIndices) AddQueueFamily(i);
+
+        slots.clear();
+        slots.resize(frameCount * threadCount * this->queueFamilyIndices.size());
+        for (uint32_t frame = 0; frame < frameCount; frame++)
+            for (uint32_t thread = 0; thread < threadCount; thread++)
+                for (auto family : this->queueFamilyIndices) {
+                    // 命令缓冲区每帧只提交一次，标记为 TRANSIENT 以便驱动优化
+                    commandPool& pool = Slot(frame, thread, family)->pool;
+                    if (VkResult result = pool.Create(family, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT))
+                        return result;
+                }
+        currentFrame = 0;
+        return VK_SUCCESS;
+    }
+    // 在主线程的帧开头调用，此时不应有线程在录制命令
+    // fence_frame 为该帧上一轮提交时所用的 fence，等待其置位后重置，供本轮提交使用
+    VkResult BeginFrame(uint32_t frameIndex, const fence& fence_frame)
+    {
+        if (VkResult result = fence_frame.WaitAndReset()) return result;
+        return BeginFrame(frameIndex);
+    }
+    // 调用方已确认 frameIndex 对应帧的命令执行完毕时使用
+    VkResult BeginFrame(uint32_t frameIndex)
+    {
+        if (frameIndex >= frameCount) {
+            std::cout << std::format("[ commandPoolManager ] ERROR\nInvalid frame index: {}\n",
+                                     frameIndex);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        currentFrame = frameIndex;
+        for (uint32_t thread = 0; thread < threadCount; thread++)
+            for (auto family : queueFamilyIndices) {
+                poolSlot& slot = *Slot(frameIndex, thread, family);
+                // 本轮未取用过的命令池无需重置
+                if (!slot.usedCounts[0] && !slot.usedCounts[1]) continue;
+                // 不带 VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT，保留命令池已申请的内存
+                if (VkResult result = slot.pool.Reset()) return result;
+                slot.usedCounts[0] = slot.usedCounts[1] = 0;
+            }
+        return VK_SUCCESS;
+    }
+    // 由录制线程调用，threadIndex 在 [0, threadCount) 范围内且每个线程各不相同
+    // 返回的命令缓冲区处于初始状态，需自行 Begin，于本帧内有效
+    VkCommandBuffer CommandBuffer(uint32_t threadIndex, uint32_t queueFamilyIndex,
+                                  VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+    {
+        poolSlot* pSlot = Slot(currentFrame, threadIndex, queueFamilyIndex);
+        if (!pSlot) return VK_NULL_HANDLE;
+        poolSlot& slot = *pSlot;
+        auto& buffers = slot.buffers[level];
+        uint32_t& usedCount = slot.usedCounts[level];
+        if (usedCount == buffers.size()) {
+            buffers.resize(usedCount + allocationBatchSize);
+            if (slot.pool.AllocateBuffers(
+                    std::span(buffers).subspan(usedCount, allocationBatchSize), level)) {
+                buffers.resize(usedCount);
+                return VK_NULL_HANDLE;
+            }
+        }
+        return buffers[usedCount++];
+    }
+    VkCommandBuffer CommandBuffer_Graphics(
+        uint32_t threadIndex, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+    {
+        return CommandBuffer(threadIndex, graphicsBase::Base().QueueFamilyIndex_Graphics(), level);
+    }
+    VkCommandBuffer CommandBuffer_Compute(
+        uint32_t threadIndex, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+    {
+        return CommandBuffer(threadIndex, graphicsBase::Base().QueueFamilyIndex_Compute(), level);
+    }
+    // 销毁所有命令池，例如在重建逻辑设备前调用
+    void Destroy()
+    {
+        slots.clear();
+        queueFamilyIndices.clear();
+        frameCount = threadCount = currentFrame = 0;
+    }
+};
+
+// 将一个 render pass（或一段 dynamic rendering）拆成若干块，各块在工作线程上录制到二级命令缓冲区，
+// 再由主命令缓冲区按块下标顺序执行，因此无论线程调度如何，提交顺序都是确定的
+class parallelRecorder {
+public:
+    // 参数为已 Begin 的二级命令缓冲区和块下标，不需要也不应该调用 Begin/End
+    using recordFunction_t =
+        std::function<void(VkCommandBuffer commandBuffer, uint32_t chunkIndex)>;
+
+private:
+    commandPoolManager& poolManager;
+    threadPool& workers;
+    std::vector<VkCommandBuffer> secondaryCommandBuffers;
+    std::vector<VkResult> chunkResults;
+    std::vector<double> chunkRecordingTimes;  // 单位为毫秒
+    std::vector<uint32_t> chunkWorkers;       // 录制各块的工作线程编号
+
+    VkResult RecordChunks(const VkCommandBufferInheritanceInfo& inheritanceInfo,
+                          uint32_t chunkCount, const recordFunction_t& record)
+    {
+        secondaryCommandBuffers.resize(chunkCount);
+        chunkResults.assign(chunkCount, VK_SUCCESS);
+        chunkRecordingTimes.resize(chunkCount);
+        chunkWorkers.resize(chunkCount);
+        workers.ParallelFor(chunkCount, [&](uint32_t chunkIndex, uint32_t workerIndex) {
+            auto time0 = std::chrono::steady_clock::now();
+            commandBuffer secondary =
+                poolManager.CommandBuffer(workerIndex, poolManager.QueueFamilyIndices()[0],
+                                          VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+            VkResult result = secondary ? VK_SUCCESS : VK_ERROR_OUT_OF_DEVICE_MEMORY;
+            if (!result)
+                result = secondary.Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                                             VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+                                         inheritanceInfo);
+            if (!result) {
+                record(secondary, chunkIndex);
+                result = secondary.End();
+            }
+            secondaryCommandBuffers[chunkIndex] = secondary;
+            chunkResults[chunkIndex] = result;
+            chunkWorkers[chunkIndex] = workerIndex;
+            chunkRecordingTimes[chunkIndex] =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time0)
+                    .count();
+        });
+        for (auto i : chunkResults)
+            if (i) {
+                std::cout << std::format(
+                    "[ parallelRecorder ] ERROR\nFailed to record a secondary command buffer!\n"
+                    "Error code: {}\n",
+                    int32_t(i));
+                return i;
+            }
+        return VK_SUCCESS;
+    }
+
+public:
+    // poolManager 的线程数需不少于 workers 的工作线程数，且第一个队列族为主命令缓冲区所属的队列族
+    parallelRecorder(commandPoolManager& poolManager, threadPool& workers)
+        : poolManager(poolManager), workers(workers) {}
+    // Getter
+    uint32_t ChunkCount() const
+    {
+        return uint32_t(chunkRecordingTimes.size());
+    }
+    // 上一次录制中各块的 CPU 录制耗时，单位为毫秒，可据此调整各块的划分
+    std::span<const double> ChunkRecordingTimes() const
+    {
+        return chunkRecordingTimes;
+    }
+    std::span<const uint32_t> ChunkWorkers() const
+    {
+        return chunkWorkers;
+    }
+    // 耗时最长的块决定了整体录制时间，该值与平均值越接近说明划分越均衡
+    double MaxChunkRecordingTime() const
+    {
+        double max = 0;
+        for (auto i : chunkRecordingTimes) max = std::max(max, i);
+        return max;
+    }
+    double TotalChunkRecordingTime() const
+    {
+        return std::accumulate(chunkRecordingTimes.begin(), chunkRecordingTimes.end(), 0.);
+    }
+    // Non-const Function
+    // 录制 beginInfo 指定的 render pass 中的第 subpass 个子通道
+    // 在 primary 中开始 render pass，执行全部块，然后结束 render pass
+    // 若 render pass 有多个子通道，对第一个之后的子通道，令 beginRenderPass 为 false，此时只会调用
+    // vkCmdNextSubpass
+    VkResult Record(VkCommandBuffer primary, const VkRenderPassBeginInfo& beginInfo,
+                    uint32_t subpass, uint32_t chunkCount, const recordFunction_t& record,
+                    bool beginRenderPass = true, bool endRenderPass = true)
+    {
+        VkCommandBufferInheritanceInfo inheritanceInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+            .renderPass = beginInfo.renderPass,
+            .subpass = subpass,
+            .framebuffer = beginInfo.framebuffer};
+        if (VkResult result = RecordChunks(inheritanceInfo, chunkCount, record)) return result;
+        if (beginRenderPass)
+            vkCmdBeginRenderPass(primary, &beginInfo,
+                                 VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        else
+            vkCmdNextSubpass(primary, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        vkCmdExecuteCommands(primary, chunkCount, secondaryCommandBuffers.data());
+        if (endRenderPass) vkCmdEndRenderPass(primary);
+        return VK_SUCCESS;
+    }
+    // 录制一段 dynamic rendering，需已通过 dynamicRendering::Enable 开启动态渲染
+    // renderingInheritanceInfo 中需填写各附件的格式与采样数
+    // 其 flags 和 viewMask 会按 renderingInfo 补全
+    VkResult Record(VkCommandBuffer primary, VkRenderingInfo renderingInfo,
+                    VkCommandBufferInheritanceRenderingInfo renderingInheritanceInfo,
+                    uint32_t chunkCount, const recordFunction_t& record)
+    {
+        renderingInheritanceInfo.sType =
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+        renderingInheritanceInfo.flags =
+            renderingInfo.flags & ~VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+        renderingInheritanceInfo.viewMask = renderingInfo.viewMask;
+        VkCommandBufferInheritanceInfo inheritanceInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+            .pNext = &renderingInheritanceInfo};
+        if (VkResult result = RecordChunks(inheritanceInfo, chunkCount, record)) return result;
+        renderingInfo.flags |= VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+        dynamicRendering::Base().BeginRendering(primary, renderingInfo);
+        vkCmdExecuteCommands(primary, chunkCount, secondaryCommandBuffers.data());
+        dynamicRendering::Base().EndRendering(primary);
+        return VK_SUCCESS;
+    }
+};
+
+// 缓存内容不变的命令，录制一次后每帧重复提交，仅在内容改变（被标记为 dirty）时重新录制
+// 每个条目有 variantCount 个变体，通常每个飞行中的帧或每张交换链图像一个，
+// 以免重录某一变体时，另一帧仍在使用同一个命令缓冲区
+// 交换链重建时通过 callbacks_destroySwapchain 和 callbacks_createSwapchain 自动失效：
+// 1. 依赖交换链图像（如引用了 swapchainImageViews 或相应帧缓冲）的条目，每次重建都失效
+// 2. 其余条目仅在交换链图像的尺寸或格式改变时失效（如录制时写死了视口大小）
+class staticCommandCache {
+public:
+    using recordFunction_t =
+        std::function<void(VkCommandBuffer commandBuffer, uint32_t variantIndex)>;
+    struct cacheStatistics {
+        uint64_t recordCount;  // 实际录制的次数
+        uint64_t reuseCount;   // 直接复用已录制命令缓冲区的次数
+    };
+
+private:
+    struct entry {
+        recordFunction_t record;
+        bool swapchainImageDependent;
+        VkCommandBufferLevel level;
+        VkCommandBufferInheritanceInfo inheritanceInfo;  // 仅对二级命令缓冲区有效
+        std::vector<VkCommandBuffer> commandBuffers;     // 下标为变体索引
+        std::vector<uint8_t> dirtyFlags;
+    };
+    // 单独重录某个变体需要单独重置命令缓冲区，所以带 RESET_COMMAND_BUFFER_BIT
+    commandPool pool;
+    uint32_t variantCount = 0;
+    std::vector<entry> entries;
+    cacheStatistics statistics = {};
+
+    static std::vector<staticCommandCache*>& Caches()
+    {
+        static std::vector<staticCommandCache*> caches;
+        return caches;
+    }
+    static VkExtent2D& SwapchainExtent()
+    {
+        static VkExtent2D extent;
+        return extent;
+    }
+    static VkFormat& SwapchainFormat()
+    {
+        static VkFormat format;
+        return format;
+    }
+    static void OnDestroySwapchain()
+    {
+        // 交换链图像视图即将销毁，引用它们的命令缓冲区不可再提交
+        for (auto cache : Caches())
+            for (auto& i : cache->entries)
+                if (i.swapchainImageDependent) std::ranges::fill(i.dirtyFlags, true);
+    }
+    static void OnCreateSwapchain()
+    {
+        const VkSwapchainCreateInfoKHR& createInfo = graphicsBase::Base().SwapchainCreateInfo();
+        if (createInfo.imageExtent.width == SwapchainExtent().width &&
+            createInfo.imageExtent.height == SwapchainExtent().height &&
+            createInfo.imageFormat == SwapchainFormat())
+            return;
+        SwapchainExtent() = createInfo.imageExtent;
+        SwapchainFormat() = createInfo.imageFormat;
+        for (auto cache : Caches()) cache->MarkAllDirty();
+    }
+
+public:
+    staticCommandCache()
+    {
+        static bool callbacksAdded = false;
+        if (!callbacksAdded) {
+            graphicsBase::Base().AddCallback_DestroySwapchain(OnDestroySwapchain);
+            graphicsBase::Base().AddCallback_CreateSwapchain(OnCreateSwapchain);
+            SwapchainExtent() = graphicsBase::Base().SwapchainCreateInfo().imageExtent;
+            SwapchainFormat() = graphicsBase::Base().SwapchainCreateInfo().imageFormat;
+            callbacksAdded = true;
+        }
+        Caches().push_back(this);
+    }
+    staticCommandCache(uint32_t variantCount, uint32_t queueFamilyIndex) : staticCommandCache()
+    {
+        Create(variantCount, queueFamilyIndex);
+    }
+    staticCommandCache(staticCommandCache&&) = delete;
+    ~staticCommandCache()
+    {
+        std::erase(Caches(), this);
+    }
+    // Getter
+    uint32_t VariantCount() const
+    {
+        return variantCount;
+    }
+    uint32_t EntryCount() const
+    {
+        return uint32_t(entries.size());
+    }
+    const cacheStatistics& Statistics() const
+    {
+        return statistics;
+    }
+    bool IsDirty(uint32_t entryIndex, uint32_t variantIndex) const
+    {
+        return entries[entryIndex].dirtyFlags[variantIndex];
+    }
+    // Non-const Function
+    VkResult Create(uint32_t variantCount, uint32_t queueFamilyIndex)
+    {
+        this->variantCount = variantCount;
+        entries.clear();
+        statistics = {};
+        return pool.Create(queueFamilyIndex, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    }
+    // 添加一个条目，返回其索引，命令会在首次取用时录制
+    // 提供 pInheritanceInfo 则录制为二级命令缓冲区，在 render pass 中通过 vkCmdExecuteCommands 执行
+    // 其 pNext 链需在缓存的生命周期内保持有效
+    uint32_t Add(recordFunction_t record, bool swapchainImageDependent = false,
+                 const VkCommandBufferInheritanceInfo* pInheritanceInfo = nullptr)
+    {
+        entries.push_back({.record = std::move(record),
+                           .swapchainImageDependent = swapchainImageDependent,
+                           .level = pInheritanceInfo ? VK_COMMAND_BUFFER_LEVEL_SECONDARY
+                                                     : VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                           .inheritanceInfo = pInheritanceInfo ? *pInheritanceInfo
+                                                               : VkCommandBufferInheritanceInfo {},
+                           .commandBuffers = std::vector<VkCommandBuffer>(variantCount),
+                           .dirtyFlags = std::vector<uint8_t>(variantCount, true)});
+        return uint32_t(entries.size() - 1);
+    }
+    // 例如 render pass 因格式改变而重建后，更新二级命令缓冲区的继承信息，并标记为 dirty
+    void InheritanceInfo(uint32_t entryIndex, const VkCommandBufferInheritanceInfo& inheritanceInfo)
+    {
+        entries[entryIndex].inheritanceInfo = inheritanceInfo;
+        MarkDirty(entryIndex);
+    }
+    // 内容改变时调用，各变体会在下次取用时重新录制
+    void MarkDirty(uint32_t entryIndex)
+    {
+        std::ranges::fill(entries[entryIndex].dirtyFlags, true);
+    }
+    void MarkAllDirty()
+    {
+        for (uint32_t i = 0; i < entries.size(); i++) MarkDirty(i);
+    }
+    // 取用前需确保该变体的命令缓冲区已执行完毕（例如已等待对应帧的 fence），否则不可重录
+    // 失败时返回 VK_NULL_HANDLE
+    VkCommandBuffer CommandBuffer(uint32_t entryIndex, uint32_t variantIndex)
+    {
+        entry& item = entries[entryIndex];
+        VkCommandBuffer& handle = item.commandBuffers[variantIndex];
+        if (!item.dirtyFlags[variantIndex]) {
+            statistics.reuseCount++;
+            return handle;
+        }
+        if (!handle && pool.AllocateBuffers({&handle, 1}, item.level)) return VK_NULL_HANDLE;
+        // 不带 ONE_TIME_SUBMIT_BIT，录制一次可提交多次
+        commandBuffer buffer(handle);
+        VkResult result = item.level == VK_COMMAND_BUFFER_LEVEL_SECONDARY
+                              ? buffer.Begin(VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+                                             item.inheritanceInfo)
+                              : buffer.Begin();
+        if (result) return VK_NULL_HANDLE;
+        item.record(handle, variantIndex);
+        if (buffer.End()) return VK_NULL_HANDLE;
+        item.dirtyFlags[variantIndex] = false;
+        statistics.recordCount++;
+        return handle;
+    }
+};
+}  // namespace vulkan
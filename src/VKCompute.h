@@ -0,0 +1,703 @@
+#pragma once
+#include "VKDescriptor.h"
+#include "VKShaderReflection.h"
+
+namespace vulkan {
+// 计算用的存储缓冲区，优先使用设备本地的内存
+// 该内存同时为主机可见时（集成显卡、lavapipe 等），computeContext 直接映射读写，否则经由暂存缓冲区
+class computeBufferBase {
+protected:
+    buffer storageBuffer;
+    deviceMemory memory;
+    VkDeviceSize size = 0;
+
+public:
+    computeBufferBase() = default;
+    computeBufferBase(computeBufferBase&&) = default;
+    // Getter
+    operator VkBuffer() const
+    {
+        return storageBuffer;
+    }
+    VkDeviceSize Size() const
+    {
+        return size;
+    }
+    bool HostVisible() const
+    {
+        return memory.MemoryProperties() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    }
+    const deviceMemory& Memory() const
+    {
+        return memory;
+    }
+    // Non-const Function
+    // 除 STORAGE_BUFFER 与传输用途外，可由 usage 追加其他用途，如 UNIFORM_BUFFER、INDIRECT_BUFFER
+    // hostVisible 为 true 时要求主机可见的内存，用作暂存缓冲区
+    VkResult Create(VkDeviceSize size, VkBufferUsageFlags usage = 0, bool hostVisible = false)
+    {
+        VkBufferCreateInfo createInfo = {.size = size,
+                                         .usage = usage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                                  VK_BUFFER_USAGE_TRANSFER_DST_BIT};
+        if (VkResult result = storageBuffer.Create(createInfo)) return result;
+        VkMemoryRequirements memoryRequirements = storageBuffer.MemoryRequirements();
+        graphicsBase& base = graphicsBase::Base();
+        VkMemoryAllocateInfo allocateInfo = {
+            .allocationSize = memoryRequirements.size,
+            .memoryTypeIndex = base.MemoryTypeIndex(memoryRequirements.memoryTypeBits,
+                                                    hostVisible
+                                                        ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                                                        : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)};
+        if (allocateInfo.memoryTypeIndex == UINT32_MAX && !hostVisible)
+            allocateInfo.memoryTypeIndex =
+                base.MemoryTypeIndex(memoryRequirements.memoryTypeBits, 0);
+        if (VkResult result = memory.Allocate(allocateInfo)) return result;
+        if (VkResult result = storageBuffer.BindMemory(memory)) return result;
+        this->size = size;
+        return VK_SUCCESS;
+    }
+};
+
+// 元素类型为 T 的存储缓冲区，T 的内存布局须与着色器中的 std430 布局一致
+template <typename T>
+class computeBuffer : public computeBufferBase {
+public:
+    computeBuffer() = default;
+    computeBuffer(computeBuffer&&) = default;
+    // Getter
+    size_t Count() const
+    {
+        return size_t(size / sizeof(T));
+    }
+    // Non-const Function
+    VkResult Create(size_t count, VkBufferUsageFlags usage = 0, bool hostVisible = false)
+    {
+        return computeBufferBase::Create(VkDeviceSize(count * sizeof(T)), usage, hostVisible);
+    }
+};
+
+// 计算用的二维存储图像，首次被 computeContext 使用时转到 VK_IMAGE_LAYOUT_GENERAL，此后不再转换
+class computeImage {
+    friend class computeContext;
+    image storageImage;
+    deviceMemory memory;
+    imageView view;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent = {};
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+public:
+    computeImage() = default;
+    computeImage(computeImage&&) = default;
+    // Getter
+    operator VkImage() const
+    {
+        return storageImage;
+    }
+    VkImageView View() const
+    {
+        return view;
+    }
+    VkFormat Format() const
+    {
+        return format;
+    }
+    VkExtent2D Extent() const
+    {
+        return extent;
+    }
+    // Non-const Function
+    // 除 STORAGE 与传输用途外，可由 usage 追加 SAMPLED 等用途
+    VkResult Create(VkFormat format, VkExtent2D extent, VkImageUsageFlags usage = 0)
+    {
+        VkImageCreateInfo createInfo = {
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = format,
+            .extent = {extent.width, extent.height, 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = usage | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                     VK_IMAGE_USAGE_TRANSFER_DST_BIT};
+        if (VkResult result = storageImage.Create(createInfo)) return result;
+        if (VkResult result = memory.Allocate(storageImage.MemoryRequirements(),
+                                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+            return result;
+        if (VkResult result = storageImage.BindMemory(memory)) return result;
+        if (VkResult result = view.Create(storageImage, VK_IMAGE_VIEW_TYPE_2D, format,
+                                          {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}))
+            return result;
+        this->format = format;
+        this->extent = extent;
+        layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        return VK_SUCCESS;
+    }
+};
+
+// 计算核：一个计算着色器及由其反射得到的管线布局
+// 描述符类型、推送常量范围、工作组大小均取自反射结果，dispatch 时只需给出绑定的资源
+class computeKernel {
+    spirvReflection reflection = {};
+    VkPipelineLayout layout = VK_NULL_HANDLE;  // 由 pipelineLayoutCache 持有
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    pipeline computePipeline;
+
+public:
+    computeKernel() = default;
+    computeKernel(computeKernel&&) = default;
+    // Getter
+    operator VkPipeline() const
+    {
+        return computePipeline;
+    }
+    VkPipelineLayout Layout() const
+    {
+        return layout;
+    }
+    std::span<const VkDescriptorSetLayout> SetLayouts() const
+    {
+        return setLayouts;
+    }
+    const spirvReflection& Reflection() const
+    {
+        return reflection;
+    }
+    // Const Function
+    // 覆盖 count 个元素（或像素）所需的工作组数
+    uint32_t GroupCount(uint32_t count, uint32_t dimension = 0) const
+    {
+        uint32_t localSize = std::max(reflection.workgroupSize[dimension], 1u);
+        return (count + localSize - 1) / localSize;
+    }
+    // 找到 (set, binding) 的描述符类型，未被着色器使用时返回 VK_DESCRIPTOR_TYPE_MAX_ENUM
+    VkDescriptorType DescriptorType(uint32_t set, uint32_t binding) const
+    {
+        for (auto& i : reflection.bindings)
+            if (i.set == set && i.binding == binding) return i.descriptorType;
+        return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    }
+    // Non-const Function
+    // 工作组大小由特化常量决定时，可由 pLocalSize 指定三个维度的大小，
+    // 例如 computeAutotuner::Base().Variant(name).localSize
+    VkResult Create(std::span<const uint32_t> code, const uint32_t* pLocalSize = nullptr,
+                    VkPipelineCache cache = VK_NULL_HANDLE)
+    {
+        if (VkResult result = shaderReflection::Base().Reflect(code, reflection)) return result;
+        if (reflection.stage != VK_SHADER_STAGE_COMPUTE_BIT) {
+            std::cout << std::format("[ computeKernel ] ERROR\nNot a compute shader!\n");
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        // 计算核的资源总是经由描述符集绑定，即便 descriptorBackend 使用描述符缓冲区
+        if (VkResult result = shaderReflection::CreatePipelineLayout({&reflection, 1}, layout,
+                                                                     setLayouts, 1024, true))
+            return result;
+        VkSpecializationMapEntry mapEntries[3];
+        uint32_t mapEntryCount = 0;
+        if (pLocalSize)
+            for (uint32_t i = 0; i < 3; i++)
+                if (reflection.workgroupSizeSpecIds[i] != UINT32_MAX) {
+                    mapEntries[mapEntryCount++] = {reflection.workgroupSizeSpecIds[i],
+                                                   uint32_t(i * sizeof(uint32_t)),
+                                                   sizeof(uint32_t)};
+                    reflection.workgroupSize[i] = pLocalSize[i];
+                }
+        VkSpecializationInfo specializationInfo = {.mapEntryCount = mapEntryCount,
+                                                   .pMapEntries = mapEntries,
+                                                   .dataSize = 3 * sizeof(uint32_t),
+                                                   .pData = pLocalSize};
+        VkShaderModuleCreateInfo moduleCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .codeSize = code.size_bytes(),
+            .pCode = code.data()};
+        VkShaderModule module;
+        VkDevice device = graphicsBase::Base().Device();
+        if (VkResult result = vkCreateShaderModule(device, &moduleCreateInfo, nullptr, &module)) {
+            std::cout << std::format(
+                "[ computeKernel ] ERROR\nFailed to create a shader module!\nError code: {}\n",
+                int32_t(result));
+            return result;
+        }
+        VkComputePipelineCreateInfo createInfo = {
+            .stage = {.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                      .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                      .module = module,
+                      .pName = "main",
+                      .pSpecializationInfo = mapEntryCount ? &specializationInfo : nullptr},
+            .layout = layout};
+        VkResult result = computePipeline.Create(createInfo, cache);
+        vkDestroyShaderModule(device, module, nullptr);
+        return result;
+    }
+};
+
+// dispatch 时绑定到某个 (set, binding) 的资源，描述符类型由 computeKernel 的反射结果决定
+struct computeBinding {
+    uint32_t set;
+    uint32_t binding;
+    VkDescriptorBufferInfo bufferInfo;
+    computeImage* pImage;
+    VkSampler sampler;
+    //--------------------
+    static computeBinding Buffer(uint32_t binding, const computeBufferBase& buffer,
+                                 uint32_t set = 0)
+    {
+        return {set, binding, {buffer, 0, VK_WHOLE_SIZE}, nullptr, VK_NULL_HANDLE};
+    }
+    // 用于 COMBINED_IMAGE_SAMPLER 时须提供 sampler
+    static computeBinding Image(uint32_t binding, computeImage& image, uint32_t set = 0,
+                                VkSampler sampler = VK_NULL_HANDLE)
+    {
+        return {set, binding, {}, &image, sampler};
+    }
+};
+
+// 仅使用计算队列的 GPGPU 框架，不需要窗口、交换链、图形队列，可在无显示器的服务器与 lavapipe 上运行
+// 无窗口时的初始化顺序：CreateInstance、GetPhysicalDevices、
+// DeterminePhysicalDevice(index, false, true)、CreateDevice，然后 computeContext::Create
+// 1. Dispatch 录制并提交一次 dispatch 后等待其完成，DispatchAsync 只提交，返回时间线上的值
+//    多个 dispatch 可经由 Begin、CmdDispatch、Submit 录制在一个命令缓冲区中
+// 2. 每个命令缓冲区开头与每次 CmdDispatch 后有一个全局的内存屏障，
+//    先后录制或提交的 dispatch 依次执行，后者可读取前者的结果
+// 3. Write/Read 在主机与计算缓冲区、图像间传输数据，Read 会先等待所有已提交的工作完成
+// 需开启 timelineSemaphore 特性（Vulkan 1.2），非线程安全
+class computeContext {
+    struct submission {
+        VkCommandBuffer commandBuffer;
+        uint64_t value;
+        std::vector<computeBufferBase> stagingBuffers;  // 完成后释放
+    };
+    VkQueue queue = VK_NULL_HANDLE;
+    uint32_t queueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    commandPool pool;
+    timelineSemaphore semaphore;
+    uint64_t lastSubmittedValue = 0;
+    uint64_t completedValue = 0;
+    descriptorAllocator descriptorSets;
+    std::vector<submission> submissions;        // 未完成的提交，按提交顺序
+    std::vector<VkCommandBuffer> freeCommandBuffers;
+    uint32_t recordingCount = 0;  // 经由 Begin 开始录制、尚未 Submit 的命令缓冲区个数
+
+    //--------------------
+    // 取得一个已重置的命令缓冲区并开始录制，调用前应先 Collect，开头录制全局的内存屏障
+    VkResult BeginCommandBuffer(VkCommandBuffer& commandBuffer)
+    {
+        if (freeCommandBuffers.empty()) {
+            if (VkResult result = pool.AllocateBuffers({&commandBuffer, 1})) return result;
+        } else {
+            commandBuffer = freeCommandBuffers.back();
+            freeCommandBuffers.pop_back();
+        }
+        if (VkResult result = vkResetCommandBuffer(commandBuffer, 0)) {
+            freeCommandBuffers.push_back(commandBuffer);
+            return result;
+        }
+        VkCommandBufferBeginInfo beginInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        CmdBarrier(commandBuffer);
+        return VK_SUCCESS;
+    }
+    // 结束录制并提交，完成时时间线置为 value
+    // 末尾的屏障使写入对主机可见，以便直接映射主机可见的计算缓冲区读取结果
+    VkResult EndAndSubmit(VkCommandBuffer commandBuffer, uint64_t& value,
+                          std::vector<computeBufferBase>&& stagingBuffers = {})
+    {
+        VkMemoryBarrier memoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_HOST_READ_BIT};
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0,
+                             nullptr);
+        VkResult result = vkEndCommandBuffer(commandBuffer);
+        if (!result) {
+            value = lastSubmittedValue + 1;
+            VkTimelineSemaphoreSubmitInfo timelineSubmitInfo = {
+                .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                .signalSemaphoreValueCount = 1,
+                .pSignalSemaphoreValues = &value};
+            VkSubmitInfo submitInfo = {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                                       .pNext = &timelineSubmitInfo,
+                                       .commandBufferCount = 1,
+                                       .pCommandBuffers = &commandBuffer,
+                                       .signalSemaphoreCount = 1,
+                                       .pSignalSemaphores = semaphore.Address()};
+            result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+        }
+        if (result) {
+            std::cout << std::format(
+                "[ computeContext ] ERROR\nFailed to submit a command buffer!\nError code: {}\n",
+                int32_t(result));
+            freeCommandBuffers.push_back(commandBuffer);
+            return result;
+        }
+        lastSubmittedValue = value;
+        submissions.push_back({commandBuffer, value, std::move(stagingBuffers)});
+        return VK_SUCCESS;
+    }
+    // 首次使用图像时将其转到 GENERAL 布局
+    static void CmdPrepareImage(VkCommandBuffer commandBuffer, computeImage& image)
+    {
+        if (image.layout == VK_IMAGE_LAYOUT_GENERAL) return;
+        VkImageMemoryBarrier imageMemoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+                             VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+            .oldLayout = image.layout,
+            .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = image,
+            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+        image.layout = VK_IMAGE_LAYOUT_GENERAL;
+    }
+    // 分配描述符集并按反射得到的描述符类型写入 bindings
+    VkResult WriteDescriptorSets(const computeKernel& kernel,
+                                 std::span<const computeBinding> bindings,
+                                 std::vector<VkDescriptorSet>& sets)
+    {
+        sets.resize(kernel.SetLayouts().size());
+        if (!sets.empty())
+            if (VkResult result = descriptorSets.Allocate(sets, kernel.SetLayouts())) return result;
+        std::vector<VkDescriptorImageInfo> imageInfos(bindings.size());
+        std::vector<VkWriteDescriptorSet> writes;
+        for (size_t i = 0; i < bindings.size(); i++) {
+            const computeBinding& binding = bindings[i];
+            VkDescriptorType type = kernel.DescriptorType(binding.set, binding.binding);
+            bool isImage = type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
+                           type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
+                           type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            if (type == VK_DESCRIPTOR_TYPE_MAX_ENUM || isImage != bool(binding.pImage)) {
+                std::cout << std::format(
+                    "[ computeContext ] ERROR\nSet {} binding {} is not used by the kernel or "
+                    "doesn't match the resource!\n",
+                    binding.set, binding.binding);
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+            if (isImage)
+                imageInfos[i] = {binding.sampler, binding.pImage->View(), VK_IMAGE_LAYOUT_GENERAL};
+            writes.push_back({.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                              .dstSet = sets[binding.set],
+                              .dstBinding = binding.binding,
+                              .descriptorCount = 1,
+                              .descriptorType = type,
+                              .pImageInfo = isImage ? &imageInfos[i] : nullptr,
+                              .pBufferInfo = isImage ? nullptr : &binding.bufferInfo});
+        }
+        vkUpdateDescriptorSets(graphicsBase::Base().Device(), uint32_t(writes.size()),
+                               writes.data(), 0, nullptr);
+        return VK_SUCCESS;
+    }
+    static VkResult CopyToMemory(const deviceMemory& memory, const void* pData,
+                                 VkDeviceSize size, VkDeviceSize offset)
+    {
+        void* pMapped;
+        if (VkResult result = memory.MapMemory(pMapped, size, offset)) return result;
+        memcpy(pMapped, pData, size_t(size));
+        return memory.UnmapMemory(size, offset);
+    }
+    static VkResult CopyFromMemory(const deviceMemory& memory, void* pData, VkDeviceSize size,
+                                   VkDeviceSize offset)
+    {
+        void* pMapped;
+        if (VkResult result = memory.MapMemory(pMapped, size, offset)) return result;
+        memcpy(pData, pMapped, size_t(size));
+        vkUnmapMemory(graphicsBase::Base().Device(), memory);
+        return VK_SUCCESS;
+    }
+
+public:
+    computeContext() = default;
+    computeContext(computeContext&&) = default;
+    ~computeContext()
+    {
+        if (semaphore) Wait(lastSubmittedValue);
+    }
+    // Getter
+    VkQueue Queue() const
+    {
+        return queue;
+    }
+    uint32_t QueueFamilyIndex() const
+    {
+        return queueFamilyIndex;
+    }
+    uint64_t LastSubmittedValue() const
+    {
+        return lastSubmittedValue;
+    }
+    // Non-const Function
+    // 释放已完成的提交所占用的命令缓冲区与暂存缓冲区，没有未完成的提交与录制时回收描述符集
+    VkResult Collect()
+    {
+        if (submissions.empty()) return VK_SUCCESS;
+        if (VkResult result = semaphore.Value(completedValue)) return result;
+        auto completed = std::ranges::find_if(
+            submissions, [this](const submission& i) { return i.value > completedValue; });
+        for (auto i = submissions.begin(); i != completed; ++i)
+            freeCommandBuffers.push_back(i->commandBuffer);
+        submissions.erase(submissions.begin(), completed);
+        if (submissions.empty() && !recordingCount) return descriptorSets.Reset();
+        return VK_SUCCESS;
+    }
+    bool IsComplete(uint64_t value)
+    {
+        if (value > completedValue) Collect();
+        return value <= completedValue;
+    }
+    // 阻塞直到时间线上的 value 完成，超时返回 VK_TIMEOUT
+    VkResult Wait(uint64_t value, uint64_t timeout = UINT64_MAX)
+    {
+        if (value <= completedValue) return VK_SUCCESS;
+        if (VkResult result = semaphore.Wait(value, timeout)) return result;
+        return Collect();
+    }
+    VkResult WaitAll(uint64_t timeout = UINT64_MAX)
+    {
+        return Wait(lastSubmittedValue, timeout);
+    }
+    // 将多个操作录制到一个命令缓冲区，以一次提交执行：Begin，若干次 CmdDispatch、CmdFill，Submit
+    // 录制失败时以 Abandon 放弃该命令缓冲区
+    VkResult Begin(VkCommandBuffer& commandBuffer)
+    {
+        // 先回收，以免回收描述符集时连同此次录制中分配的一并回收
+        if (VkResult result = Collect()) return result;
+        if (VkResult result = BeginCommandBuffer(commandBuffer)) return result;
+        recordingCount++;
+        return VK_SUCCESS;
+    }
+    VkResult Submit(VkCommandBuffer commandBuffer, uint64_t& value)
+    {
+        recordingCount--;
+        return EndAndSubmit(commandBuffer, value);
+    }
+    void Abandon(VkCommandBuffer commandBuffer)
+    {
+        recordingCount--;
+        vkEndCommandBuffer(commandBuffer);
+        freeCommandBuffers.push_back(commandBuffer);
+    }
+    // 录制一次 dispatch，其后的屏障使此后录制的命令可读取其结果
+    // pushConstants 的大小不超过着色器中推送常量块的大小
+    VkResult CmdDispatch(VkCommandBuffer commandBuffer, const computeKernel& kernel,
+                         std::span<const computeBinding> bindings,
+                         std::array<uint32_t, 3> groupCount,
+                         std::span<const uint8_t> pushConstants = {})
+    {
+        std::vector<VkDescriptorSet> sets;
+        if (VkResult result = WriteDescriptorSets(kernel, bindings, sets)) return result;
+        for (auto& i : bindings)
+            if (i.pImage) CmdPrepareImage(commandBuffer, *i.pImage);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, kernel);
+        if (!sets.empty())
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                    kernel.Layout(), 0, uint32_t(sets.size()), sets.data(), 0,
+                                    nullptr);
+        const spirvReflection& reflection = kernel.Reflection();
+        if (!pushConstants.empty() && reflection.pushConstantSize)
+            vkCmdPushConstants(
+                commandBuffer, kernel.Layout(), VK_SHADER_STAGE_COMPUTE_BIT,
+                reflection.pushConstantOffset,
+                std::min(uint32_t(pushConstants.size()), reflection.pushConstantSize),
+                pushConstants.data());
+        vkCmdDispatch(commandBuffer, groupCount[0], groupCount[1], groupCount[2]);
+        CmdBarrier(commandBuffer);
+        return VK_SUCCESS;
+    }
+    template <typename T>
+    VkResult CmdDispatch(VkCommandBuffer commandBuffer, const computeKernel& kernel,
+                         std::span<const computeBinding> bindings,
+                         std::array<uint32_t, 3> groupCount, const T& pushConstants)
+    {
+        return CmdDispatch(commandBuffer, kernel, bindings, groupCount,
+                           {reinterpret_cast<const uint8_t*>(&pushConstants), sizeof(T)});
+    }
+    // 录制一次 dispatch 并提交，value 为其完成时时间线上的值
+    VkResult DispatchAsync(const computeKernel& kernel, std::span<const computeBinding> bindings,
+                           std::array<uint32_t, 3> groupCount, uint64_t& value,
+                           std::span<const uint8_t> pushConstants = {})
+    {
+        VkCommandBuffer commandBuffer;
+        if (VkResult result = Begin(commandBuffer)) return result;
+        if (VkResult result =
+                CmdDispatch(commandBuffer, kernel, bindings, groupCount, pushConstants)) {
+            Abandon(commandBuffer);
+            return result;
+        }
+        return Submit(commandBuffer, value);
+    }
+    template <typename T>
+    VkResult DispatchAsync(const computeKernel& kernel, std::span<const computeBinding> bindings,
+                           std::array<uint32_t, 3> groupCount, uint64_t& value,
+                           const T& pushConstants)
+    {
+        return DispatchAsync(kernel, bindings, groupCount, value,
+                             {reinterpret_cast<const uint8_t*>(&pushConstants), sizeof(T)});
+    }
+    // 同步版本，返回时结果已写入
+    VkResult Dispatch(const computeKernel& kernel, std::span<const computeBinding> bindings,
+                      std::array<uint32_t, 3> groupCount,
+                      std::span<const uint8_t> pushConstants = {})
+    {
+        uint64_t value;
+        if (VkResult result = DispatchAsync(kernel, bindings, groupCount, value, pushConstants))
+            return result;
+        return Wait(value);
+    }
+    template <typename T>
+    VkResult Dispatch(const computeKernel& kernel, std::span<const computeBinding> bindings,
+                      std::array<uint32_t, 3> groupCount, const T& pushConstants)
+    {
+        return Dispatch(kernel, bindings, groupCount,
+                        {reinterpret_cast<const uint8_t*>(&pushConstants), sizeof(T)});
+    }
+    // 将数据写入计算缓冲区的 [offset, offset + size)
+    // 主机可见的缓冲区会先等待所有已提交的工作完成再直接写入，否则经由暂存缓冲区异步复制
+    VkResult Write(const computeBufferBase& buffer, const void* pData, VkDeviceSize size,
+                   VkDeviceSize offset = 0)
+    {
+        if (buffer.HostVisible()) {
+            if (VkResult result = WaitAll()) return result;
+            return CopyToMemory(buffer.Memory(), pData, size, offset);
+        }
+        if (VkResult result = Collect()) return result;
+        std::vector<computeBufferBase> stagingBuffers(1);
+        if (VkResult result = stagingBuffers[0].Create(size, 0, true)) return result;
+        if (VkResult result = CopyToMemory(stagingBuffers[0].Memory(), pData, size, 0))
+            return result;
+        VkCommandBuffer commandBuffer;
+        if (VkResult result = BeginCommandBuffer(commandBuffer)) return result;
+        VkBufferCopy region = {0, offset, size};
+        vkCmdCopyBuffer(commandBuffer, stagingBuffers[0], buffer, 1, &region);
+        uint64_t value;
+        return EndAndSubmit(commandBuffer, value, std::move(stagingBuffers));
+    }
+    template <typename T>
+    VkResult Write(const computeBuffer<T>& buffer, std::span<const T> data, size_t firstIndex = 0)
+    {
+        return Write(buffer, data.data(), data.size_bytes(), firstIndex * sizeof(T));
+    }
+    // 等待所有已提交的工作完成后，读取计算缓冲区的 [offset, offset + size)
+    VkResult Read(const computeBufferBase& buffer, void* pData, VkDeviceSize size,
+                  VkDeviceSize offset = 0)
+    {
+        if (buffer.HostVisible()) {
+            if (VkResult result = WaitAll()) return result;
+            return CopyFromMemory(buffer.Memory(), pData, size, offset);
+        }
+        if (VkResult result = Collect()) return result;
+        computeBufferBase stagingBuffer;
+        if (VkResult result = stagingBuffer.Create(size, 0, true)) return result;
+        VkCommandBuffer commandBuffer;
+        if (VkResult result = BeginCommandBuffer(commandBuffer)) return result;
+        VkBufferCopy region = {offset, 0, size};
+        vkCmdCopyBuffer(commandBuffer, buffer, stagingBuffer, 1, &region);
+        uint64_t value;
+        if (VkResult result = EndAndSubmit(commandBuffer, value)) return result;
+        if (VkResult result = Wait(value)) return result;
+        return CopyFromMemory(stagingBuffer.Memory(), pData, size, 0);
+    }
+    template <typename T>
+    VkResult Read(const computeBuffer<T>& buffer, std::span<T> data, size_t firstIndex = 0)
+    {
+        return Read(buffer, data.data(), data.size_bytes(), firstIndex * sizeof(T));
+    }
+    // 以紧密排列的像素数据写入整个图像，size 须为图像的数据大小
+    VkResult Write(computeImage& image, const void* pData, VkDeviceSize size)
+    {
+        if (VkResult result = Collect()) return result;
+        std::vector<computeBufferBase> stagingBuffers(1);
+        if (VkResult result = stagingBuffers[0].Create(size, 0, true)) return result;
+        if (VkResult result = CopyToMemory(stagingBuffers[0].Memory(), pData, size, 0))
+            return result;
+        VkCommandBuffer commandBuffer;
+        if (VkResult result = BeginCommandBuffer(commandBuffer)) return result;
+        CmdPrepareImage(commandBuffer, image);
+        VkBufferImageCopy region = {.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+                                    .imageExtent = {image.extent.width, image.extent.height, 1}};
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffers[0], image, VK_IMAGE_LAYOUT_GENERAL,
+                               1, &region);
+        uint64_t value;
+        return EndAndSubmit(commandBuffer, value, std::move(stagingBuffers));
+    }
+    // 等待所有已提交的工作完成后，以紧密排列的像素数据读取整个图像
+    VkResult Read(computeImage& image, void* pData, VkDeviceSize size)
+    {
+        if (VkResult result = Collect()) return result;
+        computeBufferBase stagingBuffer;
+        if (VkResult result = stagingBuffer.Create(size, 0, true)) return result;
+        VkCommandBuffer commandBuffer;
+        if (VkResult result = BeginCommandBuffer(commandBuffer)) return result;
+        CmdPrepareImage(commandBuffer, image);
+        VkBufferImageCopy region = {.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+                                    .imageExtent = {image.extent.width, image.extent.height, 1}};
+        vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, stagingBuffer, 1,
+                               &region);
+        uint64_t value;
+        if (VkResult result = EndAndSubmit(commandBuffer, value)) return result;
+        if (VkResult result = Wait(value)) return result;
+        return CopyFromMemory(stagingBuffer.Memory(), pData, size, 0);
+    }
+    // Static Function
+    // 全局的内存屏障，使此前的着色器与传输写入对此后的着色器与传输命令可见
+    static void CmdBarrier(VkCommandBuffer commandBuffer)
+    {
+        VkMemoryBarrier memoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+                             VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT};
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+    // 以 data 填充缓冲区，size 为 VK_WHOLE_SIZE 或 4 的倍数
+    static void CmdFill(VkCommandBuffer commandBuffer, const computeBufferBase& buffer,
+                        uint32_t data, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE)
+    {
+        vkCmdFillBuffer(commandBuffer, buffer, offset, size, data);
+        CmdBarrier(commandBuffer);
+    }
+    // Non-const Function
+    // 在计算队列上创建，没有单独的计算队列时使用图形队列
+    // initialSetCount 为描述符池初始可容纳的描述符集个数
+    VkResult Create(uint32_t initialSetCount = 64)
+    {
+        graphicsBase& base = graphicsBase::Base();
+        if (!base.PhysicalDeviceVulkan12Features().timelineSemaphore) {
+            std::cout << std::format(
+                "[ computeContext ] ERROR\nThe timelineSemaphore feature is not enabled!\n");
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        queueFamilyIndex = base.QueueFamilyIndex_Compute();
+        queue = base.Queue_Compute();
+        if (!queue) {
+            queueFamilyIndex = base.QueueFamilyIndex_Graphics();
+            queue = base.Queue_Graphics();
+        }
+        if (!queue) {
+            std::cout << std::format("[ computeContext ] ERROR\nNo queue supports compute!\n");
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        if (VkResult result =
+                pool.Create(queueFamilyIndex, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT))
+            return result;
+        if (VkResult result = semaphore.Create()) return result;
+        static constexpr descriptorAllocator::poolSizeRatio poolSizeRatios[] = {
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4.f},
+            {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.f},
+            {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2.f},
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.f}};
+        descriptorSets.Create(initialSetCount, poolSizeRatios);
+        return VK_SUCCESS;
+    }
+};
+}  // namespace vulkan
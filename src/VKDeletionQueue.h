@@ -0,0 +1,184 @@
+#pragma once
+#include "VKSubmit.h"
+
+namespace vulkan {
+// 延迟销毁队列：待销毁的对象连同其最后一次被使用时的时刻一起入队，等 GPU 执行过该时刻后再成批销毁
+// 时刻可以是 submissionScheduler 中某个队列的时间线值，也可以是由调用方维护的帧序号
+// 这样销毁对象前无需 vkDeviceWaitIdle 或 vkQueueWaitIdle，可在一帧中途安全地释放资源
+class deletionQueue {
+    struct pendingObject {
+        uint64_t value;     // 时间线值或帧序号
+        VkObjectType type;  // 为 VK_OBJECT_TYPE_UNKNOWN 时执行 function
+        uint64_t handle;    // 非分发句柄在 32 位平台上都是 uint64_t，统一按 uint64_t 保存
+        std::function<void()> function;
+    };
+    // 同一来源的值单调递增，所以每个来源一个先进先出队列，销毁时只需检查队头
+    // 第 0 个为帧序号，其后依次对应 submissionScheduler 中的各个队列
+    std::vector<std::deque<pendingObject>> sources;
+    std::mutex mutex;
+    uint64_t pendingCount = 0;
+    uint64_t destroyedCount = 0;
+    static constexpr uint32_t frameSource = UINT32_MAX;
+
+    //--------------------
+    deletionQueue() = default;
+    deletionQueue(deletionQueue&&) = delete;
+    // Non-const Function
+    std::deque<pendingObject>& Source(uint32_t sourceIndex)
+    {
+        // 首次使用时注册回调，销毁逻辑设备前（此时设备已空闲）销毁所有对象
+        static bool callbackAdded = false;
+        if (!callbackAdded) {
+            graphicsBase::Base().AddCallback_DestroyDevice([] { Base().DestroyAll(); });
+            callbackAdded = true;
+        }
+        if (sources.empty()) sources.resize(1);
+        uint32_t index = sourceIndex == frameSource ? 0 : sourceIndex + 1;
+        if (index >= sources.size()) sources.resize(index + 1);
+        return sources[index];
+    }
+    void Push(uint32_t sourceIndex, pendingObject&& object)
+    {
+        std::lock_guard lock(mutex);
+        Source(sourceIndex).push_back(std::move(object));
+        pendingCount++;
+    }
+    // 将队头所有值不大于 completedValue 的对象移入 ready，须持有 mutex
+    void Collect(std::deque<pendingObject>& source, uint64_t completedValue,
+                 std::vector<pendingObject>& ready)
+    {
+        while (!source.empty() && source.front().value <= completedValue) {
+            ready.push_back(std::move(source.front()));
+            source.pop_front();
+            pendingCount--;
+            destroyedCount++;
+        }
+    }
+    // Static Function
+    // 不持有 mutex 时调用，回调函数中可以再 Push
+    static void Destroy(std::vector<pendingObject>& ready)
+    {
+        VkDevice device = graphicsBase::Base().Device();
+        for (auto& i : ready) Destroy(device, i);
+    }
+    static void Destroy(VkDevice device, pendingObject& object)
+    {
+        // 句柄在 64 位平台上是指针，在 32 位平台上是 uint64_t，reinterpret_cast 对二者都适用
+#define DestroyHandle(objectType, function, handleType)                         \
+    case objectType:                                                            \
+        function(device, reinterpret_cast<handleType>(object.handle), nullptr); \
+        break
+        switch (object.type) {
+            DestroyHandle(VK_OBJECT_TYPE_BUFFER, vkDestroyBuffer, VkBuffer);
+            DestroyHandle(VK_OBJECT_TYPE_BUFFER_VIEW, vkDestroyBufferView, VkBufferView);
+            DestroyHandle(VK_OBJECT_TYPE_IMAGE, vkDestroyImage, VkImage);
+            DestroyHandle(VK_OBJECT_TYPE_IMAGE_VIEW, vkDestroyImageView, VkImageView);
+            DestroyHandle(VK_OBJECT_TYPE_SAMPLER, vkDestroySampler, VkSampler);
+            DestroyHandle(VK_OBJECT_TYPE_DEVICE_MEMORY, vkFreeMemory, VkDeviceMemory);
+            DestroyHandle(VK_OBJECT_TYPE_PIPELINE, vkDestroyPipeline, VkPipeline);
+            DestroyHandle(VK_OBJECT_TYPE_PIPELINE_LAYOUT, vkDestroyPipelineLayout,
+                          VkPipelineLayout);
+            DestroyHandle(VK_OBJECT_TYPE_PIPELINE_CACHE, vkDestroyPipelineCache, VkPipelineCache);
+            DestroyHandle(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, vkDestroyDescriptorSetLayout,
+                          VkDescriptorSetLayout);
+            DestroyHandle(VK_OBJECT_TYPE_DESCRIPTOR_POOL, vkDestroyDescriptorPool,
+                          VkDescriptorPool);
+            DestroyHandle(VK_OBJECT_TYPE_FRAMEBUFFER, vkDestroyFramebuffer, VkFramebuffer);
+            DestroyHandle(VK_OBJECT_TYPE_RENDER_PASS, vkDestroyRenderPass, VkRenderPass);
+            DestroyHandle(VK_OBJECT_TYPE_SHADER_MODULE, vkDestroyShaderModule, VkShaderModule);
+            DestroyHandle(VK_OBJECT_TYPE_COMMAND_POOL, vkDestroyCommandPool, VkCommandPool);
+            DestroyHandle(VK_OBJECT_TYPE_SEMAPHORE, vkDestroySemaphore, VkSemaphore);
+            DestroyHandle(VK_OBJECT_TYPE_FENCE, vkDestroyFence, VkFence);
+            DestroyHandle(VK_OBJECT_TYPE_EVENT, vkDestroyEvent, VkEvent);
+            DestroyHandle(VK_OBJECT_TYPE_QUERY_POOL, vkDestroyQueryPool, VkQueryPool);
+            DestroyHandle(VK_OBJECT_TYPE_SWAPCHAIN_KHR, vkDestroySwapchainKHR, VkSwapchainKHR);
+            case VK_OBJECT_TYPE_UNKNOWN:
+                object.function();
+                break;
+            default:
+                std::cout << std::format(
+                    "[ deletionQueue ] ERROR\nUnsupported object type: {}\n", int32_t(object.type));
+        }
+#undef DestroyHandle
+    }
+
+public:
+    // Getter
+    uint64_t PendingCount() const
+    {
+        return pendingCount;
+    }
+    uint64_t DestroyedCount() const
+    {
+        return destroyedCount;
+    }
+    // Non-const Function
+    // 对象在 point 所在批次中最后一次被使用，该批次执行完毕后销毁
+    // handle 需转为 uint64_t，如 Push(VK_OBJECT_TYPE_BUFFER, uint64_t(buffer), point)
+    void Push(VkObjectType type, uint64_t handle, submissionScheduler::timelinePoint point)
+    {
+        Push(point.queueIndex, {.value = point.value, .type = type, .handle = handle});
+    }
+    // 对象在第 frameNumber 帧中最后一次被使用，帧序号由调用方维护，需单调递增
+    void Push(VkObjectType type, uint64_t handle, uint64_t frameNumber)
+    {
+        Push(frameSource, {.value = frameNumber, .type = type, .handle = handle});
+    }
+    // 用于无法以单个句柄描述的清理，如需要先解除映射再释放的内存
+    void Push(std::function<void()> function, submissionScheduler::timelinePoint point)
+    {
+        Push(point.queueIndex, {.value = point.value,
+                                .type = VK_OBJECT_TYPE_UNKNOWN,
+                                .function = std::move(function)});
+    }
+    void Push(std::function<void()> function, uint64_t frameNumber)
+    {
+        Push(frameSource, {.value = frameNumber,
+                           .type = VK_OBJECT_TYPE_UNKNOWN,
+                           .function = std::move(function)});
+    }
+    // 销毁 scheduler 各队列上已执行完毕的批次所关联的对象，每个队列只查询一次时间线的值
+    // 建议每帧调用一次
+    void Collect(submissionScheduler& scheduler)
+    {
+        std::vector<pendingObject> ready;
+        {
+            std::lock_guard lock(mutex);
+            for (uint32_t i = 1; i < sources.size(); i++)
+                if (!sources[i].empty())
+                    Collect(sources[i], scheduler.CompletedValue(i - 1), ready);
+        }
+        Destroy(ready);
+    }
+    // 销毁所有帧序号不大于 completedFrameNumber 的对象，如在等待某帧的 fence 后调用
+    void Collect(uint64_t completedFrameNumber)
+    {
+        std::vector<pendingObject> ready;
+        {
+            std::lock_guard lock(mutex);
+            if (!sources.empty()) Collect(sources[0], completedFrameNumber, ready);
+        }
+        Destroy(ready);
+    }
+    // 立即销毁所有对象，调用前需确保设备空闲
+    // 回调函数在此期间 Push 的对象同样会被销毁
+    void DestroyAll()
+    {
+        std::vector<pendingObject> ready;
+        do {
+            ready.clear();
+            {
+                std::lock_guard lock(mutex);
+                for (auto& i : sources) Collect(i, UINT64_MAX, ready);
+            }
+            Destroy(ready);
+        } while (!ready.empty());
+    }
+    // Static Function
+    static deletionQueue& Base()
+    {
+        static deletionQueue singleton;
+        return singleton;
+    }
+};
+}  // namespace vulkan
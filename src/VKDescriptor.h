@@ -0,0 +1,192 @@
+#pragma once
+#include "VKBase.h"
+
+namespace vulkan {
+// 按描述符类型的配比创建描述符池，从池的列表中分配描述符集
+// 1. 当前池空间不足（VK_ERROR_OUT_OF_POOL_MEMORY）时换用下一个池，没有可用的池则新建，
+//    新建的池的容量逐次增长，直至 maxSetCountPerPool
+// 2. 不单独释放描述符集，而是在使用它们的帧执行完毕后以 Reset 整池回收，回收后的池留待复用
+// 非线程安全，多线程录制时每个线程使用各自的分配器，见 frameDescriptorAllocator
+class descriptorAllocator {
+public:
+    // 平均每个描述符集含有 ratio 个 type 类型的描述符
+    struct poolSizeRatio {
+        VkDescriptorType type;
+        float ratio;
+    };
+    // 适用于一般材质与后处理的配比
+    static constexpr poolSizeRatio defaultPoolSizeRatios[] = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f}};
+    static constexpr uint32_t maxSetCountPerPool = 4096;
+    static constexpr float growthFactor = 1.5f;
+
+private:
+    std::vector<poolSizeRatio> poolSizeRatios;
+    VkDescriptorPoolCreateFlags poolFlags = 0;
+    uint32_t setCountPerPool = 0;  // 下一个新建的池可容纳的描述符集个数
+    std::vector<descriptorPool> pools;
+    std::vector<uint32_t> poolSetCounts;  // 各个池可容纳的描述符集个数
+    size_t currentPoolIndex = 0;  // 在此之前的池已满，自 Reset 后未被使用的池在其后
+    bool currentPoolUsed = false;
+    uint32_t allocatedSetCount = 0;  // 自上次 Reset 后分配的描述符集个数
+
+    //--------------------
+    VkResult CreatePool()
+    {
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for (auto& i : poolSizeRatios)
+            poolSizes.push_back({i.type, std::max(uint32_t(i.ratio * setCountPerPool), 1u)});
+        if (VkResult result = pools.emplace_back().Create(setCountPerPool, poolSizes, poolFlags)) {
+            pools.pop_back();
+            return result;
+        }
+        poolSetCounts.push_back(setCountPerPool);
+        setCountPerPool = std::min(uint32_t(setCountPerPool * growthFactor), maxSetCountPerPool);
+        return VK_SUCCESS;
+    }
+
+public:
+    descriptorAllocator() = default;
+    descriptorAllocator(descriptorAllocator&&) = default;
+    // Getter
+    uint32_t PoolCount() const
+    {
+        return uint32_t(pools.size());
+    }
+    uint32_t AllocatedSetCount() const
+    {
+        return allocatedSetCount;
+    }
+    // Non-const Function
+    // initialSetCountPerPool 为第一个池可容纳的描述符集个数，池在首次分配时创建
+    void Create(uint32_t initialSetCountPerPool,
+                std::span<const poolSizeRatio> poolSizeRatios = defaultPoolSizeRatios,
+                VkDescriptorPoolCreateFlags poolFlags = 0)
+    {
+        this->poolSizeRatios.assign(poolSizeRatios.begin(), poolSizeRatios.end());
+        this->poolFlags = poolFlags;
+        setCountPerPool = std::clamp(initialSetCountPerPool, 1u, maxSetCountPerPool);
+    }
+    VkResult Allocate(std::span<VkDescriptorSet> sets,
+                      std::span<const VkDescriptorSetLayout> setLayouts,
+                      const void* pNext = nullptr)
+    {
+        if (!setCountPerPool) {
+            std::cout << std::format(
+                "[ descriptorAllocator ] ERROR\nThe allocator is not created!\n");
+            return VK_RESULT_MAX_ENUM;
+        }
+        while (true) {
+            if (currentPoolIndex == pools.size())
+                if (VkResult result = CreatePool()) return result;
+            VkResult result = pools[currentPoolIndex].AllocateSets(sets, setLayouts, pNext);
+            if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+                // 空池放不下时，换用其后（更大的）池或新建更大的池；
+                // 最大的空池也放不下，说明一次分配的描述符过多或配比与实际用途不符
+                if (!currentPoolUsed && currentPoolIndex + 1 == pools.size() &&
+                    poolSetCounts[currentPoolIndex] >= setCountPerPool) {
+                    std::cout << std::format(
+                        "[ descriptorAllocator ] ERROR\nDescriptor sets don't fit in an empty "
+                        "pool, check the pool size ratios!\n");
+                    return result;
+                }
+                currentPoolIndex++;
+                currentPoolUsed = false;
+                continue;
+            }
+            if (result) return result;
+            currentPoolUsed = true;
+            allocatedSetCount += uint32_t(sets.size());
+            return VK_SUCCESS;
+        }
+    }
+    VkResult Allocate(VkDescriptorSetLayout setLayout, VkDescriptorSet& set,
+                      const void* pNext = nullptr)
+    {
+        return Allocate({&set, 1}, {&setLayout, 1}, pNext);
+    }
+    // 整池回收所有描述符集，调用前需确保它们不再被使用
+    VkResult Reset()
+    {
+        for (size_t i = 0; i <= currentPoolIndex && i < pools.size(); i++)
+            if (VkResult result = pools[i].Reset()) return result;
+        currentPoolIndex = 0;
+        currentPoolUsed = false;
+        allocatedSetCount = 0;
+        return VK_SUCCESS;
+    }
+    void Destroy()
+    {
+        pools.clear();
+        poolSetCounts.clear();
+        currentPoolIndex = 0;
+        currentPoolUsed = false;
+        allocatedSetCount = 0;
+    }
+};
+
+// 每个 (飞行中的帧, 录制线程) 组合独占一个 descriptorAllocator
+// 各线程只从自己的分配器中分配，无需加锁；帧开始时整帧回收，与 commandPoolManager 的用法一致
+class frameDescriptorAllocator {
+    uint32_t frameCount = 0;
+    uint32_t threadCount = 0;
+    uint32_t currentFrameIndex = 0;
+    std::vector<descriptorAllocator> allocators;  // 下标为 frameIndex * threadCount + threadIndex
+
+public:
+    frameDescriptorAllocator() = default;
+    frameDescriptorAllocator(frameDescriptorAllocator&&) = default;
+    // Getter
+    uint32_t CurrentFrameIndex() const
+    {
+        return currentFrameIndex;
+    }
+    // 所有分配器中的池的总数
+    uint32_t PoolCount() const
+    {
+        uint32_t count = 0;
+        for (auto& i : allocators) count += i.PoolCount();
+        return count;
+    }
+    // Non-const Function
+    void Create(uint32_t frameCount, uint32_t threadCount, uint32_t initialSetCountPerPool,
+                std::span<const descriptorAllocator::poolSizeRatio> poolSizeRatios =
+                    descriptorAllocator::defaultPoolSizeRatios,
+                VkDescriptorPoolCreateFlags poolFlags = 0)
+    {
+        this->frameCount = frameCount;
+        this->threadCount = threadCount;
+        currentFrameIndex = 0;
+        allocators.clear();
+        allocators.resize(size_t(frameCount) * threadCount);
+        for (auto& i : allocators) i.Create(initialSetCountPerPool, poolSizeRatios, poolFlags);
+    }
+    // 切换到第 frameIndex 帧，并回收该帧此前分配的所有描述符集
+    // 调用前需确保该帧上一轮提交的命令已执行完毕，如在 commandPoolManager::BeginFrame 之后调用
+    VkResult BeginFrame(uint32_t frameIndex)
+    {
+        currentFrameIndex = frameIndex;
+        for (uint32_t i = 0; i < threadCount; i++)
+            if (VkResult result = Allocator(i).Reset()) return result;
+        return VK_SUCCESS;
+    }
+    // 当前帧中第 threadIndex 个线程的分配器
+    descriptorAllocator& Allocator(uint32_t threadIndex)
+    {
+        return allocators[size_t(currentFrameIndex) * threadCount + threadIndex];
+    }
+    VkResult Allocate(uint32_t threadIndex, VkDescriptorSetLayout setLayout, VkDescriptorSet& set,
+                      const void* pNext = nullptr)
+    {
+        return Allocator(threadIndex).Allocate(setLayout, set, pNext);
+    }
+    void Destroy()
+    {
+        allocators.clear();
+        frameCount = threadCount = currentFrameIndex = 0;
+    }
+};
+}  // namespace vulkan
@@ -0,0 +1,438 @@
+#pragma once
+#include "VKDescriptor.h"
+#include "VKObjectCache.h"
+
+namespace vulkan {
+// 描述符的管理方式，在创建逻辑设备时根据设备能力确定
+// 1. backend_descriptorBuffer：VK_EXT_descriptor_buffer，描述符由 vkGetDescriptorEXT 直接写入
+//    映射的缓冲区，以偏移量绑定，不经过描述符池和 vkUpdateDescriptorSets
+// 2. backend_descriptorSet：不支持上述扩展时，使用描述符池分配描述符集
+// 仅在 Vulkan 1.3 的设备上使用描述符缓冲区，以使其依赖的 bufferDeviceAddress、synchronization2
+// 和描述符索引都是核心功能，lavapipe 等软件实现也支持该扩展
+class descriptorBackend {
+public:
+    enum backend_t : uint32_t {
+        backend_descriptorSet,
+        backend_descriptorBuffer
+    };
+
+private:
+    backend_t backend = backend_descriptorSet;
+    bool extensionAdded = false;
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT};
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT};
+    PFN_vkGetDescriptorSetLayoutSizeEXT pVkGetDescriptorSetLayoutSizeEXT = nullptr;
+    PFN_vkGetDescriptorSetLayoutBindingOffsetEXT pVkGetDescriptorSetLayoutBindingOffsetEXT =
+        nullptr;
+    PFN_vkGetDescriptorEXT pVkGetDescriptorEXT = nullptr;
+    PFN_vkCmdBindDescriptorBuffersEXT pVkCmdBindDescriptorBuffersEXT = nullptr;
+    PFN_vkCmdSetDescriptorBufferOffsetsEXT pVkCmdSetDescriptorBufferOffsetsEXT = nullptr;
+
+    //--------------------
+    descriptorBackend() = default;
+    descriptorBackend(descriptorBackend&&) = delete;
+    // Non-const Function
+    void OnCreateDevice()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        backend = backend_descriptorSet;
+        if (!extensionAdded || !descriptorBufferFeatures.descriptorBuffer ||
+            !base.PhysicalDeviceVulkan12Features().bufferDeviceAddress)
+            return;
+        auto Load = [device = base.Device()]<typename T>(T& function, const char* name) {
+            function = reinterpret_cast<T>(vkGetDeviceProcAddr(device, name));
+            return function != nullptr;
+        };
+        if (!Load(pVkGetDescriptorSetLayoutSizeEXT, "vkGetDescriptorSetLayoutSizeEXT") ||
+            !Load(pVkGetDescriptorSetLayoutBindingOffsetEXT,
+                  "vkGetDescriptorSetLayoutBindingOffsetEXT") ||
+            !Load(pVkGetDescriptorEXT, "vkGetDescriptorEXT") ||
+            !Load(pVkCmdBindDescriptorBuffersEXT, "vkCmdBindDescriptorBuffersEXT") ||
+            !Load(pVkCmdSetDescriptorBufferOffsetsEXT, "vkCmdSetDescriptorBufferOffsetsEXT"))
+            return;
+        VkPhysicalDeviceProperties2 properties2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &descriptorBufferProperties};
+        vkGetPhysicalDeviceProperties2(base.PhysicalDevice(), &properties2);
+        backend = backend_descriptorBuffer;
+    }
+
+public:
+    // Getter
+    // 逻辑设备创建后有效
+    backend_t Backend() const
+    {
+        return backend;
+    }
+    bool UseDescriptorBuffer() const
+    {
+        return backend == backend_descriptorBuffer;
+    }
+    const VkPhysicalDeviceDescriptorBufferPropertiesEXT& DescriptorBufferProperties() const
+    {
+        return descriptorBufferProperties;
+    }
+    // 使用描述符缓冲区时，管线需以此标记创建
+    VkPipelineCreateFlags PipelineCreateFlags() const
+    {
+        return UseDescriptorBuffer() ? VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : 0;
+    }
+    // 使用描述符缓冲区时，被描述符引用的缓冲区需要有设备地址
+    VkBufferUsageFlags BufferUsage() const
+    {
+        return UseDescriptorBuffer() ? VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT : 0;
+    }
+    // Const Function
+    // 各类型的描述符在描述符缓冲区中所占的字节数
+    size_t DescriptorSize(VkDescriptorType type) const
+    {
+        const auto& p = descriptorBufferProperties;
+        switch (type) {
+            case VK_DESCRIPTOR_TYPE_SAMPLER:
+                return p.samplerDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                return p.combinedImageSamplerDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+                return p.sampledImageDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+                return p.storageImageDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+                return p.uniformTexelBufferDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+                return p.storageTexelBufferDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+                return p.uniformBufferDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+                return p.storageBufferDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                return p.inputAttachmentDescriptorSize;
+            default:
+                return 0;
+        }
+    }
+    VkDeviceSize SetLayoutSize(VkDescriptorSetLayout setLayout) const
+    {
+        VkDeviceSize size = 0;
+        pVkGetDescriptorSetLayoutSizeEXT(graphicsBase::Base().Device(), setLayout, &size);
+        return size;
+    }
+    VkDeviceSize BindingOffset(VkDescriptorSetLayout setLayout, uint32_t binding) const
+    {
+        VkDeviceSize offset = 0;
+        pVkGetDescriptorSetLayoutBindingOffsetEXT(graphicsBase::Base().Device(), setLayout,
+                                                  binding, &offset);
+        return offset;
+    }
+    void GetDescriptor(const VkDescriptorGetInfoEXT& getInfo, size_t dataSize,
+                       void* pDescriptor) const
+    {
+        pVkGetDescriptorEXT(graphicsBase::Base().Device(), &getInfo, dataSize, pDescriptor);
+    }
+    void CmdBindDescriptorBuffers(
+        VkCommandBuffer commandBuffer,
+        std::span<const VkDescriptorBufferBindingInfoEXT> bindingInfos) const
+    {
+        pVkCmdBindDescriptorBuffersEXT(commandBuffer, uint32_t(bindingInfos.size()),
+                                       bindingInfos.data());
+    }
+    void CmdSetDescriptorBufferOffsets(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint,
+                                       VkPipelineLayout pipelineLayout, uint32_t firstSet,
+                                       std::span<const uint32_t> bufferIndices,
+                                       std::span<const VkDeviceSize> offsets) const
+    {
+        pVkCmdSetDescriptorBufferOffsetsEXT(commandBuffer, bindPoint, pipelineLayout, firstSet,
+                                            uint32_t(offsets.size()), bufferIndices.data(),
+                                            offsets.data());
+    }
+    // Non-const Function
+    // 在 DeterminePhysicalDevice 后、CreateDevice 前调用
+    // 设备支持时添加 VK_EXT_descriptor_buffer 并链接其特性结构体，否则之后使用描述符集
+    // preferDescriptorBuffer 为 false 时总是使用描述符集
+    void Enable(bool preferDescriptorBuffer = true)
+    {
+        graphicsBase& base = graphicsBase::Base();
+        static bool callbackAdded = false;
+        if (!callbackAdded) {
+            base.AddCallback_CreateDevice([] { Base().OnCreateDevice(); });
+            callbackAdded = true;
+        }
+        extensionAdded = false;
+        if (!preferDescriptorBuffer || base.DeviceApiVersion() < VK_API_VERSION_1_3) return;
+        const char* extensionNames[] = {VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME};
+        if (base.CheckDeviceExtensions(extensionNames) || !extensionNames[0]) return;
+        base.AddDeviceExtension(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+        base.AddNextStructure_PhysicalDeviceFeatures(descriptorBufferFeatures);
+        extensionAdded = true;
+    }
+    // 经由 descriptorSetLayoutCache 创建描述符集布局，使用描述符缓冲区时补上所需的标记
+    VkResult SetLayout(VkDescriptorSetLayoutCreateInfo createInfo,
+                       VkDescriptorSetLayout& setLayout) const
+    {
+        if (UseDescriptorBuffer())
+            createInfo.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+        return descriptorSetLayoutCache::Base().Get(createInfo, setLayout);
+    }
+    // Static Function
+    static descriptorBackend& Base()
+    {
+        static descriptorBackend singleton;
+        return singleton;
+    }
+};
+
+// 每帧重新分配的描述符，按 descriptorBackend 所确定的方式存放
+// 1. 使用描述符缓冲区时，一块常驻映射的缓冲区被划分为每个飞行中的帧一个区域，
+//    分配只是移动区域中的偏移量，写入由 vkGetDescriptorEXT 直接完成
+// 2. 使用描述符集时，每帧一个 descriptorAllocator，写入经由 vkUpdateDescriptorSets
+// 描述符集布局需经由 descriptorBackend::SetLayout 创建
+class frameDescriptorSets {
+public:
+    // 对调用方而言不透明的描述符集，仅对应方式下的成员有效
+    struct setHandle {
+        VkDescriptorSetLayout setLayout;
+        VkDescriptorSet set;  // 使用描述符集时
+        VkDeviceSize offset;  // 使用描述符缓冲区时，相对于当前帧区域起始的偏移量
+    };
+
+private:
+    struct setLayoutInfo {
+        VkDeviceSize size;
+        std::map<uint32_t, VkDeviceSize> bindingOffsets;
+    };
+    uint32_t frameCount = 0;
+    uint32_t currentFrameIndex = 0;
+    // 描述符缓冲区
+    buffer descriptorBuffer;
+    deviceMemory descriptorBufferMemory;
+    uint8_t* pMappedData = nullptr;
+    VkDeviceAddress bufferAddress = 0;
+    VkDeviceSize regionSize = 0;  // 每帧的区域的大小
+    VkDeviceSize usedSize = 0;    // 当前帧的区域中已分配的大小
+    std::unordered_map<VkDescriptorSetLayout, setLayoutInfo> setLayoutInfos;
+    // 描述符集
+    std::vector<descriptorAllocator> allocators;
+
+    //--------------------
+    setLayoutInfo& SetLayoutInfo(VkDescriptorSetLayout setLayout)
+    {
+        auto [it, inserted] = setLayoutInfos.try_emplace(setLayout);
+        if (inserted) it->second.size = descriptorBackend::Base().SetLayoutSize(setLayout);
+        return it->second;
+    }
+    // 描述符在当前帧区域的映射内存中的地址
+    void* DescriptorAddress(const setHandle& set, uint32_t binding, uint32_t arrayElement,
+                            VkDescriptorType type)
+    {
+        auto& bindingOffsets = SetLayoutInfo(set.setLayout).bindingOffsets;
+        auto [it, inserted] = bindingOffsets.try_emplace(binding);
+        if (inserted)
+            it->second = descriptorBackend::Base().BindingOffset(set.setLayout, binding);
+        return pMappedData + currentFrameIndex * regionSize + set.offset + it->second +
+               arrayElement * descriptorBackend::Base().DescriptorSize(type);
+    }
+
+public:
+    frameDescriptorSets() = default;
+    frameDescriptorSets(frameDescriptorSets&&) = default;
+    // Getter
+    // 当前帧的区域中已分配的字节数，仅在使用描述符缓冲区时有意义
+    VkDeviceSize UsedSize() const
+    {
+        return usedSize;
+    }
+    // Non-const Function
+    // descriptorBufferSizePerFrame 为使用描述符缓冲区时每帧的区域的大小
+    // setCountPerPool 和 poolSizeRatios 用于使用描述符集时的 descriptorAllocator
+    VkResult Create(uint32_t frameCount, VkDeviceSize descriptorBufferSizePerFrame = 1 << 20,
+                    uint32_t setCountPerPool = 64,
+                    std::span<const descriptorAllocator::poolSizeRatio> poolSizeRatios =
+                        descriptorAllocator::defaultPoolSizeRatios)
+    {
+        Destroy();
+        this->frameCount = frameCount;
+        if (!descriptorBackend::Base().UseDescriptorBuffer()) {
+            allocators.clear();
+            allocators.resize(frameCount);
+            for (auto& i : allocators) i.Create(setCountPerPool, poolSizeRatios);
+            return VK_SUCCESS;
+        }
+        // 绑定的地址须对齐到 descriptorBufferOffsetAlignment，所以每帧的区域大小也按其对齐
+        VkDeviceSize alignment =
+            descriptorBackend::Base().DescriptorBufferProperties().descriptorBufferOffsetAlignment;
+        regionSize = (descriptorBufferSizePerFrame + alignment - 1) / alignment * alignment;
+        VkBufferCreateInfo bufferCreateInfo = {
+            .size = regionSize * frameCount,
+            .usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT |
+                     VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT |
+                     VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT};
+        if (VkResult result = descriptorBuffer.Create(bufferCreateInfo)) return result;
+        VkMemoryRequirements memoryRequirements = descriptorBuffer.MemoryRequirements();
+        // 优先使用设备本地且主机可见的内存
+        uint32_t memoryTypeIndex = graphicsBase::Base().MemoryTypeIndex(
+            memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (memoryTypeIndex == UINT32_MAX)
+            memoryTypeIndex = graphicsBase::Base().MemoryTypeIndex(
+                memoryRequirements.memoryTypeBits,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        VkMemoryAllocateFlagsInfo allocateFlagsInfo = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+            .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT};
+        VkMemoryAllocateInfo allocateInfo = {.pNext = &allocateFlagsInfo,
+                                             .allocationSize = memoryRequirements.size,
+                                             .memoryTypeIndex = memoryTypeIndex};
+        if (VkResult result = descriptorBufferMemory.Allocate(allocateInfo)) return result;
+        if (VkResult result = descriptorBuffer.BindMemory(descriptorBufferMemory)) return result;
+        // 常驻映射，直至销毁
+        void* pData;
+        if (VkResult result = descriptorBufferMemory.MapMemory(pData, VK_WHOLE_SIZE))
+            return result;
+        pMappedData = static_cast<uint8_t*>(pData);
+        bufferAddress = descriptorBuffer.DeviceAddress();
+        return VK_SUCCESS;
+    }
+    // 切换到第 frameIndex 帧，并回收该帧此前分配的所有描述符
+    // 调用前需确保该帧上一轮提交的命令已执行完毕
+    VkResult BeginFrame(uint32_t frameIndex)
+    {
+        currentFrameIndex = frameIndex;
+        usedSize = 0;
+        if (!descriptorBackend::Base().UseDescriptorBuffer())
+            return allocators[frameIndex].Reset();
+        return VK_SUCCESS;
+    }
+    VkResult Allocate(VkDescriptorSetLayout setLayout, setHandle& set)
+    {
+        set = {.setLayout = setLayout};
+        if (!descriptorBackend::Base().UseDescriptorBuffer())
+            return allocators[currentFrameIndex].Allocate(setLayout, set.set);
+        VkDeviceSize alignment =
+            descriptorBackend::Base().DescriptorBufferProperties().descriptorBufferOffsetAlignment;
+        VkDeviceSize offset = (usedSize + alignment - 1) / alignment * alignment;
+        VkDeviceSize size = SetLayoutInfo(setLayout).size;
+        if (offset + size > regionSize) {
+            std::cout << std::format(
+                "[ frameDescriptorSets ] ERROR\nRun out of descriptor buffer space for this "
+                "frame!\nRegion size: {}\n",
+                regionSize);
+            return VK_ERROR_OUT_OF_POOL_MEMORY;
+        }
+        set.offset = offset;
+        usedSize = offset + size;
+        return VK_SUCCESS;
+    }
+    // 写入缓冲区类的描述符（uniform / storage 缓冲区）
+    // 使用描述符缓冲区时，buffer 需以 descriptorBackend::BufferUsage() 中的用途创建
+    void WriteBuffer(const setHandle& set, uint32_t binding, uint32_t arrayElement,
+                     VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset,
+                     VkDeviceSize range)
+    {
+        if (!descriptorBackend::Base().UseDescriptorBuffer()) {
+            VkDescriptorBufferInfo bufferInfo = {buffer, offset, range};
+            VkWriteDescriptorSet write = {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                                          .dstSet = set.set,
+                                          .dstBinding = binding,
+                                          .dstArrayElement = arrayElement,
+                                          .descriptorCount = 1,
+                                          .descriptorType = type,
+                                          .pBufferInfo = &bufferInfo};
+            vkUpdateDescriptorSets(graphicsBase::Base().Device(), 1, &write, 0, nullptr);
+            return;
+        }
+        VkBufferDeviceAddressInfo addressInfo = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO, .buffer = buffer};
+        VkDescriptorAddressInfoEXT descriptorAddressInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT,
+            .address =
+                vkGetBufferDeviceAddress(graphicsBase::Base().Device(), &addressInfo) + offset,
+            .range = range};
+        VkDescriptorGetInfoEXT getInfo = {.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+                                          .type = type};
+        if (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+            getInfo.data.pUniformBuffer = &descriptorAddressInfo;
+        else
+            getInfo.data.pStorageBuffer = &descriptorAddressInfo;
+        descriptorBackend::Base().GetDescriptor(
+            getInfo, descriptorBackend::Base().DescriptorSize(type),
+            DescriptorAddress(set, binding, arrayElement, type));
+    }
+    // 写入图像类的描述符（采样器、带采样器的图像、sampled image、storage image）
+    void WriteImage(const setHandle& set, uint32_t binding, uint32_t arrayElement,
+                    VkDescriptorType type, VkImageView view, VkSampler sampler,
+                    VkImageLayout layout)
+    {
+        VkDescriptorImageInfo imageInfo = {sampler, view, layout};
+        if (!descriptorBackend::Base().UseDescriptorBuffer()) {
+            VkWriteDescriptorSet write = {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                                          .dstSet = set.set,
+                                          .dstBinding = binding,
+                                          .dstArrayElement = arrayElement,
+                                          .descriptorCount = 1,
+                                          .descriptorType = type,
+                                          .pImageInfo = &imageInfo};
+            vkUpdateDescriptorSets(graphicsBase::Base().Device(), 1, &write, 0, nullptr);
+            return;
+        }
+        VkDescriptorGetInfoEXT getInfo = {.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+                                          .type = type};
+        switch (type) {
+            case VK_DESCRIPTOR_TYPE_SAMPLER:
+                getInfo.data.pSampler = &sampler;
+                break;
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                getInfo.data.pCombinedImageSampler = &imageInfo;
+                break;
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+                getInfo.data.pSampledImage = &imageInfo;
+                break;
+            default:
+                getInfo.data.pStorageImage = &imageInfo;
+        }
+        descriptorBackend::Base().GetDescriptor(
+            getInfo, descriptorBackend::Base().DescriptorSize(type),
+            DescriptorAddress(set, binding, arrayElement, type));
+    }
+    // 使用描述符缓冲区时绑定当前帧的区域，每个命令缓冲区在 Bind 前调用一次
+    void BindBuffers(VkCommandBuffer commandBuffer) const
+    {
+        if (!descriptorBackend::Base().UseDescriptorBuffer()) return;
+        VkDescriptorBufferBindingInfoEXT bindingInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT,
+            .address = bufferAddress + currentFrameIndex * regionSize,
+            .usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT |
+                     VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT};
+        descriptorBackend::Base().CmdBindDescriptorBuffers(commandBuffer, {&bindingInfo, 1});
+    }
+    // 将 set 绑定到 firstSet，使用描述符缓冲区时只设置偏移量
+    void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint,
+              VkPipelineLayout pipelineLayout, uint32_t firstSet, const setHandle& set) const
+    {
+        if (!descriptorBackend::Base().UseDescriptorBuffer()) {
+            vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, firstSet, 1,
+                                    &set.set, 0, nullptr);
+            return;
+        }
+        uint32_t bufferIndex = 0;
+        descriptorBackend::Base().CmdSetDescriptorBufferOffsets(
+            commandBuffer, bindPoint, pipelineLayout, firstSet, {&bufferIndex, 1},
+            {&set.offset, 1});
+    }
+    // 销毁所有资源，调用前需确保设备不再使用它们
+    void Destroy()
+    {
+        if (pMappedData) vkUnmapMemory(graphicsBase::Base().Device(), descriptorBufferMemory);
+        pMappedData = nullptr;
+        // 移出到临时对象，由其析构函数销毁
+        buffer(std::move(descriptorBuffer));
+        deviceMemory(std::move(descriptorBufferMemory));
+        setLayoutInfos.clear();
+        allocators.clear();
+        frameCount = currentFrameIndex = 0;
+        regionSize = usedSize = 0;
+        bufferAddress = 0;
+    }
+};
+}  // namespace vulkan
@@ -0,0 +1,175 @@
+#pragma once
+#include "VKBase.h"
+
+namespace vulkan {
+// 动态渲染：录制时直接指定附件的 image view，不需要 VkRenderPass 与 VkFramebuffer
+// 重建交换链时只需换用新的 swapchainImageViews，无需为每张交换链图像重建帧缓冲
+// 设备支持 Vulkan 1.3 时使用核心功能，否则使用 VK_KHR_dynamic_rendering 扩展
+class dynamicRendering {
+    bool enabled = false;
+    bool useExtension = false;  // 是否经由 VK_KHR_dynamic_rendering 使用
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR};
+    PFN_vkCmdBeginRenderingKHR pVkCmdBeginRenderingKHR = nullptr;
+    PFN_vkCmdEndRenderingKHR pVkCmdEndRenderingKHR = nullptr;
+
+    //--------------------
+    dynamicRendering() = default;
+    dynamicRendering(dynamicRendering&&) = delete;
+    // Non-const Function
+    // 逻辑设备创建后，确认特性是否已开启，使用扩展时取得函数指针
+    void OnCreateDevice()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        if (!useExtension) {
+            enabled = base.PhysicalDeviceVulkan13Features().dynamicRendering;
+            return;
+        }
+        pVkCmdBeginRenderingKHR = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+            vkGetDeviceProcAddr(base.Device(), "vkCmdBeginRenderingKHR"));
+        pVkCmdEndRenderingKHR = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+            vkGetDeviceProcAddr(base.Device(), "vkCmdEndRenderingKHR"));
+        enabled = dynamicRenderingFeatures.dynamicRendering && pVkCmdBeginRenderingKHR &&
+                  pVkCmdEndRenderingKHR;
+    }
+
+public:
+    // Getter
+    // 逻辑设备创建后有效
+    bool Enabled() const
+    {
+        return enabled;
+    }
+    bool UseExtension() const
+    {
+        return useExtension;
+    }
+    // Const Function
+    void BeginRendering(VkCommandBuffer commandBuffer, const VkRenderingInfo& renderingInfo) const
+    {
+        useExtension ? pVkCmdBeginRenderingKHR(commandBuffer, &renderingInfo)
+                     : vkCmdBeginRendering(commandBuffer, &renderingInfo);
+    }
+    void EndRendering(VkCommandBuffer commandBuffer) const
+    {
+        useExtension ? pVkCmdEndRenderingKHR(commandBuffer) : vkCmdEndRendering(commandBuffer);
+    }
+    // 将交换链图像转换到颜色附件布局，并开始以其为唯一颜色附件的动态渲染
+    // 提交时，等待获取图像的信号量的阶段应为 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+    // 深度模板附件等由调用方在 pDepthAttachment、pStencilAttachment 中指定
+    void BeginRendering_Swapchain(
+        VkCommandBuffer commandBuffer, uint32_t imageIndex, const VkClearColorValue& clearColor,
+        const VkRenderingAttachmentInfo* pDepthAttachment = nullptr,
+        const VkRenderingAttachmentInfo* pStencilAttachment = nullptr) const
+    {
+        graphicsBase& base = graphicsBase::Base();
+        // 不需要保留图像的原有内容，以 VK_IMAGE_LAYOUT_UNDEFINED 作为旧布局
+        VkImageMemoryBarrier imageMemoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = base.SwapchainImage(imageIndex),
+            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr, 0,
+                             nullptr, 1, &imageMemoryBarrier);
+        VkRenderingAttachmentInfo colorAttachment = {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .imageView = base.SwapchainImageView(imageIndex),
+            .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .clearValue = {.color = clearColor}};
+        VkRenderingInfo renderingInfo = {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+            .renderArea = {{}, base.SwapchainCreateInfo().imageExtent},
+            .layerCount = 1,
+            .colorAttachmentCount = 1,
+            .pColorAttachments = &colorAttachment,
+            .pDepthAttachment = pDepthAttachment,
+            .pStencilAttachment = pStencilAttachment};
+        BeginRendering(commandBuffer, renderingInfo);
+    }
+    // 结束动态渲染，并将交换链图像转换到呈现所需的布局
+    void EndRendering_Swapchain(VkCommandBuffer commandBuffer, uint32_t imageIndex) const
+    {
+        EndRendering(commandBuffer);
+        VkImageMemoryBarrier imageMemoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = graphicsBase::Base().SwapchainImage(imageIndex),
+            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &imageMemoryBarrier);
+    }
+    // Non-const Function
+    // 在 DeterminePhysicalDevice 后、CreateDevice 前调用
+    // 设备支持 Vulkan 1.3 时，CreateDevice 会自动开启 dynamicRendering 特性
+    // 否则添加 VK_KHR_dynamic_rendering 及其依赖的扩展，并链接其特性结构体
+    VkResult Enable()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        // 首次调用时注册回调，RecreateDevice 后也会重新取得函数指针
+        static bool callbackAdded = false;
+        if (!callbackAdded) {
+            base.AddCallback_CreateDevice([] { Base().OnCreateDevice(); });
+            callbackAdded = true;
+        }
+        uint32_t deviceApiVersion = base.DeviceApiVersion();
+        useExtension = deviceApiVersion < VK_API_VERSION_1_3;
+        if (!useExtension) return VK_SUCCESS;
+        // 查询扩展特性需要 vkGetPhysicalDeviceFeatures2
+        if (deviceApiVersion < VK_API_VERSION_1_1) {
+            std::cout << std::format(
+                "[ dynamicRendering ] ERROR\nDynamic rendering requires Vulkan 1.1 or "
+                "above!\n");
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        // VK_KHR_dynamic_rendering 依赖的 VK_KHR_depth_stencil_resolve 和
+        // VK_KHR_create_renderpass2 在 Vulkan 1.2 中成为核心功能
+        const char* extensionNames[] = {VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+                                        VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+                                        VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME};
+        std::span<const char*> extensionsToCheck(
+            extensionNames, deviceApiVersion < VK_API_VERSION_1_2 ? 3 : 1);
+        if (VkResult result = base.CheckDeviceExtensions(extensionsToCheck)) return result;
+        for (auto i : extensionsToCheck)
+            if (!i) {
+                std::cout << std::format(
+                    "[ dynamicRendering ] ERROR\nVK_KHR_dynamic_rendering is not supported!\n");
+                return VK_ERROR_EXTENSION_NOT_PRESENT;
+            }
+        for (auto i : extensionsToCheck) base.AddDeviceExtension(i);
+        base.AddNextStructure_PhysicalDeviceFeatures(dynamicRenderingFeatures);
+        return VK_SUCCESS;
+    }
+    // Static Function
+    static dynamicRendering& Base()
+    {
+        static dynamicRendering singleton;
+        return singleton;
+    }
+    // 创建用于动态渲染的管线时，将其链接到 VkGraphicsPipelineCreateInfo 的 pNext
+    // 须在 colorAttachmentFormats 有效期间使用返回值
+    static VkPipelineRenderingCreateInfo PipelineRenderingCreateInfo(
+        std::span<const VkFormat> colorAttachmentFormats,
+        VkFormat depthAttachmentFormat = VK_FORMAT_UNDEFINED,
+        VkFormat stencilAttachmentFormat = VK_FORMAT_UNDEFINED, uint32_t viewMask = 0)
+    {
+        return {.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+                .viewMask = viewMask,
+                .colorAttachmentCount = uint32_t(colorAttachmentFormats.size()),
+                .pColorAttachmentFormats = colorAttachmentFormats.data(),
+                .depthAttachmentFormat = depthAttachmentFormat,
+                .stencilAttachmentFormat = stencilAttachmentFormat};
+    }
+};
+}  // namespace vulkan
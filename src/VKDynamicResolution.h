@@ -0,0 +1,432 @@
+#pragma once
+#include "VKDynamicRendering.h"
+
+namespace vulkan {
+// 动态分辨率：场景渲染到离屏目标的子矩形中，按 GPU 时间戳测得的帧时间调整其大小，再放大到交换链图像
+// 1. 离屏目标按交换链尺寸乘以 maxScale 分配，缩放比例改变时只改变渲染区域，不重新分配；
+//    仅在交换链重建后重新创建（此时图形队列已空闲）
+// 2. 以像素数（缩放比例的平方）为控制量的 PI 控制器，GPU 时间大致与像素数成正比：
+//    超出预算时立即缩小，余量超过 increaseThreshold 时才放大，避免在垂直同步的边界上来回振荡
+// 3. 计时的只是场景：CmdBeginScene 与 CmdEndScene 的时间戳之间不包含放大，也不包含等待
+//    获取交换链图像（即等待垂直同步或呈现），否则帧时间会被拉长到垂直同步间隔，分辨率只降不升；
+//    为此提交时等待获取图像的信号量的阶段应为 VK_PIPELINE_STAGE_TRANSFER_BIT（放大所在的阶段），
+//    而非 COLOR_ATTACHMENT_OUTPUT 或 ALL_COMMANDS，使场景不被该信号量阻塞
+// 4. 时间戳在 CmdBeginScene 时不等待地读取，帧索引相同的上一帧须已执行完毕（等待过其栅栏）
+// 管线的视口与剪裁须为动态状态，由 CmdBeginRendering 设置为渲染区域
+// 在着色器中采样离屏目标时，纹理坐标乘以 UvScale()，且应钳制在渲染区域内
+class dynamicResolution {
+public:
+    struct parameters {
+        float frameTimeBudget = 15.f;    // 毫秒，场景的预算，应为放大等留出余量
+        float minScale = 0.5f;           // 相对于交换链尺寸
+        float maxScale = 1.f;            // 决定离屏目标的大小，改变后须重新 Create
+        float increaseThreshold = 0.1f;  // 余量（相对于预算）超过该值才放大
+        float proportionalGain = 0.6f;
+        float integralGain = 0.05f;
+        float integralLimit = 1.f;
+        uint32_t extentGranularity = 8;  // 渲染区域的宽高取该值的倍数，减少细微的变化
+    };
+
+private:
+    struct attachment {
+        image attachmentImage;
+        deviceMemory memory;
+        imageView view;
+    };
+    parameters params;
+    VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    VkImageAspectFlags depthAspect = 0;
+    std::unique_ptr<attachment> color;
+    std::unique_ptr<attachment> depth;
+    VkExtent2D swapchainExtent = {};
+    VkExtent2D maxExtent = {};
+    VkExtent2D renderExtent = {};
+    float pixelRatio = 1.f;  // 即 scale 的平方
+    float integral = 0.f;
+    float lastFrameTime = 0.f;
+    std::unique_ptr<queryPool> queries;
+    std::vector<uint8_t> queriesWritten;
+    uint64_t timestampMask = 0;
+    double timestampPeriod = 0;
+
+    //--------------------
+    static std::vector<dynamicResolution*>& Instances()
+    {
+        static std::vector<dynamicResolution*> instances;
+        return instances;
+    }
+    static void OnCreateSwapchain()
+    {
+        for (auto instance : Instances())
+            if (instance->color) instance->CreateTargets();
+    }
+    static VkResult CreateAttachment(std::unique_ptr<attachment>& target, VkFormat format,
+                                     VkExtent2D extent, VkImageUsageFlags usage,
+                                     VkImageAspectFlags aspect)
+    {
+        target = std::make_unique<attachment>();
+        VkImageCreateInfo createInfo = {.imageType = VK_IMAGE_TYPE_2D,
+                                        .format = format,
+                                        .extent = {extent.width, extent.height, 1},
+                                        .mipLevels = 1,
+                                        .arrayLayers = 1,
+                                        .samples = VK_SAMPLE_COUNT_1_BIT,
+                                        .tiling = VK_IMAGE_TILING_OPTIMAL,
+                                        .usage = usage};
+        if (VkResult result = target->attachmentImage.Create(createInfo)) return result;
+        if (VkResult result = target->memory.Allocate(target->attachmentImage.MemoryRequirements(),
+                                                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+            return result;
+        if (VkResult result = target->attachmentImage.BindMemory(target->memory)) return result;
+        return target->view.Create(target->attachmentImage, VK_IMAGE_VIEW_TYPE_2D, format,
+                                   {aspect, 0, 1, 0, 1});
+    }
+    // Non-const Function
+    VkResult CreateTargets()
+    {
+        swapchainExtent = graphicsBase::Base().SwapchainCreateInfo().imageExtent;
+        maxExtent = {std::max(uint32_t(swapchainExtent.width * params.maxScale), 1u),
+                     std::max(uint32_t(swapchainExtent.height * params.maxScale), 1u)};
+        if (VkResult result = CreateAttachment(color, colorFormat, maxExtent,
+                                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                                                   VK_IMAGE_USAGE_SAMPLED_BIT |
+                                                   VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                                               VK_IMAGE_ASPECT_COLOR_BIT))
+            return result;
+        if (depthFormat != VK_FORMAT_UNDEFINED)
+            if (VkResult result =
+                    CreateAttachment(depth, depthFormat, maxExtent,
+                                     VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, depthAspect))
+                return result;
+        UpdateRenderExtent();
+        return VK_SUCCESS;
+    }
+    void UpdateRenderExtent()
+    {
+        uint32_t granularity = std::max(params.extentGranularity, 1u);
+        auto Quantize = [granularity](float length, uint32_t maxLength) {
+            uint32_t quantized = uint32_t(length) / granularity * granularity;
+            return std::clamp(quantized, std::min(granularity, maxLength), maxLength);
+        };
+        float scale = std::sqrt(pixelRatio);
+        renderExtent = {Quantize(swapchainExtent.width * scale, maxExtent.width),
+                        Quantize(swapchainExtent.height * scale, maxExtent.height)};
+    }
+
+public:
+    dynamicResolution()
+    {
+        static bool callbackAdded = false;
+        if (!callbackAdded) {
+            graphicsBase::Base().AddCallback_CreateSwapchain(OnCreateSwapchain);
+            callbackAdded = true;
+        }
+        Instances().push_back(this);
+    }
+    dynamicResolution(dynamicResolution&&) = delete;
+    ~dynamicResolution()
+    {
+        std::erase(Instances(), this);
+    }
+    // Getter
+    parameters& Parameters()
+    {
+        return params;
+    }
+    VkImage ColorImage() const
+    {
+        return color ? VkImage(color->attachmentImage) : VK_NULL_HANDLE;
+    }
+    VkImageView ColorView() const
+    {
+        return color ? VkImageView(color->view) : VK_NULL_HANDLE;
+    }
+    VkImageView DepthView() const
+    {
+        return depth ? VkImageView(depth->view) : VK_NULL_HANDLE;
+    }
+    VkFormat ColorFormat() const
+    {
+        return colorFormat;
+    }
+    VkFormat DepthFormat() const
+    {
+        return depthFormat;
+    }
+    // 离屏目标的大小
+    VkExtent2D MaxExtent() const
+    {
+        return maxExtent;
+    }
+    // 当前帧的渲染区域，位于离屏目标的左上角
+    VkExtent2D RenderExtent() const
+    {
+        return renderExtent;
+    }
+    float Scale() const
+    {
+        return std::sqrt(pixelRatio);
+    }
+    // 最近一次测得的场景的 GPU 时间，单位为毫秒
+    float LastFrameTime() const
+    {
+        return lastFrameTime;
+    }
+    // 渲染区域在离屏目标中所占的比例
+    glm::vec2 UvScale() const
+    {
+        return {float(renderExtent.width) / maxExtent.width,
+                float(renderExtent.height) / maxExtent.height};
+    }
+    // Const Function
+    VkViewport Viewport() const
+    {
+        return {0.f, 0.f, float(renderExtent.width), float(renderExtent.height), 0.f, 1.f};
+    }
+    VkRect2D Scissor() const
+    {
+        return {{}, renderExtent};
+    }
+    // 丢弃离屏目标的原有内容，开始以其渲染区域为 renderArea 的动态渲染，并设置视口与剪裁
+    void CmdBeginRendering(VkCommandBuffer commandBuffer, const VkClearColorValue& clearColor,
+                           VkClearDepthStencilValue clearDepthStencil = {1.f, 0}) const
+    {
+        VkImageMemoryBarrier imageMemoryBarriers[2] = {
+            {.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+             .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+             .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+             .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+             .image = color->attachmentImage,
+             .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}},
+            {.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+             .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+             .dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+             .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+             .newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+             .image = depth ? VkImage(depth->attachmentImage) : VK_NULL_HANDLE,
+             .subresourceRange = {depthAspect, 0, 1, 0, 1}}};
+        // 上一帧对离屏目标的读取（放大）须在写入前完成
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT |
+                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                 VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                 VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                 VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                             0, 0, nullptr, 0, nullptr, depth ? 2 : 1, imageMemoryBarriers);
+        VkRenderingAttachmentInfo colorAttachment = {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .imageView = color->view,
+            .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .clearValue = {.color = clearColor}};
+        VkRenderingAttachmentInfo depthAttachment = {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .imageView = DepthView(),
+            .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .clearValue = {.depthStencil = clearDepthStencil}};
+        VkRenderingInfo renderingInfo = {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+            .renderArea = Scissor(),
+            .layerCount = 1,
+            .colorAttachmentCount = 1,
+            .pColorAttachments = &colorAttachment,
+            .pDepthAttachment = depthAspect & VK_IMAGE_ASPECT_DEPTH_BIT ? &depthAttachment
+                                                                        : nullptr,
+            .pStencilAttachment = depthAspect & VK_IMAGE_ASPECT_STENCIL_BIT ? &depthAttachment
+                                                                            : nullptr};
+        dynamicRendering::Base().BeginRendering(commandBuffer, renderingInfo);
+        VkViewport viewport = Viewport();
+        VkRect2D scissor = Scissor();
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
+    void CmdEndRendering(VkCommandBuffer commandBuffer) const
+    {
+        dynamicRendering::Base().EndRendering(commandBuffer);
+    }
+    // 以线性过滤将渲染区域放大到整张交换链图像，交换链图像最终处于 finalLayout
+    // 若要在放大后以原生分辨率绘制 UI，finalLayout 可取 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL，
+    // 之后以 dynamicRendering::Base().EndRendering_Swapchain 结束
+    // 需交换链图像支持 VK_IMAGE_USAGE_TRANSFER_DST_BIT；线性过滤在渲染区域的右、下边缘处
+    // 会读到区域外半个像素，若不可接受，应改用按 UvScale() 钳制采样的着色器放大
+    void CmdUpscale(VkCommandBuffer commandBuffer, uint32_t imageIndex,
+                    VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                    VkFilter filter = VK_FILTER_LINEAR) const
+    {
+        VkImage swapchainImage = graphicsBase::Base().SwapchainImage(imageIndex);
+        VkImageMemoryBarrier imageMemoryBarriers[2] = {
+            {.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+             .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+             .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+             .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+             .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+             .image = color->attachmentImage,
+             .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}},
+            {.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+             .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+             .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+             .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+             .image = swapchainImage,
+             .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}}};
+        // 提交时，等待获取图像的信号量的阶段应为 VK_PIPELINE_STAGE_TRANSFER_BIT
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 2,
+                             imageMemoryBarriers);
+        VkImageBlit region = {
+            .srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+            .srcOffsets = {{}, {int32_t(renderExtent.width), int32_t(renderExtent.height), 1}},
+            .dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+            .dstOffsets = {{},
+                           {int32_t(swapchainExtent.width), int32_t(swapchainExtent.height), 1}}};
+        vkCmdBlitImage(commandBuffer, color->attachmentImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       swapchainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, filter);
+        bool toAttachment = finalLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        imageMemoryBarriers[1] = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = toAttachment ? VkAccessFlags(VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                                                          VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT)
+                                          : 0,
+            .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .newLayout = finalLayout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = swapchainImage,
+            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}};
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             toAttachment ? VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+                                          : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarriers[1]);
+    }
+    // 在场景（及在离屏目标上进行的后处理）之后、CmdUpscale 之前写入结束时间戳，须在渲染之外录制
+    // 时间戳等到此前的命令全部执行完毕，不包含其后的放大及对获取交换链图像的等待
+    void CmdEndScene(VkCommandBuffer commandBuffer, uint32_t frameIndex) const
+    {
+        if (!timestampMask || frameIndex >= queriesWritten.size()) return;
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, *queries,
+                            frameIndex * 2 + 1);
+    }
+    // Non-const Function
+    // 读取帧索引相同的上一帧的场景 GPU 时间并调整渲染区域，然后写入起始时间戳
+    // 在录制场景前调用，须在渲染之外录制；随后的 RenderExtent() 等即为该帧所用的值
+    void CmdBeginScene(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+    {
+        if (!timestampMask || frameIndex >= queriesWritten.size()) return;
+        if (queriesWritten[frameIndex]) {
+            uint64_t timestamps[2];
+            // 不等待，尚不可用（返回 VK_NOT_READY）时沿用当前的渲染区域
+            if (queries->GetResults(frameIndex * 2, timestamps, VK_QUERY_RESULT_64_BIT) ==
+                VK_SUCCESS)
+                Update(float(((timestamps[1] - timestamps[0]) & timestampMask) * timestampPeriod /
+                             1e6));
+        }
+        queries->CmdReset(commandBuffer, frameIndex * 2, 2);
+        // 等到此前提交的工作结束，使其不计入场景时间
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, *queries,
+                            frameIndex * 2);
+        queriesWritten[frameIndex] = true;
+    }
+    // 以一帧的 GPU 时间（毫秒）更新控制器，也可由调用方以其他方式测得的时间直接调用
+    void Update(float frameTime)
+    {
+        if (!(frameTime > 0.f) || !(params.frameTimeBudget > 0.f)) return;
+        lastFrameTime = frameTime;
+        float error = (params.frameTimeBudget - frameTime) / params.frameTimeBudget;
+        // 迟滞：在预算之内且余量不足时保持不变，并清空积分以免累积
+        if (error >= 0.f && error < params.increaseThreshold) {
+            integral = 0.f;
+            return;
+        }
+        integral = std::clamp(integral + error, -params.integralLimit, params.integralLimit);
+        float factor = 1.f + params.proportionalGain * error + params.integralGain * integral;
+        float minScale = std::min(params.minScale, params.maxScale);
+        pixelRatio = std::clamp(pixelRatio * std::clamp(factor, 0.25f, 2.f),
+                                minScale * minScale, params.maxScale * params.maxScale);
+        UpdateRenderExtent();
+    }
+    // 回到最大的渲染区域，例如在场景切换后
+    void Reset()
+    {
+        pixelRatio = params.maxScale * params.maxScale;
+        integral = 0.f;
+        UpdateRenderExtent();
+    }
+    // 在交换链创建后调用，frameCount 为飞行中的帧数
+    // depthFormat 为 VK_FORMAT_UNDEFINED 时不创建深度模板附件
+    // 图形队列不支持时间戳时仍可渲染，但渲染区域只随 Update 的调用而改变
+    VkResult Create(uint32_t frameCount, VkFormat colorFormat,
+                    VkFormat depthFormat = VK_FORMAT_UNDEFINED)
+    {
+        graphicsBase& base = graphicsBase::Base();
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(base.PhysicalDevice(), colorFormat, &formatProperties);
+        constexpr VkFormatFeatureFlags requiredFeatures =
+            VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        if ((formatProperties.optimalTilingFeatures & requiredFeatures) != requiredFeatures) {
+            std::cout << std::format(
+                "[ dynamicResolution ] ERROR\nThe color format can't be rendered to and blitted "
+                "with linear filtering: {}\n",
+                int32_t(colorFormat));
+            return VK_ERROR_FORMAT_NOT_SUPPORTED;
+        }
+        this->colorFormat = colorFormat;
+        this->depthFormat = depthFormat;
+        switch (depthFormat) {
+            case VK_FORMAT_UNDEFINED:
+                depthAspect = 0;
+                break;
+            case VK_FORMAT_S8_UINT:
+                depthAspect = VK_IMAGE_ASPECT_STENCIL_BIT;
+                break;
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+                break;
+            default:
+                depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        }
+        depth.reset();
+        pixelRatio = params.maxScale * params.maxScale;
+        integral = 0.f;
+        if (VkResult result = CreateTargets()) return result;
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(base.PhysicalDevice(), &queueFamilyCount,
+                                                 nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilyPropertieses(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(base.PhysicalDevice(), &queueFamilyCount,
+                                                 queueFamilyPropertieses.data());
+        uint32_t timestampValidBits =
+            queueFamilyPropertieses[base.QueueFamilyIndex_Graphics()].timestampValidBits;
+        queriesWritten.assign(frameCount, false);
+        if (!timestampValidBits) {
+            timestampMask = 0;
+            std::cout << std::format(
+                "[ dynamicResolution ] WARNING\nThe graphics queue does not support "
+                "timestamps!\n");
+            return VK_SUCCESS;
+        }
+        timestampMask =
+            timestampValidBits == 64 ? UINT64_MAX : (uint64_t(1) << timestampValidBits) - 1;
+        timestampPeriod = base.PhysicalDeviceProperties().limits.timestampPeriod;
+        queries = std::make_unique<queryPool>();
+        return queries->Create(VK_QUERY_TYPE_TIMESTAMP, frameCount * 2);
+    }
+};
+}  // namespace vulkan
@@ -0,0 +1,304 @@
+#pragma once
+#include "VKBase.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vulkan {
+// 以 VK_EXT_external_memory_host 将主机指针导入为 VkDeviceMemory，GPU 经由 PCIe 直接读取主机内存
+// 在 DeterminePhysicalDevice 后、CreateDevice 前调用 Enable，逻辑设备创建后查询导入所需的对齐
+class externalMemoryHost {
+    bool enabled = false;
+    bool extensionAdded = false;  // Enable 是否成功添加了扩展
+    VkDeviceSize minImportedHostPointerAlignment = 0;
+    PFN_vkGetMemoryHostPointerPropertiesEXT pVkGetMemoryHostPointerProperties = nullptr;
+
+    //--------------------
+    externalMemoryHost() = default;
+    externalMemoryHost(externalMemoryHost&&) = delete;
+    // Non-const Function
+    void OnCreateDevice()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        enabled = false;
+        // 未添加扩展时（包括 Vulkan 1.0 的设备）不可查询属性
+        if (!extensionAdded || base.DeviceApiVersion() < VK_API_VERSION_1_1) return;
+        pVkGetMemoryHostPointerProperties =
+            reinterpret_cast<PFN_vkGetMemoryHostPointerPropertiesEXT>(
+                vkGetDeviceProcAddr(base.Device(), "vkGetMemoryHostPointerPropertiesEXT"));
+        VkPhysicalDeviceExternalMemoryHostPropertiesEXT externalMemoryHostProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT};
+        VkPhysicalDeviceProperties2 properties2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &externalMemoryHostProperties};
+        vkGetPhysicalDeviceProperties2(base.PhysicalDevice(), &properties2);
+        minImportedHostPointerAlignment =
+            externalMemoryHostProperties.minImportedHostPointerAlignment;
+        enabled = pVkGetMemoryHostPointerProperties && minImportedHostPointerAlignment;
+    }
+
+public:
+    // Getter
+    // 逻辑设备创建后有效
+    bool Enabled() const
+    {
+        return enabled;
+    }
+    // 导入的指针与大小都须按此对齐
+    VkDeviceSize MinImportedHostPointerAlignment() const
+    {
+        return minImportedHostPointerAlignment;
+    }
+    // Const Function
+    // 查询 pHostPointer 可导入为哪些内存类型，返回值为 memoryTypeBits
+    // 指针不能以 handleType 导入时返回 0，这是可预期的情况，不输出错误信息
+    uint32_t MemoryTypeBits(VkExternalMemoryHandleTypeFlagBits handleType,
+                            const void* pHostPointer) const
+    {
+        VkMemoryHostPointerPropertiesEXT hostPointerProperties = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT};
+        if (pVkGetMemoryHostPointerProperties(graphicsBase::Base().Device(), handleType,
+                                              pHostPointer, &hostPointerProperties))
+            return 0;
+        return hostPointerProperties.memoryTypeBits;
+    }
+    // Non-const Function
+    // 设备不支持时返回 VK_ERROR_EXTENSION_NOT_PRESENT，此后 mappedFileBuffer 退回读取文件
+    VkResult Enable()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        static bool callbackAdded = false;
+        if (!callbackAdded) {
+            base.AddCallback_CreateDevice([] { Base().OnCreateDevice(); });
+            callbackAdded = true;
+        }
+        extensionAdded = false;
+        // 查询属性需要 vkGetPhysicalDeviceProperties2，所依赖的 VK_KHR_external_memory 在 Vulkan
+        // 1.1 中成为核心功能
+        if (base.DeviceApiVersion() < VK_API_VERSION_1_1) return VK_ERROR_FEATURE_NOT_PRESENT;
+        const char* extensionNames[] = {VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME};
+        if (VkResult result = base.CheckDeviceExtensions(extensionNames)) return result;
+        if (!extensionNames[0]) return VK_ERROR_EXTENSION_NOT_PRESENT;
+        base.AddDeviceExtension(extensionNames[0]);
+        extensionAdded = true;
+        return VK_SUCCESS;
+    }
+    // Static Function
+    static externalMemoryHost& Base()
+    {
+        static externalMemoryHost singleton;
+        return singleton;
+    }
+};
+
+// 大型只读资产文件：映射文件后将其页面（即操作系统的页缓存）导入为缓冲区的内存，省去 CPU 端的复制
+// 1. 可用作复制的来源，或直接绑定为顶点、索引、storage 缓冲区供 GPU 读取，不可被写入
+// 2. 无法导入时（设备不支持、驱动拒绝导入文件页面、Windows 平台），退回为分配主机可见的内存并将文件
+//    读入其中，使用方式不变
+// Windows 上以只读方式映射的文件不能超出文件大小，无法按导入所需的大小对齐，所以总是读取文件
+class mappedFileBuffer {
+    buffer fileBuffer;
+    deviceMemory fileMemory;                         // 读取文件时使用
+    VkDeviceMemory importedMemory = VK_NULL_HANDLE;  // 导入文件页面时使用
+    void* pMappedFile = nullptr;                     // 映射的起始地址，仅在导入时有效
+    VkDeviceSize mappedSize = 0;                     // 按对齐要求向上取整后的映射大小
+    VkDeviceSize fileSize = 0;
+    bool imported = false;
+
+    //--------------------
+    // 映射文件，使起始地址与大小均按 alignment 对齐，文件末尾之后的部分为零页
+    bool MapFile(const char* filepath, VkDeviceSize alignment)
+    {
+#ifndef _WIN32
+        int fd = open(filepath, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) || !fileStat.st_size) {
+            close(fd);
+            return false;
+        }
+        fileSize = VkDeviceSize(fileStat.st_size);
+        alignment = std::max(alignment, VkDeviceSize(sysconf(_SC_PAGESIZE)));
+        mappedSize = (fileSize + alignment - 1) / alignment * alignment;
+        // 先预留多出 alignment 的匿名区域，从中取对齐的部分，再将文件映射到其开头
+        uint8_t* pReserved = static_cast<uint8_t*>(mmap(nullptr, mappedSize + alignment, PROT_READ,
+                                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (pReserved == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        uint8_t* pAligned = reinterpret_cast<uint8_t*>(
+            (reinterpret_cast<uintptr_t>(pReserved) + alignment - 1) / alignment * alignment);
+        if (pAligned != pReserved) munmap(pReserved, pAligned - pReserved);
+        munmap(pAligned + mappedSize, pReserved + alignment - pAligned);
+        void* pFile =
+            mmap(pAligned, size_t(fileSize), PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0);
+        close(fd);
+        if (pFile == MAP_FAILED) {
+            munmap(pAligned, mappedSize);
+            return false;
+        }
+        pMappedFile = pAligned;
+        return true;
+#else
+        return false;
+#endif
+    }
+    void UnmapFile()
+    {
+#ifndef _WIN32
+        if (pMappedFile) munmap(pMappedFile, mappedSize);
+#endif
+        pMappedFile = nullptr;
+        mappedSize = 0;
+    }
+    // 先尝试 HOST_ALLOCATION，驱动不接受时再以 HOST_MAPPED_FOREIGN_MEMORY 导入
+    // 导入失败可由 Open 退回读取文件，所以此处不输出错误信息
+    VkResult Import(VkBufferUsageFlags usage)
+    {
+        constexpr VkExternalMemoryHandleTypeFlagBits handleTypes[] = {
+            VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+            VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_MAPPED_FOREIGN_MEMORY_BIT_EXT};
+        VkExternalMemoryBufferCreateInfo externalMemoryBufferCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO,
+            .handleTypes = VkExternalMemoryHandleTypeFlags(handleTypes[0] | handleTypes[1])};
+        VkBufferCreateInfo bufferCreateInfo = {.pNext = &externalMemoryBufferCreateInfo,
+                                               .size = mappedSize,
+                                               .usage = usage};
+        if (VkResult result = fileBuffer.Create(bufferCreateInfo)) return result;
+        // 导入的内存即整段映射，缓冲区所需的大小与对齐都须能由其满足
+        VkMemoryRequirements memoryRequirements = fileBuffer.MemoryRequirements();
+        if (memoryRequirements.size > mappedSize ||
+            reinterpret_cast<uintptr_t>(pMappedFile) % memoryRequirements.alignment)
+            return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+        graphicsBase& base = graphicsBase::Base();
+        for (auto handleType : handleTypes) {
+            uint32_t memoryTypeIndex = base.MemoryTypeIndex(
+                memoryRequirements.memoryTypeBits &
+                    externalMemoryHost::Base().MemoryTypeBits(handleType, pMappedFile),
+                0);
+            if (memoryTypeIndex == UINT32_MAX) continue;
+            VkImportMemoryHostPointerInfoEXT importInfo = {
+                .sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT,
+                .handleType = handleType,
+                .pHostPointer = pMappedFile};
+            VkMemoryAllocateInfo allocateInfo = {.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                                                 .pNext = &importInfo,
+                                                 .allocationSize = mappedSize,
+                                                 .memoryTypeIndex = memoryTypeIndex};
+            if (vkAllocateMemory(base.Device(), &allocateInfo, nullptr, &importedMemory))
+                continue;
+            if (!vkBindBufferMemory(base.Device(), fileBuffer, importedMemory, 0))
+                return VK_SUCCESS;
+            FreeImportedMemory();
+        }
+        return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+    }
+    void FreeImportedMemory()
+    {
+        if (importedMemory) vkFreeMemory(graphicsBase::Base().Device(), importedMemory, nullptr);
+        importedMemory = VK_NULL_HANDLE;
+    }
+    // 退路：分配主机可见的内存，将文件直接读入映射的内存中
+    VkResult Read(const char* filepath, VkBufferUsageFlags usage)
+    {
+        std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+        if (!file) {
+            std::cout << std::format("[ mappedFileBuffer ] ERROR\nFailed to open the file: {}\n",
+                                     filepath);
+            return VK_RESULT_MAX_ENUM;
+        }
+        fileSize = VkDeviceSize(file.tellg());
+        file.seekg(0);
+        if (!fileSize) {
+            std::cout << std::format("[ mappedFileBuffer ] ERROR\nThe file is empty: {}\n",
+                                     filepath);
+            return VK_RESULT_MAX_ENUM;
+        }
+        VkBufferCreateInfo bufferCreateInfo = {.size = fileSize, .usage = usage};
+        if (VkResult result = fileBuffer.Create(bufferCreateInfo)) return result;
+        if (VkResult result =
+                fileMemory.Allocate(fileBuffer.MemoryRequirements(),
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+            return result;
+        if (VkResult result = fileBuffer.BindMemory(fileMemory)) return result;
+        void* pData;
+        if (VkResult result = fileMemory.MapMemory(pData, fileSize)) return result;
+        file.read(static_cast<char*>(pData), std::streamsize(fileSize));
+        fileMemory.UnmapMemory(fileSize);
+        if (!file) {
+            std::cout << std::format("[ mappedFileBuffer ] ERROR\nFailed to read the file: {}\n",
+                                     filepath);
+            return VK_RESULT_MAX_ENUM;
+        }
+        return VK_SUCCESS;
+    }
+
+public:
+    mappedFileBuffer() = default;
+    mappedFileBuffer(const char* filepath, VkBufferUsageFlags usage)
+    {
+        Open(filepath, usage);
+    }
+    mappedFileBuffer(mappedFileBuffer&&) = delete;
+    ~mappedFileBuffer()
+    {
+        Close();
+    }
+    // Getter
+    operator VkBuffer() const
+    {
+        return fileBuffer;
+    }
+    VkDeviceMemory Memory() const
+    {
+        return importedMemory ? importedMemory : VkDeviceMemory(fileMemory);
+    }
+    // 文件的大小，文件内容位于缓冲区的 [0, Size())
+    VkDeviceSize Size() const
+    {
+        return fileSize;
+    }
+    // 是否为导入的文件页面，否则为读入文件内容的主机可见内存
+    bool Imported() const
+    {
+        return imported;
+    }
+    // Non-const Function
+    VkResult Open(const char* filepath, VkBufferUsageFlags usage =
+                                            VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                                            VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+    {
+        Close();
+        externalMemoryHost& host = externalMemoryHost::Base();
+        if (host.Enabled() && MapFile(filepath, host.MinImportedHostPointerAlignment())) {
+            if (!Import(usage)) {
+                imported = true;
+                return VK_SUCCESS;
+            }
+            // 导入失败，如驱动不接受文件页面，换用读取的方式
+            buffer(std::move(fileBuffer));
+            FreeImportedMemory();
+            UnmapFile();
+        }
+        return Read(filepath, usage);
+    }
+    // 须确保设备不再使用该缓冲区
+    void Close()
+    {
+        // 先销毁缓冲区和导入的内存，再解除文件映射
+        buffer(std::move(fileBuffer));
+        deviceMemory(std::move(fileMemory));
+        FreeImportedMemory();
+        UnmapFile();
+        fileSize = 0;
+        imported = false;
+    }
+};
+}  // namespace vulkan
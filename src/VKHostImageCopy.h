@@ -0,0 +1,292 @@
+#pragma once
+#include "VKUploader.h"
+
+namespace vulkan {
+// 主机图像复制：由 CPU 直接将像素写入 optimal tiling 的图像，不经过暂存缓冲区和队列
+// 1. 图像须以 VK_IMAGE_USAGE_HOST_TRANSFER_BIT 创建并已绑定内存，用 ImageUsage 决定是否加入该用途
+// 2. 复制只对所写入的图像做外部同步，不同的图像可在多个工作线程上同时上传，
+//    例如各线程 stbi_load 后直接调用 UploadImage
+// 3. 设备不支持时，UploadImage 退回 stagingUploader 的暂存路径，此时须在 uploader 所属线程上调用
+// 4. Benchmark 将同一组图像分别经由两条路径上传，比较耗时与暂存内存的峰值
+// 设备支持 Vulkan 1.4 时使用核心功能，否则使用 VK_EXT_host_image_copy 扩展
+class hostImageCopy {
+public:
+    struct copyStatistics {
+        uint64_t imageCount;  // 经由主机复制上传的子资源个数
+        uint64_t byteCount;   // 经由主机复制上传的字节数
+        double copyTime;      // 主机复制（含布局转换）的总耗时，单位为毫秒，多线程时为各线程之和
+    };
+    // 供 Benchmark 上传的一张图像，只有一个 mip 等级和图层，像素紧密排列
+    struct benchmarkImage {
+        const void* pData;
+        VkDeviceSize size;
+        VkExtent2D extent;
+        VkFormat format;
+    };
+    struct benchmarkResult {
+        double hostCopyTime;             // 主机复制路径的耗时，单位为毫秒
+        double stagingTime;              // 暂存路径自开始上传至 GPU 上复制完毕的耗时，单位为毫秒
+        VkDeviceSize hostCopyPeakUsage;  // 主机复制路径不占用暂存内存，恒为 0
+        VkDeviceSize stagingPeakUsage;   // 暂存缓冲区被占用的峰值
+    };
+
+private:
+    bool enabled = false;
+    bool useExtension = false;  // 是否经由 VK_EXT_host_image_copy 使用
+    VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT};
+    std::vector<VkImageLayout> copyDstLayouts;  // 主机复制可写入的布局
+    PFN_vkCopyMemoryToImageEXT pVkCopyMemoryToImage = nullptr;
+    PFN_vkTransitionImageLayoutEXT pVkTransitionImageLayout = nullptr;
+    std::atomic<uint64_t> imageCount = 0;
+    std::atomic<uint64_t> byteCount = 0;
+    std::atomic<uint64_t> copyTime = 0;  // 单位为纳秒
+
+    //--------------------
+    hostImageCopy() = default;
+    hostImageCopy(hostImageCopy&&) = delete;
+    // Non-const Function
+    // 逻辑设备创建后，确认特性是否已开启，取得函数指针，并查询可写入的布局
+    void OnCreateDevice()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        enabled = false;
+        if (!hostImageCopyFeatures.hostImageCopy) return;
+        pVkCopyMemoryToImage = reinterpret_cast<PFN_vkCopyMemoryToImageEXT>(vkGetDeviceProcAddr(
+            base.Device(), useExtension ? "vkCopyMemoryToImageEXT" : "vkCopyMemoryToImage"));
+        pVkTransitionImageLayout =
+            reinterpret_cast<PFN_vkTransitionImageLayoutEXT>(vkGetDeviceProcAddr(
+                base.Device(),
+                useExtension ? "vkTransitionImageLayoutEXT" : "vkTransitionImageLayout"));
+        VkPhysicalDeviceHostImageCopyPropertiesEXT hostImageCopyProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT};
+        VkPhysicalDeviceProperties2 properties2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &hostImageCopyProperties};
+        vkGetPhysicalDeviceProperties2(base.PhysicalDevice(), &properties2);
+        copyDstLayouts.resize(hostImageCopyProperties.copyDstLayoutCount);
+        hostImageCopyProperties.pCopyDstLayouts = copyDstLayouts.data();
+        vkGetPhysicalDeviceProperties2(base.PhysicalDevice(), &properties2);
+        enabled = pVkCopyMemoryToImage && pVkTransitionImageLayout;
+    }
+
+public:
+    // Getter
+    // 逻辑设备创建后有效
+    bool Enabled() const
+    {
+        return enabled;
+    }
+    copyStatistics Statistics() const
+    {
+        return {imageCount, byteCount, copyTime / 1e6};
+    }
+    // Const Function
+    // 主机复制能否写入 format 格式、optimal tiling 的图像，并使其处于 layout 布局
+    bool Supported(VkFormat format, VkImageLayout layout) const
+    {
+        if (!enabled || std::ranges::find(copyDstLayouts, layout) == copyDstLayouts.end())
+            return false;
+        VkFormatProperties3 formatProperties3 = {.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_3};
+        VkFormatProperties2 formatProperties2 = {.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2,
+                                                 .pNext = &formatProperties3};
+        vkGetPhysicalDeviceFormatProperties2(graphicsBase::Base().PhysicalDevice(), format,
+                                             &formatProperties2);
+        return formatProperties3.optimalTilingFeatures &
+               VK_FORMAT_FEATURE_2_HOST_IMAGE_TRANSFER_BIT_EXT;
+    }
+    // 创建图像时使用的用途：支持主机复制时加入 VK_IMAGE_USAGE_HOST_TRANSFER_BIT，否则加入
+    // VK_IMAGE_USAGE_TRANSFER_DST_BIT 供暂存路径使用
+    // 有的设备上 HOST_TRANSFER 用途会使 GPU 访问变慢，此时同样退回暂存路径
+    VkImageUsageFlags ImageUsage(VkFormat format, VkImageType imageType, VkImageUsageFlags usage,
+                                 VkImageLayout finalLayout) const
+    {
+        if (!Supported(format, finalLayout)) return usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        VkHostImageCopyDevicePerformanceQueryEXT performanceQuery = {
+            .sType = VK_STRUCTURE_TYPE_HOST_IMAGE_COPY_DEVICE_PERFORMANCE_QUERY_EXT};
+        VkImageFormatProperties2 imageFormatProperties = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2, .pNext = &performanceQuery};
+        VkPhysicalDeviceImageFormatInfo2 imageFormatInfo = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+            .format = format,
+            .type = imageType,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = usage | VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT};
+        if (vkGetPhysicalDeviceImageFormatProperties2(graphicsBase::Base().PhysicalDevice(),
+                                                      &imageFormatInfo, &imageFormatProperties) ||
+            !performanceQuery.optimalDeviceAccess)
+            return usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        return usage | VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT;
+    }
+    // Non-const Function
+    // 将 pData 处紧密排列的像素写入图像的一个 mip 等级，该子资源原有的内容会被丢弃
+    // 返回后即可在之后提交的命令中使用，无需等待；须确保设备此时不在访问该图像
+    VkResult CopyMemoryToImage(VkImage image, const void* pData, VkDeviceSize size,
+                               VkExtent3D extent, VkImageSubresourceLayers subresource,
+                               VkImageLayout finalLayout)
+    {
+        auto time0 = std::chrono::steady_clock::now();
+        VkHostImageLayoutTransitionInfoEXT transitionInfo = {
+            .sType = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT,
+            .image = image,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = finalLayout,
+            .subresourceRange = {subresource.aspectMask, subresource.mipLevel, 1,
+                                 subresource.baseArrayLayer, subresource.layerCount}};
+        VkDevice device = graphicsBase::Base().Device();
+        if (VkResult result = pVkTransitionImageLayout(device, 1, &transitionInfo)) {
+            std::cout << std::format(
+                "[ hostImageCopy ] ERROR\nFailed to transition the image layout on the host!\n"
+                "Error code: {}\n",
+                int32_t(result));
+            return result;
+        }
+        VkMemoryToImageCopyEXT region = {.sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT,
+                                         .pHostPointer = pData,
+                                         .imageSubresource = subresource,
+                                         .imageExtent = extent};
+        VkCopyMemoryToImageInfoEXT copyInfo = {
+            .sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT,
+            .dstImage = image,
+            .dstImageLayout = finalLayout,
+            .regionCount = 1,
+            .pRegions = &region};
+        if (VkResult result = pVkCopyMemoryToImage(device, &copyInfo)) {
+            std::cout << std::format(
+                "[ hostImageCopy ] ERROR\nFailed to copy memory to the image!\nError code: {}\n",
+                int32_t(result));
+            return result;
+        }
+        imageCount++;
+        byteCount += size;
+        copyTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - time0)
+                        .count();
+        return VK_SUCCESS;
+    }
+    // usage 为创建图像时的用途，含 VK_IMAGE_USAGE_HOST_TRANSFER_BIT 时走主机复制，
+    // 否则经由 uploader 上传，此时完成时刻见 uploader.PendingValue()
+    VkResult UploadImage(stagingUploader& uploader, VkImage image, VkImageUsageFlags usage,
+                         const void* pData, VkDeviceSize size, VkExtent3D extent,
+                         VkImageSubresourceLayers subresource,
+                         VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        if (enabled && usage & VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT)
+            return CopyMemoryToImage(image, pData, size, extent, subresource, finalLayout);
+        return uploader.UploadImage(image, pData, size, extent, subresource, finalLayout);
+    }
+    void ResetStatistics()
+    {
+        imageCount = byteCount = copyTime = 0;
+    }
+    // 在单个线程上将 images 先经由主机复制、再经由容量为 stagingCapacity 的暂存路径上传，
+    // 两条路径各自上传到新建的图像，创建图像与分配内存不计入耗时
+    // 需要主机复制支持各图像的格式，stagingCapacity 不小于最大的图像
+    VkResult Benchmark(std::span<const benchmarkImage> images, VkDeviceSize stagingCapacity,
+                       benchmarkResult& benchmarkResult)
+    {
+        constexpr VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        for (auto& i : images)
+            if (!Supported(i.format, finalLayout)) {
+                std::cout << std::format(
+                    "[ hostImageCopy ] ERROR\nHost image copy does not support the format: {}\n",
+                    int32_t(i.format));
+                return VK_ERROR_FORMAT_NOT_SUPPORTED;
+            }
+        std::vector<image> hostCopyImages, stagingImages;
+        std::vector<deviceMemory> hostCopyMemories, stagingMemories;
+        hostCopyImages.reserve(images.size()), stagingImages.reserve(images.size());
+        hostCopyMemories.reserve(images.size()), stagingMemories.reserve(images.size());
+        auto CreateImages = [&images](VkImageUsageFlags usage, std::vector<image>& imageList,
+                                      std::vector<deviceMemory>& memories) {
+            for (auto& i : images) {
+                VkImageCreateInfo createInfo = {
+                    .imageType = VK_IMAGE_TYPE_2D,
+                    .format = i.format,
+                    .extent = {i.extent.width, i.extent.height, 1},
+                    .mipLevels = 1,
+                    .arrayLayers = 1,
+                    .samples = VK_SAMPLE_COUNT_1_BIT,
+                    .tiling = VK_IMAGE_TILING_OPTIMAL,
+                    .usage = usage | VK_IMAGE_USAGE_SAMPLED_BIT};
+                image& newImage = imageList.emplace_back();
+                if (VkResult result = newImage.Create(createInfo)) return result;
+                deviceMemory& memory = memories.emplace_back();
+                if (VkResult result = memory.Allocate(newImage.MemoryRequirements(),
+                                                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+                    return result;
+                if (VkResult result = newImage.BindMemory(memory)) return result;
+            }
+            return VK_SUCCESS;
+        };
+        if (VkResult result = CreateImages(VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT, hostCopyImages,
+                                           hostCopyMemories))
+            return result;
+        if (VkResult result =
+                CreateImages(VK_IMAGE_USAGE_TRANSFER_DST_BIT, stagingImages, stagingMemories))
+            return result;
+        stagingUploader uploader;
+        if (VkResult result = uploader.Create(stagingCapacity)) return result;
+        constexpr VkImageSubresourceLayers subresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        auto time0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < images.size(); i++)
+            if (VkResult result = CopyMemoryToImage(
+                    hostCopyImages[i], images[i].pData, images[i].size,
+                    {images[i].extent.width, images[i].extent.height, 1}, subresource,
+                    finalLayout))
+                return result;
+        auto time1 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < images.size(); i++)
+            if (VkResult result = uploader.UploadImage(
+                    stagingImages[i], images[i].pData, images[i].size,
+                    {images[i].extent.width, images[i].extent.height, 1}, subresource,
+                    finalLayout))
+                return result;
+        if (VkResult result = uploader.WaitIdle()) return result;
+        auto time2 = std::chrono::steady_clock::now();
+        benchmarkResult = {
+            .hostCopyTime = std::chrono::duration<double, std::milli>(time1 - time0).count(),
+            .stagingTime = std::chrono::duration<double, std::milli>(time2 - time1).count(),
+            .hostCopyPeakUsage = 0,
+            .stagingPeakUsage = uploader.Statistics().peakUsage};
+        return VK_SUCCESS;
+    }
+    // 在 DeterminePhysicalDevice 后、CreateDevice 前调用，设备不支持时返回
+    // VK_ERROR_EXTENSION_NOT_PRESENT，此后 UploadImage 总是走暂存路径
+    VkResult Enable()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        static bool callbackAdded = false;
+        if (!callbackAdded) {
+            base.AddCallback_CreateDevice([] { Base().OnCreateDevice(); });
+            callbackAdded = true;
+        }
+        uint32_t deviceApiVersion = base.DeviceApiVersion();
+        useExtension = deviceApiVersion < VK_API_VERSION_1_4;
+        // 特性须经由 vkGetPhysicalDeviceFeatures2 查询
+        if (deviceApiVersion < VK_API_VERSION_1_1) return VK_ERROR_FEATURE_NOT_PRESENT;
+        if (useExtension) {
+            // VK_EXT_host_image_copy 依赖的 VK_KHR_copy_commands2 和 VK_KHR_format_feature_flags2
+            // 在 Vulkan 1.3 中成为核心功能
+            const char* extensionNames[] = {VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME,
+                                            VK_KHR_COPY_COMMANDS_2_EXTENSION_NAME,
+                                            VK_KHR_FORMAT_FEATURE_FLAGS_2_EXTENSION_NAME};
+            std::span<const char*> extensionsToCheck(
+                extensionNames, deviceApiVersion < VK_API_VERSION_1_3 ? 3 : 1);
+            if (VkResult result = base.CheckDeviceExtensions(extensionsToCheck)) return result;
+            for (auto i : extensionsToCheck)
+                if (!i) return VK_ERROR_EXTENSION_NOT_PRESENT;
+            for (auto i : extensionsToCheck) base.AddDeviceExtension(i);
+        }
+        // Vulkan 1.4 中该特性结构体同样有效，CreateDevice 会开启所有支持的特性
+        base.AddNextStructure_PhysicalDeviceFeatures(hostImageCopyFeatures);
+        return VK_SUCCESS;
+    }
+    // Static Function
+    static hostImageCopy& Base()
+    {
+        static hostImageCopy singleton;
+        return singleton;
+    }
+};
+}  // namespace vulkan
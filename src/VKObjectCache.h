@@ -0,0 +1,311 @@
+#pragma once
+#include "VKBase.h"
+
+namespace vulkan {
+template <typename T>
+void HashCombine(size_t& seed, const T& value)
+{
+    seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+// 逐个合并 std::tie 所得的各成员的哈希值
+template <typename... T>
+size_t HashTuple(const std::tuple<T...>& tuple)
+{
+    size_t seed = 0;
+    std::apply([&seed](const auto&... values) { (HashCombine(seed, values), ...); }, tuple);
+    return seed;
+}
+
+// 按创建信息的内容去重的对象缓存，内容相同的创建请求返回同一个句柄
+// 返回的句柄由缓存持有，各处共享，调用方不可销毁
+// 不用 vulkan_hash.hpp：其对 pBindings 等指针成员只哈希地址，内容相同的创建信息会得到不同的哈希值
+// key_t 需提供 size_t Hash() const 和 operator==
+template <typename key_t, typename handle_t>
+class objectCache {
+    struct keyHash {
+        size_t operator()(const key_t& key) const
+        {
+            return key.Hash();
+        }
+    };
+    std::unordered_map<key_t, handle_t, keyHash> objects;
+    mutable std::mutex mutex;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+
+protected:
+    // 命中时直接返回已有的句柄，否则调用 create 创建并加入缓存
+    // 创建时仍持有锁，以免多个线程同时创建内容相同的对象
+    // 对象个数已达到 maxObjectCount 时不再创建，返回 VK_ERROR_TOO_MANY_OBJECTS
+    template <typename create_t>
+    VkResult GetOrCreate(key_t&& key, handle_t& handle, create_t&& create,
+                         size_t maxObjectCount = SIZE_MAX)
+    {
+        std::lock_guard lock(mutex);
+        if (auto it = objects.find(key); it != objects.end()) {
+            hitCount++;
+            handle = it->second;
+            return VK_SUCCESS;
+        }
+        missCount++;
+        if (objects.size() >= maxObjectCount) return VK_ERROR_TOO_MANY_OBJECTS;
+        if (VkResult result = create(handle)) return result;
+        objects.emplace(std::move(key), handle);
+        return VK_SUCCESS;
+    }
+    // 销毁缓存中所有的对象，调用前需确保它们不再被使用
+    void Clear(void (*destroy)(VkDevice, handle_t, const VkAllocationCallbacks*))
+    {
+        std::lock_guard lock(mutex);
+        for (auto& [key, handle] : objects) destroy(graphicsBase::Base().Device(), handle, nullptr);
+        objects.clear();
+    }
+
+public:
+    // Getter
+    size_t ObjectCount() const
+    {
+        std::lock_guard lock(mutex);
+        return objects.size();
+    }
+    uint64_t HitCount() const
+    {
+        std::lock_guard lock(mutex);
+        return hitCount;
+    }
+    uint64_t MissCount() const
+    {
+        std::lock_guard lock(mutex);
+        return missCount;
+    }
+    // 命中次数占查询次数的比例
+    double HitRate() const
+    {
+        std::lock_guard lock(mutex);
+        uint64_t lookupCount = hitCount + missCount;
+        return lookupCount ? double(hitCount) / lookupCount : 0.;
+    }
+};
+
+// 采样器缓存，同时也避免采样器的个数超出 maxSamplerAllocationCount
+// pNext 中仅支持 VkSamplerReductionModeCreateInfo
+struct samplerKey {
+    VkSamplerCreateInfo createInfo;
+    VkSamplerReductionMode reductionMode;
+    auto Tie() const
+    {
+        const VkSamplerCreateInfo& i = createInfo;
+        return std::tie(i.flags, i.magFilter, i.minFilter, i.mipmapMode, i.addressModeU,
+                        i.addressModeV, i.addressModeW, i.mipLodBias, i.anisotropyEnable,
+                        i.maxAnisotropy, i.compareEnable, i.compareOp, i.minLod, i.maxLod,
+                        i.borderColor, i.unnormalizedCoordinates, reductionMode);
+    }
+    bool operator==(const samplerKey& other) const
+    {
+        return Tie() == other.Tie();
+    }
+    size_t Hash() const
+    {
+        return HashTuple(Tie());
+    }
+};
+class samplerCache : public objectCache<samplerKey, VkSampler> {
+    samplerCache()
+    {
+        graphicsBase::Base().AddCallback_DestroyDevice([] { Base().Clear(vkDestroySampler); });
+    }
+    samplerCache(samplerCache&&) = delete;
+
+public:
+    // Non-const Function
+    VkResult Get(const VkSamplerCreateInfo& createInfo, VkSampler& sampler)
+    {
+        samplerKey key = {createInfo, VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE};
+        for (auto i = reinterpret_cast<const VkBaseInStructure*>(createInfo.pNext); i;
+             i = i->pNext)
+            if (i->sType == VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO)
+                key.reductionMode =
+                    reinterpret_cast<const VkSamplerReductionModeCreateInfo*>(i)->reductionMode;
+            else {
+                std::cout << std::format(
+                    "[ samplerCache ] ERROR\nUnsupported structure in pNext: {}\n",
+                    int32_t(i->sType));
+                return VK_ERROR_FEATURE_NOT_PRESENT;
+            }
+        uint32_t limit =
+            graphicsBase::Base().PhysicalDeviceProperties().limits.maxSamplerAllocationCount;
+        VkResult result = GetOrCreate(
+            std::move(key), sampler,
+            [&createInfo](VkSampler& handle) {
+                VkResult result =
+                    vkCreateSampler(graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+                if (result)
+                    std::cout << std::format(
+                        "[ samplerCache ] ERROR\nFailed to create a sampler!\nError code: {}\n",
+                        int32_t(result));
+                return result;
+            },
+            limit);
+        if (result == VK_ERROR_TOO_MANY_OBJECTS)
+            std::cout << std::format(
+                "[ samplerCache ] ERROR\nSampler count reached maxSamplerAllocationCount: {}\n",
+                limit);
+        return result;
+    }
+    // Static Function
+    static samplerCache& Base()
+    {
+        static samplerCache singleton;
+        return singleton;
+    }
+};
+
+// 描述符集布局缓存，绑定按 binding 排序后作为键，声明顺序不同但内容相同的布局也会被去重
+// pNext 中仅支持 VkDescriptorSetLayoutBindingFlagsCreateInfo
+struct descriptorSetLayoutKey {
+    struct bindingKey {
+        uint32_t binding;
+        VkDescriptorType descriptorType;
+        uint32_t descriptorCount;
+        VkShaderStageFlags stageFlags;
+        VkDescriptorBindingFlags bindingFlags;
+        std::vector<VkSampler> immutableSamplers;
+        bool operator==(const bindingKey&) const = default;
+    };
+    VkDescriptorSetLayoutCreateFlags flags;
+    std::vector<bindingKey> bindings;
+    bool operator==(const descriptorSetLayoutKey&) const = default;
+    size_t Hash() const
+    {
+        size_t seed = std::hash<VkDescriptorSetLayoutCreateFlags>()(flags);
+        for (auto& i : bindings) {
+            HashCombine(seed, HashTuple(std::tie(i.binding, i.descriptorType, i.descriptorCount,
+                                                 i.stageFlags, i.bindingFlags)));
+            for (auto j : i.immutableSamplers) HashCombine(seed, j);
+        }
+        return seed;
+    }
+};
+class descriptorSetLayoutCache : public objectCache<descriptorSetLayoutKey, VkDescriptorSetLayout> {
+    descriptorSetLayoutCache()
+    {
+        graphicsBase::Base().AddCallback_DestroyDevice(
+            [] { Base().Clear(vkDestroyDescriptorSetLayout); });
+    }
+    descriptorSetLayoutCache(descriptorSetLayoutCache&&) = delete;
+
+public:
+    // Non-const Function
+    VkResult Get(const VkDescriptorSetLayoutCreateInfo& createInfo,
+                 VkDescriptorSetLayout& setLayout)
+    {
+        const VkDescriptorBindingFlags* pBindingFlags = nullptr;
+        for (auto i = reinterpret_cast<const VkBaseInStructure*>(createInfo.pNext); i;
+             i = i->pNext)
+            if (i->sType == VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO) {
+                auto& bindingFlagsCreateInfo =
+                    *reinterpret_cast<const VkDescriptorSetLayoutBindingFlagsCreateInfo*>(i);
+                if (bindingFlagsCreateInfo.bindingCount)
+                    pBindingFlags = bindingFlagsCreateInfo.pBindingFlags;
+            } else {
+                std::cout << std::format(
+                    "[ descriptorSetLayoutCache ] ERROR\nUnsupported structure in pNext: {}\n",
+                    int32_t(i->sType));
+                return VK_ERROR_FEATURE_NOT_PRESENT;
+            }
+        descriptorSetLayoutKey key = {.flags = createInfo.flags};
+        key.bindings.reserve(createInfo.bindingCount);
+        for (uint32_t i = 0; i < createInfo.bindingCount; i++) {
+            const VkDescriptorSetLayoutBinding& binding = createInfo.pBindings[i];
+            auto& bindingKey = key.bindings.emplace_back(descriptorSetLayoutKey::bindingKey{
+                .binding = binding.binding,
+                .descriptorType = binding.descriptorType,
+                .descriptorCount = binding.descriptorCount,
+                .stageFlags = binding.stageFlags,
+                .bindingFlags = pBindingFlags ? pBindingFlags[i] : 0});
+            if (binding.pImmutableSamplers)
+                bindingKey.immutableSamplers.assign(
+                    binding.pImmutableSamplers,
+                    binding.pImmutableSamplers + binding.descriptorCount);
+        }
+        std::ranges::sort(key.bindings, {}, &descriptorSetLayoutKey::bindingKey::binding);
+        return GetOrCreate(std::move(key), setLayout,
+                           [&createInfo](VkDescriptorSetLayout& handle) {
+                               VkResult result = vkCreateDescriptorSetLayout(
+                                   graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+                               if (result)
+                                   std::cout << std::format(
+                                       "[ descriptorSetLayoutCache ] ERROR\nFailed to create a "
+                                       "descriptor set layout!\nError code: {}\n",
+                                       int32_t(result));
+                               return result;
+                           });
+    }
+    // Static Function
+    static descriptorSetLayoutCache& Base()
+    {
+        static descriptorSetLayoutCache singleton;
+        return singleton;
+    }
+};
+
+// 管线布局缓存，描述符集布局取自 descriptorSetLayoutCache 时，按句柄比较即相当于按内容比较
+struct pipelineLayoutKey {
+    VkPipelineLayoutCreateFlags flags;
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    std::vector<std::tuple<VkShaderStageFlags, uint32_t, uint32_t>> pushConstantRanges;
+    bool operator==(const pipelineLayoutKey&) const = default;
+    size_t Hash() const
+    {
+        size_t seed = std::hash<VkPipelineLayoutCreateFlags>()(flags);
+        for (auto i : setLayouts) HashCombine(seed, i);
+        for (auto& i : pushConstantRanges) HashCombine(seed, HashTuple(i));
+        return seed;
+    }
+};
+class pipelineLayoutCache : public objectCache<pipelineLayoutKey, VkPipelineLayout> {
+    pipelineLayoutCache()
+    {
+        graphicsBase::Base().AddCallback_DestroyDevice(
+            [] { Base().Clear(vkDestroyPipelineLayout); });
+    }
+    pipelineLayoutCache(pipelineLayoutCache&&) = delete;
+
+public:
+    // Non-const Function
+    VkResult Get(const VkPipelineLayoutCreateInfo& createInfo, VkPipelineLayout& pipelineLayout)
+    {
+        if (createInfo.pNext) {
+            std::cout << std::format(
+                "[ pipelineLayoutCache ] ERROR\npNext is not supported for cached pipeline "
+                "layouts!\n");
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        pipelineLayoutKey key = {
+            .flags = createInfo.flags,
+            .setLayouts = {createInfo.pSetLayouts,
+                           createInfo.pSetLayouts + createInfo.setLayoutCount}};
+        for (uint32_t i = 0; i < createInfo.pushConstantRangeCount; i++) {
+            const VkPushConstantRange& range = createInfo.pPushConstantRanges[i];
+            key.pushConstantRanges.emplace_back(range.stageFlags, range.offset, range.size);
+        }
+        return GetOrCreate(std::move(key), pipelineLayout,
+                           [&createInfo](VkPipelineLayout& handle) {
+                               VkResult result = vkCreatePipelineLayout(
+                                   graphicsBase::Base().Device(), &createInfo, nullptr, &handle);
+                               if (result)
+                                   std::cout << std::format(
+                                       "[ pipelineLayoutCache ] ERROR\nFailed to create a "
+                                       "pipeline layout!\nError code: {}\n",
+                                       int32_t(result));
+                               return result;
+                           });
+    }
+    // Static Function
+    static pipelineLayoutCache& Base()
+    {
+        static pipelineLayoutCache singleton;
+        return singleton;
+    }
+};
+}  // namespace vulkan
@@ -0,0 +1,386 @@
+#pragma once
+#include "VKPipelineService.h"
+
+namespace vulkan {
+// VK_EXT_graphics_pipeline_library：将图形管线拆为四个部分分别编译，绘制前再将其链接
+// 设备支持时由 CreateDevice 开启，pipelineLibrary 据 Enabled() 自动选择库路径或整体编译的路径
+class graphicsPipelineLibrary {
+    bool enabled = false;
+    bool fastLinking = false;
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT};
+
+    //--------------------
+    graphicsPipelineLibrary() = default;
+    graphicsPipelineLibrary(graphicsPipelineLibrary&&) = delete;
+    // Non-const Function
+    // 逻辑设备创建后，确认特性是否已开启，并查询快速链接是否真的快
+    void OnCreateDevice()
+    {
+        enabled = graphicsPipelineLibraryFeatures.graphicsPipelineLibrary;
+        fastLinking = false;
+        if (!enabled) return;
+        VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphicsPipelineLibraryProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT};
+        VkPhysicalDeviceProperties2 properties2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &graphicsPipelineLibraryProperties};
+        vkGetPhysicalDeviceProperties2(graphicsBase::Base().PhysicalDevice(), &properties2);
+        fastLinking = graphicsPipelineLibraryProperties.graphicsPipelineLibraryFastLinking;
+    }
+
+public:
+    // Getter
+    // 逻辑设备创建后有效
+    bool Enabled() const
+    {
+        return enabled;
+    }
+    // 为 false 时，不带 LINK_TIME_OPTIMIZATION 的链接也可能耗时较长
+    bool FastLinking() const
+    {
+        return fastLinking;
+    }
+    // Non-const Function
+    // 在 DeterminePhysicalDevice 后、CreateDevice 前调用，设备不支持时返回
+    // VK_ERROR_EXTENSION_NOT_PRESENT，此后 pipelineLibrary 整体编译每个管线
+    VkResult Enable()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        static bool callbackAdded = false;
+        if (!callbackAdded) {
+            base.AddCallback_CreateDevice([] { Base().OnCreateDevice(); });
+            callbackAdded = true;
+        }
+        // 特性须经由 vkGetPhysicalDeviceFeatures2 查询
+        if (base.DeviceApiVersion() < VK_API_VERSION_1_1) return VK_ERROR_FEATURE_NOT_PRESENT;
+        const char* extensionNames[] = {VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME,
+                                        VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME};
+        if (VkResult result = base.CheckDeviceExtensions(extensionNames)) return result;
+        for (auto i : extensionNames)
+            if (!i) return VK_ERROR_EXTENSION_NOT_PRESENT;
+        for (auto i : extensionNames) base.AddDeviceExtension(i);
+        base.AddNextStructure_PhysicalDeviceFeatures(graphicsPipelineLibraryFeatures);
+        return VK_SUCCESS;
+    }
+    // Static Function
+    static graphicsPipelineLibrary& Base()
+    {
+        static graphicsPipelineLibrary singleton;
+        return singleton;
+    }
+};
+
+// 由四个部分组合图形管线，部分之间可任意组合，顶点格式、着色器、混合方式的各种排列无需各自完整编译
+// 1. 四个部分（顶点输入、光栅化前着色器、片段着色器、片段输出）各编译一次，
+//    CreatePart 的 createInfo 中只需填写该部分相关的状态，以及光栅化前与片段着色器部分的 layout
+// 2. Link 快速链接四个部分，耗时通常为微秒级，可在首次用到某个组合时于渲染线程上调用；
+//    optimize 为 true 时另在 service 的工作线程上做链接时优化，完成后 Pipeline() 换用优化后的管线
+// 3. 设备不支持时，Link 经由 service 在后台整体编译，完成前 Pipeline() 返回 VK_NULL_HANDLE，
+//    可以 PipelineOr() 换用回退管线
+// 不支持时各部分的 createInfo 被按值保存，其中的指针所指向的各状态须在部分销毁前保持有效
+// 除 CreatePart 外须与 service 的 Request* 在同一个线程上调用；各部分与 service 须使用兼容的
+// pipeline layout
+class pipelineLibrary {
+public:
+    enum part_t : uint32_t {
+        part_vertexInput,
+        part_preRasterization,
+        part_fragmentShader,
+        part_fragmentOutput,
+        part_count
+    };
+    using partHandle_t = uint32_t;
+    using handle_t = uint32_t;
+    struct linkStatistics {
+        uint32_t partCount;
+        uint32_t linkCount;
+        uint32_t optimizeCount;  // 请求的链接时优化或整体编译的次数
+        double partTime;         // 编译各部分的总耗时，单位为毫秒
+        double linkTime;         // 快速链接的总耗时，单位为毫秒
+        double maxLinkTime;
+    };
+
+private:
+    struct part {
+        part_t type;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        VkPipelineCreateFlags flags = 0;               // 除只对库有意义的位以外的 flags
+        VkPipeline library = VK_NULL_HANDLE;           // 库路径下有效
+        VkGraphicsPipelineCreateInfo createInfo = {};  // 整体编译的路径下有效
+        std::vector<VkPipelineShaderStageCreateInfo> stages;
+        std::vector<VkDynamicState> dynamicStates;
+    };
+    struct link {
+        VkPipeline fastLinked = VK_NULL_HANDLE;
+        pipelineService::handle_t optimized = UINT32_MAX;
+    };
+    static constexpr VkGraphicsPipelineLibraryFlagsEXT libraryFlags[part_count] = {
+        VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+        VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+        VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+        VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT};
+    // 各部分的其余 flags 须一并用于链接或整体编译，如 VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT
+    // 在各个库与链接所得的管线间须一致，否则管线与描述符缓冲区的布局不兼容
+    static constexpr VkPipelineCreateFlags libraryOnlyFlags =
+        VK_PIPELINE_CREATE_LIBRARY_BIT_KHR |
+        VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT |
+        VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+    pipelineService& service;
+    std::deque<part> parts;
+    std::deque<link> links;
+    std::map<std::array<partHandle_t, part_count>, handle_t> linkIndices;
+    linkStatistics statistics = {};
+    mutable std::mutex mutex;  // 保护 parts 与 statistics，使 CreatePart 可在加载线程上调用
+
+    //--------------------
+    // 各部分 flags 的并集
+    VkPipelineCreateFlags PartFlags(const std::array<partHandle_t, part_count>& handles) const
+    {
+        VkPipelineCreateFlags flags = 0;
+        for (auto i : handles) flags |= parts[i].flags;
+        return flags;
+    }
+    // 以四个部分的 createInfo 拼出整体编译所用的 createInfo，结果中的数组指针指向 stages 等
+    VkGraphicsPipelineCreateInfo MergeParts(const std::array<partHandle_t, part_count>& handles,
+                                            std::vector<VkPipelineShaderStageCreateInfo>& stages,
+                                            std::vector<VkDynamicState>& dynamicStates) const
+    {
+        const VkGraphicsPipelineCreateInfo& vertexInput = parts[handles[0]].createInfo;
+        const VkGraphicsPipelineCreateInfo& preRasterization = parts[handles[1]].createInfo;
+        const VkGraphicsPipelineCreateInfo& fragmentShader = parts[handles[2]].createInfo;
+        const VkGraphicsPipelineCreateInfo& fragmentOutput = parts[handles[3]].createInfo;
+        for (auto i : handles) {
+            stages.insert(stages.end(), parts[i].stages.begin(), parts[i].stages.end());
+            for (auto j : parts[i].dynamicStates)
+                if (std::ranges::find(dynamicStates, j) == dynamicStates.end())
+                    dynamicStates.push_back(j);
+        }
+        // 动态渲染的附件格式等由片段输出部分的 pNext 提供
+        return {.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                .pNext = fragmentOutput.pNext,
+                .flags = PartFlags(handles),
+                .stageCount = uint32_t(stages.size()),
+                .pStages = stages.data(),
+                .pVertexInputState = vertexInput.pVertexInputState,
+                .pInputAssemblyState = vertexInput.pInputAssemblyState,
+                .pTessellationState = preRasterization.pTessellationState,
+                .pViewportState = preRasterization.pViewportState,
+                .pRasterizationState = preRasterization.pRasterizationState,
+                .pMultisampleState = fragmentOutput.pMultisampleState
+                                         ? fragmentOutput.pMultisampleState
+                                         : fragmentShader.pMultisampleState,
+                .pDepthStencilState = fragmentShader.pDepthStencilState,
+                .pColorBlendState = fragmentOutput.pColorBlendState,
+                .layout = preRasterization.layout,
+                .renderPass = fragmentOutput.renderPass,
+                .subpass = fragmentOutput.subpass};
+    }
+
+public:
+    pipelineLibrary(pipelineService& service) : service(service) {}
+    pipelineLibrary(pipelineLibrary&&) = delete;
+    ~pipelineLibrary()
+    {
+        Destroy();
+    }
+    // Getter
+    bool UseLibrary() const
+    {
+        return graphicsPipelineLibrary::Base().Enabled();
+    }
+    linkStatistics Statistics() const
+    {
+        std::lock_guard lock(mutex);
+        return statistics;
+    }
+    // 优化后的管线就绪后返回它，否则返回快速链接所得的管线；整体编译完成前返回 VK_NULL_HANDLE
+    VkPipeline Pipeline(handle_t handle) const
+    {
+        const link& item = links[handle];
+        if (item.optimized != UINT32_MAX)
+            if (VkPipeline pipeline = service.Pipeline(item.optimized)) return pipeline;
+        return item.fastLinked;
+    }
+    VkPipeline PipelineOr(handle_t handle, VkPipeline fallback) const
+    {
+        VkPipeline pipeline = Pipeline(handle);
+        return pipeline ? pipeline : fallback;
+    }
+    // 是否已换用链接时优化或整体编译所得的管线
+    bool Optimized(handle_t handle) const
+    {
+        const link& item = links[handle];
+        return item.optimized != UINT32_MAX && service.Pipeline(item.optimized);
+    }
+    // Non-const Function
+    // 编译管线的一个部分，库路径下同步编译，可在加载时或工作线程之外的加载线程上调用
+    VkResult CreatePart(part_t type, const VkGraphicsPipelineCreateInfo& createInfo,
+                        partHandle_t& handle)
+    {
+        part item = {.type = type,
+                     .layout = createInfo.layout,
+                     .flags = createInfo.flags & ~libraryOnlyFlags};
+        double partTime = 0;
+        if (!UseLibrary()) {
+            item.createInfo = createInfo;
+            item.stages.assign(createInfo.pStages, createInfo.pStages + createInfo.stageCount);
+            if (createInfo.pDynamicState)
+                item.dynamicStates.assign(createInfo.pDynamicState->pDynamicStates,
+                                          createInfo.pDynamicState->pDynamicStates +
+                                              createInfo.pDynamicState->dynamicStateCount);
+            item.createInfo.pStages = nullptr;
+            item.createInfo.pDynamicState = nullptr;
+        } else {
+            auto time0 = std::chrono::steady_clock::now();
+            VkGraphicsPipelineLibraryCreateInfoEXT libraryCreateInfo = {
+                .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+                .pNext = const_cast<void*>(createInfo.pNext),
+                .flags = libraryFlags[type]};
+            VkGraphicsPipelineCreateInfo libraryInfo = createInfo;
+            libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            libraryInfo.pNext = &libraryCreateInfo;
+            // 保留链接时优化所需的信息，以便之后在后台做优化链接
+            libraryInfo.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR |
+                                 VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+            VkResult result = vkCreateGraphicsPipelines(graphicsBase::Base().Device(),
+                                                        service.MainCache(), 1, &libraryInfo,
+                                                        nullptr, &item.library);
+            if (result) {
+                std::cout << std::format(
+                    "[ pipelineLibrary ] ERROR\nFailed to create a graphics pipeline library!\n"
+                    "Error code: {}\n",
+                    int32_t(result));
+                return result;
+            }
+            partTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                                 time0)
+                           .count();
+        }
+        std::lock_guard lock(mutex);
+        statistics.partTime += partTime;
+        statistics.partCount++;
+        parts.push_back(std::move(item));
+        handle = partHandle_t(parts.size() - 1);
+        return VK_SUCCESS;
+    }
+    // handles 依次为四种部分的句柄，同一组合只链接一次，之后返回同一个句柄
+    // 库路径下 optimize 为 true 时另在后台做链接时优化；整体编译的路径下总是在后台编译
+    VkResult Link(const std::array<partHandle_t, part_count>& handles, handle_t& handle,
+                  bool optimize = true)
+    {
+        std::lock_guard lock(mutex);
+        if (auto it = linkIndices.find(handles); it != linkIndices.end()) {
+            handle = it->second;
+            return VK_SUCCESS;
+        }
+        for (uint32_t i = 0; i < part_count; i++)
+            if (parts[handles[i]].type != i) {
+                std::cout << std::format(
+                    "[ pipelineLibrary ] ERROR\nPart {} is of a wrong type!\n", handles[i]);
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+        link item;
+        if (!UseLibrary()) {
+            std::vector<VkPipelineShaderStageCreateInfo> stages;
+            std::vector<VkDynamicState> dynamicStates;
+            VkGraphicsPipelineCreateInfo createInfo = MergeParts(handles, stages, dynamicStates);
+            item.optimized = service.Request(
+                [createInfo, stages = std::move(stages), dynamicStates = std::move(dynamicStates)](
+                    VkPipelineCache cache, VkPipeline& pipeline) mutable {
+                    VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {
+                        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+                        .dynamicStateCount = uint32_t(dynamicStates.size()),
+                        .pDynamicStates = dynamicStates.data()};
+                    createInfo.pStages = stages.data();
+                    createInfo.pDynamicState = &dynamicStateCreateInfo;
+                    VkResult result = vkCreateGraphicsPipelines(
+                        graphicsBase::Base().Device(), cache, 1, &createInfo, nullptr, &pipeline);
+                    if (result)
+                        std::cout << std::format(
+                            "[ pipelineLibrary ] ERROR\nFailed to create a graphics pipeline!\n"
+                            "Error code: {}\n",
+                            int32_t(result));
+                    return result;
+                });
+            statistics.optimizeCount++;
+        } else {
+            std::array<VkPipeline, part_count> libraries;
+            for (uint32_t i = 0; i < part_count; i++) libraries[i] = parts[handles[i]].library;
+            // 链接所得的管线使用光栅化前着色器部分的 layout
+            VkPipelineLayout layout = parts[handles[part_preRasterization]].layout;
+            VkPipelineCreateFlags flags = PartFlags(handles);
+            auto time0 = std::chrono::steady_clock::now();
+            VkPipelineLibraryCreateInfoKHR libraryInfo = {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+                .libraryCount = part_count,
+                .pLibraries = libraries.data()};
+            VkGraphicsPipelineCreateInfo createInfo = {
+                .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                .pNext = &libraryInfo,
+                .flags = flags,
+                .layout = layout};
+            VkResult result = vkCreateGraphicsPipelines(graphicsBase::Base().Device(),
+                                                        service.MainCache(), 1, &createInfo,
+                                                        nullptr, &item.fastLinked);
+            if (result) {
+                std::cout << std::format(
+                    "[ pipelineLibrary ] ERROR\nFailed to link a graphics pipeline!\nError code: "
+                    "{}\n",
+                    int32_t(result));
+                return result;
+            }
+            double linkTime = std::chrono::duration<double, std::milli>(
+                                  std::chrono::steady_clock::now() - time0)
+                                  .count();
+            statistics.linkTime += linkTime;
+            statistics.maxLinkTime = std::max(statistics.maxLinkTime, linkTime);
+            if (optimize) {
+                item.optimized = service.Request(
+                    [libraries, layout, flags](VkPipelineCache cache, VkPipeline& pipeline) {
+                        VkPipelineLibraryCreateInfoKHR libraryInfo = {
+                            .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+                            .libraryCount = part_count,
+                            .pLibraries = libraries.data()};
+                        VkGraphicsPipelineCreateInfo createInfo = {
+                            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                            .pNext = &libraryInfo,
+                            .flags = flags | VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT,
+                            .layout = layout};
+                        VkResult result =
+                            vkCreateGraphicsPipelines(graphicsBase::Base().Device(), cache, 1,
+                                                      &createInfo, nullptr, &pipeline);
+                        if (result)
+                            std::cout << std::format(
+                                "[ pipelineLibrary ] ERROR\nFailed to link an optimized "
+                                "graphics pipeline!\nError code: {}\n",
+                                int32_t(result));
+                        return result;
+                    });
+                statistics.optimizeCount++;
+            }
+        }
+        statistics.linkCount++;
+        links.push_back(item);
+        handle = handle_t(links.size() - 1);
+        linkIndices.emplace(handles, handle);
+        return VK_SUCCESS;
+    }
+    // 等待后台的编译结束后销毁所有部分和快速链接所得的管线，优化后的管线仍由 service 持有
+    // 须确保设备不再使用这些管线
+    void Destroy()
+    {
+        service.WaitIdle();
+        std::lock_guard lock(mutex);
+        VkDevice device = graphicsBase::Base().Device();
+        for (auto& i : links)
+            if (i.fastLinked) vkDestroyPipeline(device, i.fastLinked, nullptr);
+        for (auto& i : parts)
+            if (i.library) vkDestroyPipeline(device, i.library, nullptr);
+        links.clear();
+        parts.clear();
+        linkIndices.clear();
+        statistics = {};
+    }
+};
+}  // namespace vulkan
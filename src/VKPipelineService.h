@@ -0,0 +1,229 @@
+#pragma once
+#include "ThreadPool.hpp"
+#include "VKBase.h"
+
+namespace vulkan {
+// 异步管线编译：在工作线程上创建图形与计算管线，避免新材质首次出现时渲染线程卡顿数毫秒
+// 1. Request* 立即返回句柄，编译完成前 Pipeline() 返回 VK_NULL_HANDLE，渲染线程可跳过该次绘制，
+//    或以 PipelineOr() 换用回退管线
+// 2. 每个工作线程有各自的 VkPipelineCache，编译时互不争用；MergeCaches 将其并入主缓存，
+//    主缓存的数据可保存到文件，下次启动时作为初始数据
+// 3. 记录每次编译的耗时，按 2 的幂划分区间计入直方图
+// Request*、Pipeline 等须在同一个线程（通常为渲染线程）上调用
+// 编译耗时较长，workers 宜专用，与 parallelRecorder 共用时会拖慢录制
+class pipelineService {
+public:
+    using handle_t = uint32_t;
+    enum pipelineState : uint32_t {
+        state_pending,
+        state_ready,
+        state_failed
+    };
+    // 第 0 个区间为 [0, 1) 毫秒，第 i 个为 [2^(i-1), 2^i) 毫秒，最后一个区间包含所有更长的耗时
+    static constexpr uint32_t histogramBucketCount = 10;
+    struct compileStatistics {
+        uint32_t requestedCount;
+        uint32_t compiledCount;
+        uint32_t failedCount;
+        double totalTime;  // 编译的总耗时，单位为毫秒，多线程时为各线程之和
+        double maxTime;
+        uint32_t histogram[histogramBucketCount];
+    };
+    // 在工作线程上被调用，以 cache 创建管线
+    using createFunction_t = std::function<VkResult(VkPipelineCache cache, VkPipeline& pipeline)>;
+
+private:
+    struct entry {
+        std::atomic<pipelineState> state = state_pending;
+        VkPipeline pipeline = VK_NULL_HANDLE;  // state 为 ready 后有效
+        double compileTime = 0;
+    };
+    // 对齐到缓存行，避免相邻工作线程的互斥量出现伪共享
+    struct alignas(64) workerCache {
+        pipelineCache cache;
+        std::mutex mutex;  // 编译与合并时持有，所以缓存可带 EXTERNALLY_SYNCHRONIZED_BIT
+    };
+    threadPool& workers;
+    pipelineCache mainCache;
+    std::vector<workerCache> workerCaches;  // 下标为工作线程编号
+    std::deque<entry> entries;              // 下标为句柄，deque 扩充时不移动已有的元素
+    std::mutex mutex;                       // 保护 statistics 与 pendingCount
+    std::condition_variable condition_idle;
+    uint32_t pendingCount = 0;
+    compileStatistics statistics = {};
+
+    //--------------------
+    void Finish(entry& item, VkResult result, VkPipeline handle, double compileTime)
+    {
+        item.pipeline = handle;
+        item.compileTime = compileTime;
+        item.state.store(result ? state_failed : state_ready,
+                         std::memory_order_release);
+        std::lock_guard lock(mutex);
+        if (result)
+            statistics.failedCount++;
+        else {
+            statistics.compiledCount++;
+            statistics.totalTime += compileTime;
+            statistics.maxTime = std::max(statistics.maxTime, compileTime);
+            uint32_t bucket = 0;
+            for (double bound = 1; compileTime >= bound && bucket + 1 < histogramBucketCount;
+                 bound *= 2)
+                bucket++;
+            statistics.histogram[bucket]++;
+        }
+        if (!--pendingCount) condition_idle.notify_all();
+    }
+
+public:
+    pipelineService(threadPool& workers) : workers(workers) {}
+    pipelineService(pipelineService&&) = delete;
+    ~pipelineService()
+    {
+        Destroy();
+    }
+    // Getter
+    VkPipelineCache MainCache() const
+    {
+        return mainCache;
+    }
+    pipelineState State(handle_t handle) const
+    {
+        return entries[handle].state.load(std::memory_order_acquire);
+    }
+    // 编译完成前返回 VK_NULL_HANDLE
+    VkPipeline Pipeline(handle_t handle) const
+    {
+        const entry& item = entries[handle];
+        return item.state.load(std::memory_order_acquire) == state_ready
+                   ? item.pipeline
+                   : VK_NULL_HANDLE;
+    }
+    // 编译完成前或编译失败时返回 fallback，如同一材质的简化版本
+    VkPipeline PipelineOr(handle_t handle, VkPipeline fallback) const
+    {
+        VkPipeline pipeline = Pipeline(handle);
+        return pipeline ? pipeline : fallback;
+    }
+    // 单位为毫秒，编译完成前为 0
+    double CompileTime(handle_t handle) const
+    {
+        return State(handle) == state_pending ? 0 : entries[handle].compileTime;
+    }
+    compileStatistics Statistics()
+    {
+        std::lock_guard lock(mutex);
+        return statistics;
+    }
+    // Non-const Function
+    // initialData 为之前保存的缓存数据，用于初始化主缓存和各工作线程的缓存
+    VkResult Create(std::span<const uint8_t> initialData = {})
+    {
+        Destroy();
+        if (VkResult result = mainCache.Create(initialData)) return result;
+        // 每个缓存只被一个线程使用，不需要驱动加锁
+        VkPipelineCacheCreateFlags flags =
+            graphicsBase::Base().PhysicalDeviceVulkan13Features().pipelineCreationCacheControl
+                ? VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT
+                : 0;
+        workerCaches = std::vector<workerCache>(workers.WorkerCount());
+        for (auto& i : workerCaches)
+            if (VkResult result = i.cache.Create(initialData, flags)) return result;
+        return VK_SUCCESS;
+    }
+    // create 所引用的数据须在编译完成前保持有效
+    // 在 Create 前调用时不编译，返回的句柄处于 state_failed
+    handle_t Request(createFunction_t create)
+    {
+        entry& item = entries.emplace_back();
+        if (workerCaches.empty()) {
+            std::cout << std::format("[ pipelineService ] ERROR\nNot created yet!\n");
+            item.state.store(state_failed, std::memory_order_release);
+            std::lock_guard lock(mutex);
+            statistics.requestedCount++;
+            statistics.failedCount++;
+            return handle_t(entries.size() - 1);
+        }
+        {
+            std::lock_guard lock(mutex);
+            statistics.requestedCount++;
+            pendingCount++;
+        }
+        workers.Enqueue([this, &item, create = std::move(create)](uint32_t workerIndex) {
+            workerCache& worker = workerCaches[workerIndex];
+            VkPipeline handle = VK_NULL_HANDLE;
+            auto time0 = std::chrono::steady_clock::now();
+            VkResult result;
+            {
+                std::lock_guard lock(worker.mutex);
+                result = create(worker.cache, handle);
+            }
+            Finish(item, result, handle,
+                   std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                             time0)
+                       .count());
+        });
+        return handle_t(entries.size() - 1);
+    }
+    // createInfo 按值保存，但其中的指针所指向的着色器阶段、各状态等须在编译完成前保持有效
+    handle_t RequestGraphics(const VkGraphicsPipelineCreateInfo& createInfo)
+    {
+        return Request([createInfo](VkPipelineCache cache, VkPipeline& pipeline) {
+            VkResult result = vkCreateGraphicsPipelines(graphicsBase::Base().Device(), cache, 1,
+                                                        &createInfo, nullptr, &pipeline);
+            if (result)
+                std::cout << std::format(
+                    "[ pipelineService ] ERROR\nFailed to create a graphics pipeline!\nError "
+                    "code: {}\n",
+                    int32_t(result));
+            return result;
+        });
+    }
+    handle_t RequestCompute(const VkComputePipelineCreateInfo& createInfo)
+    {
+        return Request([createInfo](VkPipelineCache cache, VkPipeline& pipeline) {
+            VkResult result = vkCreateComputePipelines(graphicsBase::Base().Device(), cache, 1,
+                                                       &createInfo, nullptr, &pipeline);
+            if (result)
+                std::cout << std::format(
+                    "[ pipelineService ] ERROR\nFailed to create a compute pipeline!\nError "
+                    "code: {}\n",
+                    int32_t(result));
+            return result;
+        });
+    }
+    // 阻塞直到所有已请求的管线编译完毕，如在加载画面结束前调用
+    void WaitIdle()
+    {
+        std::unique_lock lock(mutex);
+        condition_idle.wait(lock, [this] { return !pendingCount; });
+    }
+    // 将各工作线程的缓存并入主缓存，每个工作线程的缓存在其当前的编译结束后才被合并
+    VkResult MergeCaches()
+    {
+        for (auto& i : workerCaches) {
+            std::lock_guard lock(i.mutex);
+            VkPipelineCache srcCache = i.cache;
+            if (VkResult result = mainCache.Merge({&srcCache, 1})) return result;
+        }
+        return VK_SUCCESS;
+    }
+    // 合并后取得主缓存的数据，可写入文件
+    VkResult GetCacheData(std::vector<uint8_t>& data)
+    {
+        if (VkResult result = MergeCaches()) return result;
+        return mainCache.GetData(data);
+    }
+    // 等待编译完毕后销毁所有管线和缓存，须确保设备不再使用这些管线
+    void Destroy()
+    {
+        WaitIdle();
+        for (auto& i : entries)
+            if (i.pipeline) vkDestroyPipeline(graphicsBase::Base().Device(), i.pipeline, nullptr);
+        entries.clear();
+        workerCaches.clear();
+        pipelineCache(std::move(mainCache));
+        statistics = {};
+    }
+};
+}  // namespace vulkan
@@ -0,0 +1,428 @@
+#pragma once
+#include "VKCompute.h"
+#include "VKShaderModule.h"
+
+namespace vulkan {
+// GPU 并行原语：归约、前缀和、流压缩、键值对基数排序，元素与值均为 uint32_t
+// 着色器位于 shader/ 下，以 glslangValidator 编译为 SPIR-V 后置于 Create 的 directory 下：
+//   glslangValidator -V --target-env vulkan1.2 X.comp -o X.spv
+//   glslangValidator -V --target-env vulkan1.2 -DUSE_SUBGROUP X.comp -o X_subgroup.spv
+// 其中 X 为 reduce、scan、compact、radix_sweep；radix_histogram 不使用子组运算，只需前者
+// 1. 设备的计算着色器支持子组的 basic 与 arithmetic 运算时载入 _subgroup 版本，
+//    否则载入以共享内存完成工作组内扫描的版本
+// 2. 前缀和与流压缩以 decoupled look-back 单趟完成；基数排序每 8 位一趟（onesweep），
+//    先以一次 dispatch 统计所有数位的直方图，32 位键 4 趟，64 位键 8 趟，排序是稳定的
+// 3. Cmd 系列函数录制到 computeContext::Begin 得到的命令缓冲区中，
+//    同一命令缓冲区中的各原语依次执行；临时缓冲区在 Create 时按 capacity 分配，各原语共用
+class parallelPrimitives {
+public:
+    enum primitive_t : uint32_t {
+        primitive_reduce,
+        primitive_scan,
+        primitive_compact,
+        primitive_sort32,
+        primitive_sort64
+    };
+    struct benchmarkResult {
+        double time;        // repeatCount 次测量的中位数，单位为毫秒
+        double throughput;  // 每秒处理的键（元素）数，单位为十亿
+        bool correct;       // 最后一次执行的结果与 CPU 上的计算结果是否一致
+    };
+    static constexpr uint32_t workgroupSize = 256;
+    static constexpr uint32_t tileSize = 1024;  // scan、compact、radix_sweep 中每块的元素个数
+    static constexpr uint32_t radix = 256;
+    static constexpr uint32_t maxGroupCount = 1024;  // 以网格跨步循环处理的内核的工作组数上限
+
+private:
+    computeContext* pContext = nullptr;
+    bool useSubgroup = false;
+    uint32_t capacity = 0;
+    computeKernel reduceKernel;
+    computeKernel scanKernel;
+    computeKernel compactKernel;
+    computeKernel histogramKernel;
+    computeKernel sweepKernel;
+    computeBuffer<uint32_t> tileStates;  // look-back 所用的计数器与各块的状态
+    computeBuffer<uint32_t> histograms;
+    computeBuffer<uint32_t> alternateKeys;  // 基数排序的乒乓缓冲区
+    computeBuffer<uint32_t> alternateValues;
+
+    //--------------------
+    VkResult LoadKernel(const char* directory, const char* name, bool hasSubgroupVariant,
+                        computeKernel& kernel)
+    {
+        std::string filepath = std::format("{}/{}{}.spv", directory, name,
+                                           useSubgroup && hasSubgroupVariant ? "_subgroup" : "");
+        shaderModuleRegistry::handle_t handle;
+        if (VkResult result = shaderModuleRegistry::Base().Load(filepath.c_str(), handle))
+            return result;
+        VkResult result = kernel.Create(shaderModuleRegistry::Base().Code(handle));
+        shaderModuleRegistry::Base().Release(handle);
+        return result;
+    }
+    VkResult CheckCount(uint32_t count) const
+    {
+        if (count <= capacity) return VK_SUCCESS;
+        std::cout << std::format(
+            "[ parallelPrimitives ] ERROR\nElement count {} exceeds the capacity {}!\n", count,
+            capacity);
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    // 清零计数器与 tileCount 个块的状态
+    void CmdClearTileStates(VkCommandBuffer commandBuffer, uint32_t tileCount,
+                            uint32_t wordsPerTile) const
+    {
+        computeContext::CmdFill(commandBuffer, tileStates, 0, 0,
+                                VkDeviceSize(1 + tileCount * wordsPerTile) * 4);
+    }
+    VkResult CmdSort(VkCommandBuffer commandBuffer, const computeBufferBase& keys,
+                     const computeBuffer<uint32_t>* pValues, uint32_t count, uint32_t keyWords)
+    {
+        if (VkResult result = CheckCount(count)) return result;
+        // radix_sweep.comp 将计数打包为 30 位
+        if (count >= 1u << 30) {
+            std::cout << std::format(
+                "[ parallelPrimitives ] ERROR\nSort element count {} must be less than 2^30!\n",
+                count);
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+        if (!count) return VK_SUCCESS;
+        struct {
+            uint32_t count;
+            uint32_t keyWords;
+            uint32_t pass;
+            uint32_t hasValues;
+        } pushConstants = {count, keyWords, 0, pValues != nullptr};
+        computeContext::CmdFill(commandBuffer, histograms, 0);
+        computeBinding histogramBindings[] = {computeBinding::Buffer(0, keys),
+                                              computeBinding::Buffer(1, histograms)};
+        uint32_t groupCount = std::min(histogramKernel.GroupCount(count), maxGroupCount);
+        if (VkResult result =
+                pContext->CmdDispatch(commandBuffer, histogramKernel, histogramBindings,
+                                      {groupCount, 1, 1}, pushConstants))
+            return result;
+        // 不排序值时，以键的缓冲区占位，着色器不会访问
+        const computeBufferBase& values = pValues ? *pValues : keys;
+        const computeBufferBase& alternate = pValues ? alternateValues : alternateKeys;
+        uint32_t tileCount = (count + tileSize - 1) / tileSize;
+        // 趟数为偶数，结果最终回到 keys 与 values 中
+        for (uint32_t pass = 0; pass < keyWords * 4; pass++) {
+            bool even = !(pass & 1);
+            computeBinding sweepBindings[] = {
+                computeBinding::Buffer(0, even ? keys : alternateKeys),
+                computeBinding::Buffer(1, even ? values : alternate),
+                computeBinding::Buffer(2, even ? alternateKeys : keys),
+                computeBinding::Buffer(3, even ? alternate : values),
+                computeBinding::Buffer(4, histograms),
+                computeBinding::Buffer(5, tileStates)};
+            pushConstants.pass = pass;
+            CmdClearTileStates(commandBuffer, tileCount, radix);
+            if (VkResult result =
+                    pContext->CmdDispatch(commandBuffer, sweepKernel, sweepBindings,
+                                          {tileCount, 1, 1}, pushConstants))
+                return result;
+        }
+        return VK_SUCCESS;
+    }
+
+public:
+    parallelPrimitives() = default;
+    parallelPrimitives(parallelPrimitives&&) = default;
+    // Getter
+    bool UseSubgroup() const
+    {
+        return useSubgroup;
+    }
+    uint32_t Capacity() const
+    {
+        return capacity;
+    }
+    // Non-const Function
+    // result 为 input 前 count 个元素的和（溢出时回绕）
+    VkResult CmdReduce(VkCommandBuffer commandBuffer, const computeBuffer<uint32_t>& input,
+                       uint32_t count, const computeBuffer<uint32_t>& result)
+    {
+        computeContext::CmdFill(commandBuffer, result, 0, 0, 4);
+        computeBinding bindings[] = {computeBinding::Buffer(0, input),
+                                     computeBinding::Buffer(1, result)};
+        uint32_t groupCount = std::clamp(reduceKernel.GroupCount(count), 1u, maxGroupCount);
+        return pContext->CmdDispatch(commandBuffer, reduceKernel, bindings, {groupCount, 1, 1},
+                                     count);
+    }
+    // inclusive 为 false 时为排他前缀和，input 与 output 可为同一缓冲区
+    VkResult CmdScan(VkCommandBuffer commandBuffer, const computeBuffer<uint32_t>& input,
+                     const computeBuffer<uint32_t>& output, uint32_t count, bool inclusive = false)
+    {
+        if (VkResult result = CheckCount(count)) return result;
+        if (!count) return VK_SUCCESS;
+        uint32_t tileCount = (count + tileSize - 1) / tileSize;
+        CmdClearTileStates(commandBuffer, tileCount, 3);
+        computeBinding bindings[] = {computeBinding::Buffer(0, input),
+                                     computeBinding::Buffer(1, output),
+                                     computeBinding::Buffer(2, tileStates)};
+        uint32_t pushConstants[] = {count, inclusive};
+        return pContext->CmdDispatch(commandBuffer, scanKernel, bindings, {tileCount, 1, 1},
+                                     pushConstants);
+    }
+    // 按顺序保留 flags 不为 0 的元素，保留的个数写入 outputCount 的首个元素
+    VkResult CmdCompact(VkCommandBuffer commandBuffer, const computeBuffer<uint32_t>& input,
+                        const computeBuffer<uint32_t>& flags,
+                        const computeBuffer<uint32_t>& output, uint32_t count,
+                        const computeBuffer<uint32_t>& outputCount)
+    {
+        if (VkResult result = CheckCount(count)) return result;
+        if (!count) {
+            computeContext::CmdFill(commandBuffer, outputCount, 0, 0, 4);
+            return VK_SUCCESS;
+        }
+        uint32_t tileCount = (count + tileSize - 1) / tileSize;
+        CmdClearTileStates(commandBuffer, tileCount, 3);
+        computeBinding bindings[] = {
+            computeBinding::Buffer(0, input), computeBinding::Buffer(1, flags),
+            computeBinding::Buffer(2, output), computeBinding::Buffer(3, tileStates),
+            computeBinding::Buffer(4, outputCount)};
+        return pContext->CmdDispatch(commandBuffer, compactKernel, bindings, {tileCount, 1, 1},
+                                     count);
+    }
+    // 按键稳定地原地排序前 count 个键值对，pValues 为空时只排序键，count 须小于 2^30
+    VkResult CmdSort(VkCommandBuffer commandBuffer, const computeBuffer<uint32_t>& keys,
+                     const computeBuffer<uint32_t>* pValues, uint32_t count)
+    {
+        return CmdSort(commandBuffer, keys, pValues, count, 1);
+    }
+    VkResult CmdSort(VkCommandBuffer commandBuffer, const computeBuffer<uint64_t>& keys,
+                     const computeBuffer<uint32_t>* pValues, uint32_t count)
+    {
+        return CmdSort(commandBuffer, keys, pValues, count, 2);
+    }
+    // 以随机数据测量 count 个元素的吞吐量，并与 CPU 上的计算结果比较以验证正确性
+    // 需要计算队列支持时间戳，count 不超过 capacity
+    VkResult Benchmark(primitive_t primitive, uint32_t count, benchmarkResult& benchmarkResult,
+                       uint32_t repeatCount = 10)
+    {
+        if (VkResult result = CheckCount(count)) return result;
+        computeContext& context = *pContext;
+        graphicsBase& base = graphicsBase::Base();
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(base.PhysicalDevice(), &queueFamilyCount,
+                                                 nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilyPropertieses(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(base.PhysicalDevice(), &queueFamilyCount,
+                                                 queueFamilyPropertieses.data());
+        uint32_t timestampValidBits =
+            queueFamilyPropertieses[context.QueueFamilyIndex()].timestampValidBits;
+        if (!timestampValidBits) {
+            std::cout << std::format(
+                "[ parallelPrimitives ] ERROR\nThe compute queue does not support timestamps!\n");
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        uint64_t timestampMask =
+            timestampValidBits == 64 ? UINT64_MAX : (uint64_t(1) << timestampValidBits) - 1;
+        repeatCount = std::max(repeatCount, 1u);
+        // 准备数据，排序时值为键原先的下标，以便验证稳定性
+        std::mt19937 random(count);
+        std::vector<uint32_t> data(count), flags(count);
+        std::vector<uint64_t> keys64(primitive == primitive_sort64 ? count : 0);
+        for (uint32_t i = 0; i < count; i++) {
+            data[i] = primitive == primitive_compact ? i : random();
+            flags[i] = random() & 1;
+            // 高位字取值较少，使存在相等的键
+            if (primitive == primitive_sort64)
+                keys64[i] = uint64_t(random() & 0xffff) << 32 | data[i];
+        }
+        std::vector<uint32_t> indices(count);
+        std::iota(indices.begin(), indices.end(), 0u);
+        uint32_t elementCount = std::max(count, 1u);
+        computeBuffer<uint32_t> source, input, output, flagBuffer, outputCount, sourceValues;
+        computeBuffer<uint64_t> source64, input64;
+        if (VkResult result = input.Create(elementCount)) return result;
+        if (VkResult result = output.Create(elementCount)) return result;
+        switch (primitive) {
+            case primitive_compact:
+                if (VkResult result = flagBuffer.Create(elementCount)) return result;
+                if (VkResult result = outputCount.Create(1)) return result;
+                if (VkResult result = context.Write(flagBuffer, std::span<const uint32_t>(flags)))
+                    return result;
+                [[fallthrough]];
+            case primitive_reduce:
+            case primitive_scan:
+                if (VkResult result = context.Write(input, std::span<const uint32_t>(data)))
+                    return result;
+                break;
+            case primitive_sort32:
+            case primitive_sort64:
+                // 排序是原地的，每次执行前从 source 复制原始数据
+                if (VkResult result = sourceValues.Create(elementCount)) return result;
+                if (VkResult result =
+                        context.Write(sourceValues, std::span<const uint32_t>(indices)))
+                    return result;
+                if (primitive == primitive_sort32) {
+                    if (VkResult result = source.Create(elementCount)) return result;
+                    if (VkResult result = context.Write(source, std::span<const uint32_t>(data)))
+                        return result;
+                } else {
+                    if (VkResult result = source64.Create(elementCount)) return result;
+                    if (VkResult result = input64.Create(elementCount)) return result;
+                    if (VkResult result =
+                            context.Write(source64, std::span<const uint64_t>(keys64)))
+                        return result;
+                }
+                break;
+        }
+        queryPool queries;
+        if (VkResult result = queries.Create(VK_QUERY_TYPE_TIMESTAMP, repeatCount * 2))
+            return result;
+        VkCommandBuffer commandBuffer;
+        if (VkResult result = context.Begin(commandBuffer)) return result;
+        queries.CmdReset(commandBuffer, 0, repeatCount * 2);
+        VkResult result = VK_SUCCESS;
+        for (uint32_t i = 0; i < repeatCount && !result; i++) {
+            if (primitive == primitive_sort32 || primitive == primitive_sort64) {
+                const computeBufferBase& keySource =
+                    primitive == primitive_sort32 ? static_cast<const computeBufferBase&>(source)
+                                                  : source64;
+                const computeBufferBase& keyInput =
+                    primitive == primitive_sort32 ? static_cast<const computeBufferBase&>(input)
+                                                  : input64;
+                VkBufferCopy keyRegion = {0, 0, keySource.Size()};
+                VkBufferCopy valueRegion = {0, 0, sourceValues.Size()};
+                vkCmdCopyBuffer(commandBuffer, keySource, keyInput, 1, &keyRegion);
+                vkCmdCopyBuffer(commandBuffer, sourceValues, output, 1, &valueRegion);
+                computeContext::CmdBarrier(commandBuffer);
+            }
+            // 起始时间戳等到之前的复制和计算全部结束，TOP_OF_PIPE 会把它们也计入耗时
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, queries, i * 2);
+            switch (primitive) {
+                case primitive_reduce:
+                    result = CmdReduce(commandBuffer, input, count, output);
+                    break;
+                case primitive_scan:
+                    result = CmdScan(commandBuffer, input, output, count);
+                    break;
+                case primitive_compact:
+                    result = CmdCompact(commandBuffer, input, flagBuffer, output, count,
+                                        outputCount);
+                    break;
+                case primitive_sort32:
+                    result = CmdSort(commandBuffer, input, &output, count);
+                    break;
+                case primitive_sort64:
+                    result = CmdSort(commandBuffer, input64, &output, count);
+                    break;
+            }
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queries,
+                                i * 2 + 1);
+        }
+        if (result) {
+            context.Abandon(commandBuffer);
+            return result;
+        }
+        uint64_t value;
+        if (VkResult result = context.Submit(commandBuffer, value)) return result;
+        if (VkResult result = context.Wait(value)) return result;
+        std::vector<uint64_t> timestamps(repeatCount * 2);
+        if (VkResult result = queries.GetResults(0, timestamps)) return result;
+        std::vector<double> times(repeatCount);
+        double timestampPeriod = base.PhysicalDeviceProperties().limits.timestampPeriod;
+        for (uint32_t i = 0; i < repeatCount; i++)
+            times[i] = ((timestamps[i * 2 + 1] - timestamps[i * 2]) & timestampMask) *
+                       timestampPeriod / 1e6;
+        std::ranges::nth_element(times, times.begin() + repeatCount / 2);
+        benchmarkResult.time = times[repeatCount / 2];
+        benchmarkResult.throughput =
+            benchmarkResult.time > 0 ? count / benchmarkResult.time / 1e6 : 0;
+        // 在 CPU 上计算期望的结果并比较
+        std::vector<uint32_t> actual(count), actualValues(count);
+        switch (primitive) {
+            case primitive_reduce: {
+                uint32_t sum = 0;
+                if (VkResult result = context.Read(output, std::span<uint32_t>(&sum, 1)))
+                    return result;
+                benchmarkResult.correct = sum == std::accumulate(data.begin(), data.end(), 0u);
+                break;
+            }
+            case primitive_scan:
+                if (VkResult result = context.Read(output, std::span<uint32_t>(actual)))
+                    return result;
+                std::exclusive_scan(data.begin(), data.end(), data.begin(), 0u);
+                benchmarkResult.correct = actual == data;
+                break;
+            case primitive_compact: {
+                uint32_t actualCount = 0;
+                if (VkResult result =
+                        context.Read(outputCount, std::span<uint32_t>(&actualCount, 1)))
+                    return result;
+                std::erase_if(data, [&flags](uint32_t i) { return !flags[i]; });
+                actual.resize(std::min(actualCount, count));
+                if (VkResult result = context.Read(output, std::span<uint32_t>(actual)))
+                    return result;
+                benchmarkResult.correct = actual == data;
+                break;
+            }
+            case primitive_sort32:
+                if (VkResult result = context.Read(input, std::span<uint32_t>(actual)))
+                    return result;
+                if (VkResult result = context.Read(output, std::span<uint32_t>(actualValues)))
+                    return result;
+                std::ranges::stable_sort(indices, {}, [&data](uint32_t i) { return data[i]; });
+                benchmarkResult.correct = actualValues == indices;
+                for (uint32_t i = 0; i < count && benchmarkResult.correct; i++)
+                    benchmarkResult.correct = actual[i] == data[indices[i]];
+                break;
+            case primitive_sort64: {
+                std::vector<uint64_t> actual64(count);
+                if (VkResult result = context.Read(input64, std::span<uint64_t>(actual64)))
+                    return result;
+                if (VkResult result = context.Read(output, std::span<uint32_t>(actualValues)))
+                    return result;
+                std::ranges::stable_sort(indices, {}, [&keys64](uint32_t i) { return keys64[i]; });
+                benchmarkResult.correct = actualValues == indices;
+                for (uint32_t i = 0; i < count && benchmarkResult.correct; i++)
+                    benchmarkResult.correct = actual64[i] == keys64[indices[i]];
+                break;
+            }
+        }
+        return VK_SUCCESS;
+    }
+    // 载入各内核并分配可处理 capacity 个元素（或键值对）的临时缓冲区
+    // directory 为编译好的 SPIR-V 文件所在的目录
+    VkResult Create(computeContext& context, uint32_t capacity, const char* directory = "shader")
+    {
+        pContext = &context;
+        useSubgroup = SubgroupArithmeticSupported();
+        if (VkResult result = LoadKernel(directory, "reduce", true, reduceKernel)) return result;
+        if (VkResult result = LoadKernel(directory, "scan", true, scanKernel)) return result;
+        if (VkResult result = LoadKernel(directory, "compact", true, compactKernel))
+            return result;
+        if (VkResult result = LoadKernel(directory, "radix_histogram", false, histogramKernel))
+            return result;
+        if (VkResult result = LoadKernel(directory, "radix_sweep", true, sweepKernel))
+            return result;
+        capacity = std::max(capacity, 1u);
+        uint32_t tileCount = (capacity + tileSize - 1) / tileSize;
+        // 每块的状态：基数排序 radix 个字，前缀和与流压缩 3 个字
+        if (VkResult result = tileStates.Create(1 + tileCount * radix)) return result;
+        if (VkResult result = histograms.Create(8 * radix)) return result;
+        if (VkResult result = alternateKeys.Create(size_t(capacity) * 2)) return result;
+        if (VkResult result = alternateValues.Create(capacity)) return result;
+        this->capacity = capacity;
+        return VK_SUCCESS;
+    }
+    // Static Function
+    // 设备的计算着色器是否支持子组的 basic 与 arithmetic 运算（Vulkan 1.1）
+    static bool SubgroupArithmeticSupported()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        if (base.DeviceApiVersion() < VK_API_VERSION_1_1) return false;
+        VkPhysicalDeviceSubgroupProperties subgroupProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES};
+        VkPhysicalDeviceProperties2 properties2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &subgroupProperties};
+        vkGetPhysicalDeviceProperties2(base.PhysicalDevice(), &properties2);
+        VkSubgroupFeatureFlags requiredOperations =
+            VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT;
+        return subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT &&
+               (subgroupProperties.supportedOperations & requiredOperations) == requiredOperations;
+    }
+};
+}  // namespace vulkan
@@ -0,0 +1,674 @@
+#pragma once
+#include "VKBase.h"
+
+namespace vulkan {
+// 帧图：先声明各个 pass 及其读写的资源，再由 Compile 统一生成同步与内存安排
+// 1. 按声明顺序追踪每个资源的状态，在 pass 之间插入批量的 synchronization2 屏障及图像布局转换
+// 2. 从输出（导入的外部资源与标记为输出的资源）反向推导，剔除结果不被使用的 pass
+// 3. 生命周期不重叠的临时图像共用同一块设备内存
+// 需开启 synchronization2 特性（Vulkan 1.3）
+class renderGraph {
+public:
+    using resource_t = uint32_t;
+    // 资源在 pass 中的用途，决定了访问的阶段、访问类型和图像布局
+    enum resourceUsage : uint32_t {
+        usage_colorAttachment,         // 颜色附件
+        usage_depthStencilAttachment,  // 可写的深度模板附件
+        usage_depthStencilReadOnly,    // 只读的深度模板附件
+        usage_sampledFragment,         // 在片段着色器中采样
+        usage_sampledCompute,          // 在计算着色器中采样
+        usage_storageImageCompute,     // 计算着色器中的 storage image
+        usage_transferSrc,             // 传输命令的来源
+        usage_transferDst,             // 传输命令的目标
+        usage_uniformBuffer,           // 在顶点、片段、计算着色器中作为 uniform 缓冲区
+        usage_storageBufferCompute,    // 计算着色器中的 storage 缓冲区
+        usage_vertexBuffer,            // 顶点缓冲区
+        usage_indexBuffer,             // 索引缓冲区
+        usage_indirectBuffer,          // 间接绘制/分派的参数缓冲区
+        usage_count
+    };
+    struct usageInfo {
+        VkPipelineStageFlags2 stageMask;
+        VkAccessFlags2 readAccessMask;
+        VkAccessFlags2 writeAccessMask;
+        VkImageLayout layout;          // 对缓冲区无意义
+        VkImageUsageFlags imageUsage;  // 用于推导临时图像的 usage
+    };
+    static constexpr usageInfo usageInfos[usage_count] = {
+        {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT,
+         VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT},
+        {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+         VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+         VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+         VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+         VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT},
+        {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+         VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT, 0,
+         VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+         VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT},
+        {VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, 0,
+         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT},
+        {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, 0,
+         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT},
+        {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+         VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL,
+         VK_IMAGE_USAGE_STORAGE_BIT},
+        {VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, 0,
+         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT},
+        {VK_PIPELINE_STAGE_2_TRANSFER_BIT, 0, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT},
+        {VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT |
+             VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+         VK_ACCESS_2_UNIFORM_READ_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, 0},
+        {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+         VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0},
+        {VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT, 0,
+         VK_IMAGE_LAYOUT_UNDEFINED, 0},
+        {VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT, 0,
+         VK_IMAGE_LAYOUT_UNDEFINED, 0},
+        {VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, 0,
+         VK_IMAGE_LAYOUT_UNDEFINED, 0}};
+    // 临时图像的描述，其 usage 由各 pass 中的用途推导
+    struct transientImageDesc {
+        VkFormat format;
+        VkExtent2D extent = {};       // 为 {0, 0} 时取交换链图像尺寸乘以 swapchainScale
+        float swapchainScale = 1.f;
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+        VkImageUsageFlags extraUsage = 0;
+    };
+    using execute_t = std::function<void(VkCommandBuffer commandBuffer, const renderGraph& graph)>;
+    struct graphStatistics {
+        uint32_t passCount;                     // 已声明的 pass 数
+        uint32_t culledPassCount;               // 被剔除的 pass 数
+        uint32_t barrierCount;                  // 图像与缓冲区屏障总数
+        uint32_t barrierBatchCount;             // vkCmdPipelineBarrier2 的调用次数
+        VkDeviceSize transientMemorySize;       // 临时图像实际占用的内存
+        VkDeviceSize transientMemorySize_noAliasing;  // 若不共用内存所需的内存
+    };
+    // 用于声明 pass 对资源的读写
+    class passBuilder {
+        renderGraph& graph;
+        uint32_t passIndex;
+
+    public:
+        passBuilder(renderGraph& graph, uint32_t passIndex) : graph(graph), passIndex(passIndex) {}
+        // 只读取，如采样、作为顶点缓冲区
+        passBuilder& Read(resource_t resource, resourceUsage usage)
+        {
+            graph.passes[passIndex].accesses.push_back({resource, usage, true, false});
+            return *this;
+        }
+        // 只写入且不关心原有内容，如附件的 loadOp 为 CLEAR 或 DONT_CARE
+        passBuilder& Write(resource_t resource, resourceUsage usage)
+        {
+            graph.passes[passIndex].accesses.push_back({resource, usage, false, true});
+            return *this;
+        }
+        // 读取并写入，如附件的 loadOp 为 LOAD、混合
+        passBuilder& ReadWrite(resource_t resource, resourceUsage usage)
+        {
+            graph.passes[passIndex].accesses.push_back({resource, usage, true, true});
+            return *this;
+        }
+        // 有图外可见的副作用（如回读到 CPU）的 pass 不会被剔除
+        passBuilder& SideEffect()
+        {
+            graph.passes[passIndex].hasSideEffect = true;
+            return *this;
+        }
+    };
+
+private:
+    struct access {
+        resource_t resource;
+        resourceUsage usage;
+        bool read;
+        bool write;
+    };
+    struct barrier {
+        resource_t resource;
+        VkPipelineStageFlags2 srcStageMask;
+        VkAccessFlags2 srcAccessMask;
+        VkPipelineStageFlags2 dstStageMask;
+        VkAccessFlags2 dstAccessMask;
+        VkImageLayout oldLayout;
+        VkImageLayout newLayout;
+    };
+    struct pass {
+        std::string name;
+        execute_t execute;
+        std::vector<access> accesses;
+        bool hasSideEffect = false;
+        bool culled = false;
+        uint32_t barrierBegin = 0, barrierEnd = 0;  // 该 pass 前的屏障在 barriers 中的范围
+    };
+    struct resourceInfo {
+        bool isImage;
+        bool imported;
+        bool isOutput;
+        // 图像
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent = {};
+        VkImageAspectFlags aspectMask = 0;
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags2 initialStageMask = VK_PIPELINE_STAGE_2_NONE;
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        transientImageDesc desc = {};
+        // 缓冲区
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = VK_WHOLE_SIZE;
+        // 由 Compile 得出
+        uint32_t firstPass = UINT32_MAX, lastPass = 0;  // 生命周期，即首末两个使用它的 pass
+        uint32_t transientIndex = UINT32_MAX;           // 在 transientImages 中的索引
+        std::vector<resource_t> aliasPredecessors;  // 此前占用同一段内存的临时图像
+    };
+    // 资源在图中逐个 pass 推进的状态
+    struct resourceState {
+        VkImageLayout layout;
+        VkPipelineStageFlags2 writeStageMask;  // 上次写入（或布局转换）所在的阶段
+        VkAccessFlags2 writeAccessMask;        // 上次写入的访问类型
+        VkPipelineStageFlags2 readStageMask;   // 上次写入后读取过的阶段
+        VkPipelineStageFlags2 visibleStageMask;  // 上次写入已对其可见的阶段
+        VkAccessFlags2 visibleAccessMask;        // 上次写入已对其可见的访问类型
+    };
+    std::vector<pass> passes;
+    std::vector<resourceInfo> resources;
+    std::vector<barrier> barriers;
+    uint32_t finalBarrierBegin = 0;  // 末尾的布局转换在 barriers 中的起始位置
+    std::vector<image> transientImages;
+    std::vector<imageView> transientImageViews;
+    std::vector<deviceMemory> memoryBlocks;
+    graphStatistics statistics = {};
+    bool compiled = false;
+
+    // Static Function
+    static VkImageAspectFlags FormatAspect(VkFormat format)
+    {
+        switch (format) {
+            case VK_FORMAT_D16_UNORM:
+            case VK_FORMAT_X8_D24_UNORM_PACK32:
+            case VK_FORMAT_D32_SFLOAT:
+                return VK_IMAGE_ASPECT_DEPTH_BIT;
+            case VK_FORMAT_S8_UINT:
+                return VK_IMAGE_ASPECT_STENCIL_BIT;
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+            default:
+                return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+    }
+    // Non-const Function
+    // 反向遍历：一个 pass 写入了仍被需要的资源，或有副作用，才会被保留
+    void CullPasses()
+    {
+        std::vector<uint8_t> needed(resources.size());
+        for (size_t i = 0; i < resources.size(); i++)
+            needed[i] = resources[i].imported || resources[i].isOutput;
+        for (size_t i = passes.size(); i--;) {
+            pass& pass = passes[i];
+            pass.culled = !pass.hasSideEffect;
+            for (auto& j : pass.accesses)
+                if (j.write && needed[j.resource]) pass.culled = false;
+            if (pass.culled) continue;
+            // 只写不读的资源，其更早的内容不再被需要
+            for (auto& j : pass.accesses)
+                if (j.write && !j.read) needed[j.resource] = false;
+            for (auto& j : pass.accesses)
+                if (j.read) needed[j.resource] = true;
+        }
+        // 外部资源在图之外仍可能被使用
+        for (auto& i : resources)
+            if (i.imported) i.isOutput = true;
+    }
+    VkResult CreateTransientImages()
+    {
+        struct placement {
+            resource_t resource;
+            VkMemoryRequirements memoryRequirements;
+            uint32_t memoryTypeIndex;
+            VkDeviceSize offset;
+        };
+        std::vector<placement> placements;
+        for (resource_t i = 0; i < resources.size(); i++) {
+            resourceInfo& resource = resources[i];
+            resource.aliasPredecessors.clear();
+            if (!resource.isImage || resource.imported || resource.firstPass == UINT32_MAX)
+                continue;
+            VkImageUsageFlags usage = resource.desc.extraUsage;
+            for (auto& j : passes)
+                if (!j.culled)
+                    for (auto& k : j.accesses)
+                        if (k.resource == i) usage |= usageInfos[k.usage].imageUsage;
+            VkExtent2D extent = resource.desc.extent;
+            if (!extent.width || !extent.height) {
+                VkExtent2D swapchainExtent = graphicsBase::Base().SwapchainCreateInfo().imageExtent;
+                float scale = resource.desc.swapchainScale;
+                extent = {std::max(uint32_t(swapchainExtent.width * scale), 1u),
+                          std::max(uint32_t(swapchainExtent.height * scale), 1u)};
+            }
+            resource.extent = extent;
+            VkImageCreateInfo imageCreateInfo = {.imageType = VK_IMAGE_TYPE_2D,
+                                                 .format = resource.format,
+                                                 .extent = {extent.width, extent.height, 1},
+                                                 .mipLevels = 1,
+                                                 .arrayLayers = 1,
+                                                 .samples = resource.desc.samples,
+                                                 .tiling = VK_IMAGE_TILING_OPTIMAL,
+                                                 .usage = usage};
+            resource.transientIndex = uint32_t(transientImages.size());
+            if (VkResult result = transientImages.emplace_back().Create(imageCreateInfo))
+                return result;
+            VkMemoryRequirements memoryRequirements = transientImages.back().MemoryRequirements();
+            uint32_t memoryTypeIndex = graphicsBase::Base().MemoryTypeIndex(
+                memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            if (memoryTypeIndex == UINT32_MAX) {
+                std::cout << std::format(
+                    "[ renderGraph ] ERROR\nFailed to find a memory type for a transient image!\n");
+                return VK_RESULT_MAX_ENUM;
+            }
+            placements.push_back({i, memoryRequirements, memoryTypeIndex, 0});
+            statistics.transientMemorySize_noAliasing += memoryRequirements.size;
+        }
+        // 从大到小依次放置，每个图像放在不与任何生命周期重叠的已放置图像冲突的最低偏移处
+        std::ranges::sort(placements, [](const placement& a, const placement& b) {
+            return a.memoryRequirements.size > b.memoryRequirements.size;
+        });
+        std::map<uint32_t, VkDeviceSize> blockSizes;  // 每种内存类型一块内存
+        for (size_t i = 0; i < placements.size(); i++) {
+            placement& current = placements[i];
+            const resourceInfo& a = resources[current.resource];
+            VkDeviceSize alignment = current.memoryRequirements.alignment;
+            std::vector<std::pair<VkDeviceSize, VkDeviceSize>> occupied;  // 冲突的内存区间
+            for (size_t j = 0; j < i; j++) {
+                const placement& placed = placements[j];
+                const resourceInfo& b = resources[placed.resource];
+                if (placed.memoryTypeIndex != current.memoryTypeIndex ||
+                    a.lastPass < b.firstPass || b.lastPass < a.firstPass)
+                    continue;
+                occupied.emplace_back(placed.offset,
+                                      placed.offset + placed.memoryRequirements.size);
+            }
+            std::ranges::sort(occupied);
+            VkDeviceSize offset = 0;
+            for (auto& [begin, end] : occupied)
+                if (offset + current.memoryRequirements.size > begin)
+                    offset = std::max(offset, (end + alignment - 1) / alignment * alignment);
+            current.offset = offset;
+            VkDeviceSize& blockSize = blockSizes[current.memoryTypeIndex];
+            blockSize = std::max(blockSize, offset + current.memoryRequirements.size);
+        }
+        std::map<uint32_t, VkDeviceMemory> blocks;
+        for (auto& [memoryTypeIndex, size] : blockSizes) {
+            VkMemoryAllocateInfo allocateInfo = {.allocationSize = size,
+                                                 .memoryTypeIndex = memoryTypeIndex};
+            if (VkResult result = memoryBlocks.emplace_back().Allocate(allocateInfo)) return result;
+            blocks[memoryTypeIndex] = memoryBlocks.back();
+            statistics.transientMemorySize += size;
+        }
+        for (auto& i : placements) {
+            resourceInfo& resource = resources[i.resource];
+            if (VkResult result = transientImages[resource.transientIndex].BindMemory(
+                    blocks[i.memoryTypeIndex], i.offset))
+                return result;
+            // 记录此前占用过重叠内存的图像，首次使用时需等待它们的访问结束
+            for (auto& j : placements)
+                if (j.memoryTypeIndex == i.memoryTypeIndex &&
+                    resources[j.resource].lastPass < resource.firstPass &&
+                    j.offset < i.offset + i.memoryRequirements.size &&
+                    i.offset < j.offset + j.memoryRequirements.size)
+                    resource.aliasPredecessors.push_back(j.resource);
+        }
+        transientImageViews.resize(transientImages.size());
+        for (auto& i : resources)
+            if (i.transientIndex != UINT32_MAX) {
+                i.image = transientImages[i.transientIndex];
+                if (VkResult result = transientImageViews[i.transientIndex].Create(
+                        i.image, VK_IMAGE_VIEW_TYPE_2D, i.format, {i.aspectMask, 0, 1, 0, 1}))
+                    return result;
+                i.view = transientImageViews[i.transientIndex];
+            }
+        return VK_SUCCESS;
+    }
+    std::vector<resourceState> InitialStates() const
+    {
+        std::vector<resourceState> states(resources.size());
+        for (size_t i = 0; i < resources.size(); i++)
+            states[i] = {.layout = resources[i].imported ? resources[i].initialLayout
+                                                         : VK_IMAGE_LAYOUT_UNDEFINED,
+                         .writeStageMask = resources[i].initialStageMask};
+        return states;
+    }
+    void GenerateBarriers()
+    {
+        // 图每帧重复执行，临时图像在上一次执行中的访问与本次首次使用之间同样需要同步，
+        // 先推演一遍得出各资源在图末尾的状态
+        std::vector<resourceState> lastStates = InitialStates();
+        GeneratePassBarriers(lastStates);
+        // 临时图像首次使用时，等待上一次执行中对其自身及与其共用内存的图像的访问结束
+        std::vector<resourceState> states = InitialStates();
+        auto Seed = [](resourceState& state, const resourceState& last) {
+            state.writeStageMask |= last.writeStageMask | last.readStageMask;
+            state.writeAccessMask |= last.writeAccessMask;
+        };
+        for (resource_t i = 0; i < resources.size(); i++) {
+            if (resources[i].transientIndex == UINT32_MAX) continue;
+            Seed(states[i], lastStates[i]);
+            for (resource_t j = 0; j < resources.size(); j++)
+                if (std::ranges::find(resources[j].aliasPredecessors, i) !=
+                    resources[j].aliasPredecessors.end())
+                    Seed(states[i], lastStates[j]);
+        }
+        GeneratePassBarriers(states);
+        // 外部图像在图的末尾转换到其最终布局，如 VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+        finalBarrierBegin = uint32_t(barriers.size());
+        for (resource_t i = 0; i < resources.size(); i++) {
+            const resourceInfo& resource = resources[i];
+            if (!resource.isImage || !resource.imported || resource.firstPass == UINT32_MAX ||
+                resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+                resource.finalLayout == states[i].layout)
+                continue;
+            barriers.push_back({i, states[i].writeStageMask | states[i].readStageMask,
+                                states[i].writeAccessMask, VK_PIPELINE_STAGE_2_NONE, 0,
+                                states[i].layout, resource.finalLayout});
+        }
+        statistics.barrierCount = uint32_t(barriers.size());
+    }
+    // 从 states 出发逐个 pass 推进资源状态，重新生成各 pass 前的屏障
+    void GeneratePassBarriers(std::vector<resourceState>& states)
+    {
+        barriers.clear();
+        for (uint32_t i = 0; i < passes.size(); i++) {
+            pass& pass = passes[i];
+            pass.barrierBegin = uint32_t(barriers.size());
+            if (pass.culled) {
+                pass.barrierEnd = pass.barrierBegin;
+                continue;
+            }
+            // 同一 pass 中对同一资源的多次访问合并为一次
+            struct mergedAccess {
+                VkImageLayout layout;
+                bool read, write;
+                VkPipelineStageFlags2 stageMask;
+                VkAccessFlags2 readAccessMask, writeAccessMask;
+            };
+            std::map<resource_t, mergedAccess> mergedAccesses;
+            for (auto& j : pass.accesses) {
+                const usageInfo& info = usageInfos[j.usage];
+                auto [it, inserted] = mergedAccesses.try_emplace(
+                    j.resource, mergedAccess{.layout = info.layout});
+                mergedAccess& merged = it->second;
+                // 布局以写入时的用途为准
+                if (j.write) merged.layout = info.layout;
+                merged.read |= j.read;
+                merged.write |= j.write;
+                merged.stageMask |= info.stageMask;
+                if (j.read) merged.readAccessMask |= info.readAccessMask;
+                if (j.write) merged.writeAccessMask |= info.writeAccessMask;
+            }
+            for (auto& [resourceIndex, a] : mergedAccesses) {
+                const resourceInfo& resource = resources[resourceIndex];
+                resourceState& state = states[resourceIndex];
+                VkImageLayout layout = resource.isImage ? a.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+                VkAccessFlags2 accessMask = a.readAccessMask | a.writeAccessMask;
+                // 临时图像首次使用时，等待此前占用同一段内存的图像的访问结束
+                if (resource.firstPass == i)
+                    for (auto j : resource.aliasPredecessors) {
+                        state.writeStageMask |=
+                            states[j].writeStageMask | states[j].readStageMask;
+                        state.writeAccessMask |= states[j].writeAccessMask;
+                    }
+                bool layoutTransition = resource.isImage && state.layout != layout;
+                if (a.write || layoutTransition) {
+                    // 写入前需等待此前的读写全部完成，布局转换也视为写入
+                    VkPipelineStageFlags2 srcStageMask =
+                        state.writeStageMask | state.readStageMask;
+                    if (srcStageMask || layoutTransition)
+                        barriers.push_back({resourceIndex, srcStageMask, state.writeAccessMask,
+                                            a.stageMask, accessMask,
+                                            // 只写不读时不需要保留原有内容
+                                            a.read ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED,
+                                            layout});
+                    // 仅有布局转换时，之后的读取以本次访问的阶段为执行依赖的起点
+                    state = {.layout = layout,
+                             .writeStageMask = a.stageMask,
+                             .writeAccessMask = a.writeAccessMask,
+                             .readStageMask = a.write ? 0 : a.stageMask,
+                             .visibleStageMask = a.stageMask,
+                             .visibleAccessMask = accessMask};
+                } else {
+                    // 读后读无需屏障，只在上次写入尚未对本次读取可见时插入屏障
+                    if (state.writeStageMask && ((a.stageMask & ~state.visibleStageMask) ||
+                                                 (accessMask & ~state.visibleAccessMask))) {
+                        barriers.push_back({resourceIndex, state.writeStageMask,
+                                            state.writeAccessMask, a.stageMask, accessMask,
+                                            layout, layout});
+                        state.visibleStageMask |= a.stageMask;
+                        state.visibleAccessMask |= accessMask;
+                    }
+                    state.readStageMask |= a.stageMask;
+                }
+            }
+            pass.barrierEnd = uint32_t(barriers.size());
+        }
+    }
+    void RecordBarriers(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end) const
+    {
+        if (begin == end) return;
+        std::vector<VkImageMemoryBarrier2> imageBarriers;
+        std::vector<VkBufferMemoryBarrier2> bufferBarriers;
+        for (uint32_t i = begin; i < end; i++) {
+            const barrier& b = barriers[i];
+            const resourceInfo& resource = resources[b.resource];
+            if (resource.isImage)
+                imageBarriers.push_back({.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                                         .srcStageMask = b.srcStageMask,
+                                         .srcAccessMask = b.srcAccessMask,
+                                         .dstStageMask = b.dstStageMask,
+                                         .dstAccessMask = b.dstAccessMask,
+                                         .oldLayout = b.oldLayout,
+                                         .newLayout = b.newLayout,
+                                         .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                         .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                         .image = resource.image,
+                                         .subresourceRange = {resource.aspectMask, 0,
+                                                              VK_REMAINING_MIP_LEVELS, 0,
+                                                              VK_REMAINING_ARRAY_LAYERS}});
+            else
+                bufferBarriers.push_back({.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                                          .srcStageMask = b.srcStageMask,
+                                          .srcAccessMask = b.srcAccessMask,
+                                          .dstStageMask = b.dstStageMask,
+                                          .dstAccessMask = b.dstAccessMask,
+                                          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                          .buffer = resource.buffer,
+                                          .offset = resource.offset,
+                                          .size = resource.size});
+        }
+        VkDependencyInfo dependencyInfo = {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .bufferMemoryBarrierCount = uint32_t(bufferBarriers.size()),
+            .pBufferMemoryBarriers = bufferBarriers.data(),
+            .imageMemoryBarrierCount = uint32_t(imageBarriers.size()),
+            .pImageMemoryBarriers = imageBarriers.data()};
+        vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+    }
+
+public:
+    renderGraph() = default;
+    renderGraph(renderGraph&&) = default;
+    // Getter
+    VkImage Image(resource_t resource) const
+    {
+        return resources[resource].image;
+    }
+    VkImageView ImageView(resource_t resource) const
+    {
+        return resources[resource].view;
+    }
+    VkFormat Format(resource_t resource) const
+    {
+        return resources[resource].format;
+    }
+    VkExtent2D Extent(resource_t resource) const
+    {
+        return resources[resource].extent;
+    }
+    VkBuffer Buffer(resource_t resource) const
+    {
+        return resources[resource].buffer;
+    }
+    bool IsCulled(uint32_t passIndex) const
+    {
+        return passes[passIndex].culled;
+    }
+    const graphStatistics& Statistics() const
+    {
+        return statistics;
+    }
+    // Non-const Function
+    // 导入外部图像，如交换链图像，每帧可通过 SetImportedImage 更换句柄
+    // initialStageMask 为进入本图前最后访问该图像的阶段
+    // 对交换链图像，应与等待获取图像的信号量时所指定的阶段一致
+    // finalLayout 不为 VK_IMAGE_LAYOUT_UNDEFINED 时，在图的末尾转换到该布局
+    resource_t ImportImage(VkImage image, VkImageView view, VkFormat format, VkExtent2D extent,
+                           VkImageLayout initialLayout, VkImageLayout finalLayout,
+                           VkPipelineStageFlags2 initialStageMask =
+                               VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT)
+    {
+        resources.push_back({.isImage = true,
+                             .imported = true,
+                             .isOutput = true,
+                             .image = image,
+                             .view = view,
+                             .format = format,
+                             .extent = extent,
+                             .aspectMask = FormatAspect(format),
+                             .initialLayout = initialLayout,
+                             .initialStageMask = initialStageMask,
+                             .finalLayout = finalLayout});
+        compiled = false;
+        return resource_t(resources.size() - 1);
+    }
+    void SetImportedImage(resource_t resource, VkImage image, VkImageView view)
+    {
+        resources[resource].image = image;
+        resources[resource].view = view;
+    }
+    // 导入外部缓冲区，initialStageMask 为进入本图前最后访问该缓冲区的阶段
+    resource_t ImportBuffer(VkBuffer buffer, VkDeviceSize offset = 0,
+                            VkDeviceSize size = VK_WHOLE_SIZE,
+                            VkPipelineStageFlags2 initialStageMask = VK_PIPELINE_STAGE_2_NONE)
+    {
+        resources.push_back({.isImage = false,
+                             .imported = true,
+                             .isOutput = true,
+                             .initialStageMask = initialStageMask,
+                             .buffer = buffer,
+                             .offset = offset,
+                             .size = size});
+        compiled = false;
+        return resource_t(resources.size() - 1);
+    }
+    void SetImportedBuffer(resource_t resource, VkBuffer buffer)
+    {
+        resources[resource].buffer = buffer;
+    }
+    // 创建由图管理的临时图像，其内存会与生命周期不重叠的其他临时图像共用
+    resource_t CreateTransientImage(const transientImageDesc& desc)
+    {
+        resources.push_back({.isImage = true,
+                             .imported = false,
+                             .isOutput = false,
+                             .format = desc.format,
+                             .aspectMask = FormatAspect(desc.format),
+                             .desc = desc});
+        compiled = false;
+        return resource_t(resources.size() - 1);
+    }
+    // 使临时资源的内容在图执行完后仍被需要，写入它的 pass 不会被剔除
+    void MarkOutput(resource_t resource)
+    {
+        resources[resource].isOutput = true;
+        compiled = false;
+    }
+    // 添加一个 pass，passes 按添加的顺序执行
+    passBuilder AddPass(std::string name, execute_t execute)
+    {
+        passes.push_back({.name = std::move(name), .execute = std::move(execute)});
+        compiled = false;
+        return {*this, uint32_t(passes.size() - 1)};
+    }
+    // 剔除 pass、创建临时图像并分配内存、生成屏障
+    // 会销毁此前创建的临时图像，调用前需确保上次执行的命令已完成，交换链尺寸改变后需重新调用
+    VkResult Compile()
+    {
+        if (!graphicsBase::Base().PhysicalDeviceVulkan13Features().synchronization2) {
+            std::cout << std::format(
+                "[ renderGraph ] ERROR\nSynchronization2 is not supported!\n");
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        transientImageViews.clear();
+        transientImages.clear();
+        memoryBlocks.clear();
+        statistics = {.passCount = uint32_t(passes.size())};
+        compiled = false;
+
+        CullPasses();
+        for (auto& i : resources) {
+            i.firstPass = UINT32_MAX, i.lastPass = 0, i.transientIndex = UINT32_MAX;
+            if (!i.imported) i.image = VK_NULL_HANDLE, i.view = VK_NULL_HANDLE;
+        }
+        for (uint32_t i = 0; i < passes.size(); i++) {
+            if (passes[i].culled) {
+                statistics.culledPassCount++;
+                continue;
+            }
+            for (auto& j : passes[i].accesses) {
+                resources[j.resource].firstPass = std::min(resources[j.resource].firstPass, i);
+                resources[j.resource].lastPass = std::max(resources[j.resource].lastPass, i);
+            }
+        }
+        if (VkResult result = CreateTransientImages()) return result;
+        GenerateBarriers();
+        for (auto& i : passes)
+            statistics.barrierBatchCount += !i.culled && i.barrierBegin != i.barrierEnd;
+        statistics.barrierBatchCount += finalBarrierBegin != barriers.size();
+        compiled = true;
+        return VK_SUCCESS;
+    }
+    // 将未被剔除的 pass 连同其前的屏障录制到 commandBuffer
+    VkResult Execute(VkCommandBuffer commandBuffer) const
+    {
+        if (!compiled) {
+            std::cout << std::format("[ renderGraph ] ERROR\nThe graph is not compiled!\n");
+            return VK_RESULT_MAX_ENUM;
+        }
+        for (auto& i : passes) {
+            if (i.culled) continue;
+            RecordBarriers(commandBuffer, i.barrierBegin, i.barrierEnd);
+            i.execute(commandBuffer, *this);
+        }
+        RecordBarriers(commandBuffer, finalBarrierBegin, uint32_t(barriers.size()));
+        return VK_SUCCESS;
+    }
+    // 清空所有 pass 与资源，调用前需确保上次执行的命令已完成
+    void Clear()
+    {
+        passes.clear();
+        resources.clear();
+        barriers.clear();
+        transientImageViews.clear();
+        transientImages.clear();
+        memoryBlocks.clear();
+        statistics = {};
+        compiled = false;
+    }
+};
+}  // namespace vulkan
@@ -0,0 +1,178 @@
+#pragma once
+#include "VKBase.h"
+
+namespace vulkan {
+// 用于每次绘制的临时常量的环形缓冲区，每个飞行中的帧占一个区域
+// 1. 在整个生命周期内保持映射，分配只是在当前帧的区域中移动偏移量，
+//    多个录制线程可同时分配（原子操作，无需加锁）
+// 2. 分配所得的偏移量按 minUniformBufferOffsetAlignment 或 minStorageBufferOffsetAlignment 对齐，
+//    可直接用作 VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC 等动态描述符的动态偏移量
+// 3. 非 host coherent 的内存在 Flush 中一次性刷新本帧写入的范围，范围按 nonCoherentAtomSize 对齐
+class frameRingBuffer {
+public:
+    struct allocation {
+        void* pData;          // 映射的地址，写入数据用
+        VkDeviceSize offset;  // 在缓冲区中的偏移量，即动态偏移量
+        VkDeviceSize size;
+        operator bool() const
+        {
+            return pData;
+        }
+    };
+
+private:
+    buffer ringBuffer;
+    deviceMemory ringBufferMemory;
+    uint8_t* pMappedData = nullptr;
+    uint32_t frameCount = 0;
+    uint32_t currentFrameIndex = 0;
+    VkDeviceSize regionSize = 0;             // 每帧的区域的大小
+    std::atomic<VkDeviceSize> usedSize = 0;  // 当前帧的区域中已分配的大小
+    VkDeviceSize flushedSize = 0;            // 当前帧的区域中已刷新的大小
+    VkDeviceSize peakUsedSize = 0;           // 各帧中用量的最大值，用于调整 regionSize
+
+public:
+    frameRingBuffer() = default;
+    frameRingBuffer(frameRingBuffer&&) = delete;
+    ~frameRingBuffer()
+    {
+        Destroy();
+    }
+    // Getter
+    VkBuffer Buffer() const
+    {
+        return ringBuffer;
+    }
+    VkDeviceSize RegionSize() const
+    {
+        return regionSize;
+    }
+    VkDeviceSize UsedSize() const
+    {
+        return usedSize;
+    }
+    VkDeviceSize PeakUsedSize() const
+    {
+        return std::max(peakUsedSize, VkDeviceSize(usedSize));
+    }
+    // Non-const Function
+    // usage 中可额外加入如 VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT 等用途
+    VkResult Create(uint32_t frameCount, VkDeviceSize sizePerFrame,
+                    VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                                               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+    {
+        Destroy();
+        graphicsBase& base = graphicsBase::Base();
+        const VkPhysicalDeviceLimits& limits = base.PhysicalDeviceProperties().limits;
+        // 区域的起始按所有对齐要求中最大者对齐，使各帧的区域相互独立
+        VkDeviceSize alignment = std::max({limits.minUniformBufferOffsetAlignment,
+                                           limits.minStorageBufferOffsetAlignment,
+                                           limits.nonCoherentAtomSize});
+        regionSize = (sizePerFrame + alignment - 1) / alignment * alignment;
+        this->frameCount = frameCount;
+        VkBufferCreateInfo bufferCreateInfo = {.size = regionSize * frameCount, .usage = usage};
+        if (VkResult result = ringBuffer.Create(bufferCreateInfo)) return result;
+        VkMemoryRequirements memoryRequirements = ringBuffer.MemoryRequirements();
+        // 优先使用设备本地且主机可见的内存，GPU 读取时无需经过 PCIe
+        uint32_t memoryTypeIndex = base.MemoryTypeIndex(
+            memoryRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        if (memoryTypeIndex == UINT32_MAX)
+            memoryTypeIndex = base.MemoryTypeIndex(memoryRequirements.memoryTypeBits,
+                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        VkMemoryAllocateFlagsInfo allocateFlagsInfo = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+            .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT};
+        VkMemoryAllocateInfo allocateInfo = {
+            .pNext = usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT ? &allocateFlagsInfo
+                                                                      : nullptr,
+            .allocationSize = memoryRequirements.size,
+            .memoryTypeIndex = memoryTypeIndex};
+        if (VkResult result = ringBufferMemory.Allocate(allocateInfo)) return result;
+        if (VkResult result = ringBuffer.BindMemory(ringBufferMemory)) return result;
+        void* pData;
+        if (VkResult result = ringBufferMemory.MapMemory(pData, allocateInfo.allocationSize))
+            return result;
+        pMappedData = static_cast<uint8_t*>(pData);
+        return VK_SUCCESS;
+    }
+    // 切换到第 frameIndex 帧的区域，调用前需确保该帧上一轮提交的命令已执行完毕
+    void BeginFrame(uint32_t frameIndex)
+    {
+        peakUsedSize = std::max(peakUsedSize, VkDeviceSize(usedSize));
+        currentFrameIndex = frameIndex;
+        usedSize = 0;
+        flushedSize = 0;
+    }
+    // 在当前帧的区域中分配，区域已满时返回的 allocation 为空
+    allocation Allocate(VkDeviceSize size, VkDeviceSize alignment)
+    {
+        VkDeviceSize offset = usedSize.load(std::memory_order_relaxed);
+        VkDeviceSize alignedOffset;
+        do {
+            alignedOffset = (offset + alignment - 1) / alignment * alignment;
+            if (alignedOffset + size > regionSize) {
+                std::cout << std::format(
+                    "[ frameRingBuffer ] ERROR\nRun out of space for this frame!\nRegion size: "
+                    "{}\n",
+                    regionSize);
+                return {};
+            }
+        } while (!usedSize.compare_exchange_weak(offset, alignedOffset + size,
+                                                 std::memory_order_relaxed));
+        VkDeviceSize bufferOffset = currentFrameIndex * regionSize + alignedOffset;
+        return {pMappedData + bufferOffset, bufferOffset, size};
+    }
+    allocation AllocateUniform(VkDeviceSize size)
+    {
+        return Allocate(size, graphicsBase::Base()
+                                  .PhysicalDeviceProperties()
+                                  .limits.minUniformBufferOffsetAlignment);
+    }
+    allocation AllocateStorage(VkDeviceSize size)
+    {
+        return Allocate(size, graphicsBase::Base()
+                                  .PhysicalDeviceProperties()
+                                  .limits.minStorageBufferOffsetAlignment);
+    }
+    // 分配并复制 data，返回动态偏移量，失败时返回 UINT32_MAX
+    template <typename T>
+    uint32_t PushUniform(const T& data)
+    {
+        allocation allocation = AllocateUniform(sizeof data);
+        if (!allocation) return UINT32_MAX;
+        memcpy(allocation.pData, &data, sizeof data);
+        return uint32_t(allocation.offset);
+    }
+    template <typename T>
+    uint32_t PushStorage(const T& data)
+    {
+        allocation allocation = AllocateStorage(sizeof data);
+        if (!allocation) return UINT32_MAX;
+        memcpy(allocation.pData, &data, sizeof data);
+        return uint32_t(allocation.offset);
+    }
+    // 刷新自上次 Flush 以来当前帧写入的范围，在提交前（所有录制线程完成写入后）调用
+    // host coherent 的内存无需刷新
+    VkResult Flush()
+    {
+        VkDeviceSize used = usedSize;
+        if (used == flushedSize) return VK_SUCCESS;
+        VkResult result = ringBufferMemory.FlushMemory(
+            used - flushedSize, currentFrameIndex * regionSize + flushedSize);
+        flushedSize = used;
+        return result;
+    }
+    // 销毁缓冲区与内存，调用前需确保设备不再使用它们
+    void Destroy()
+    {
+        if (pMappedData) vkUnmapMemory(graphicsBase::Base().Device(), ringBufferMemory);
+        pMappedData = nullptr;
+        // 移出到临时对象，由其析构函数销毁
+        buffer(std::move(ringBuffer));
+        deviceMemory(std::move(ringBufferMemory));
+        frameCount = currentFrameIndex = 0;
+        regionSize = usedSize = flushedSize = peakUsedSize = 0;
+    }
+};
+}  // namespace vulkan
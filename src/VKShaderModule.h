@@ -0,0 +1,250 @@
+#pragma once
+#include "VKShaderReflection.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vulkan {
+// 着色器模块登记处：按内容的哈希值登记 SPIR-V 文件，内容相同的文件共用一份代码与一个 VkShaderModule
+// 1. Load 映射文件而不复制到 vector，哈希与反射直接读取映射的页面（Windows 上退回读取文件）
+// 2. 设备支持 maintenance5 时不创建 VkShaderModule，StageCreateInfo 将 VkShaderModuleCreateInfo
+//    链接到着色器阶段的 pNext，由驱动在创建管线时直接读取 SPIR-V
+// 3. 引用计数：每次 Load 加一，用到该模块的管线全部创建后各调用一次 Release，
+//    归零时销毁 VkShaderModule 并解除映射
+// 可在多个线程上调用，例如在 pipelineService 的工作线程上创建管线后 Release
+class shaderModuleRegistry {
+public:
+    using handle_t = uint64_t;  // 即代码的哈希值
+    struct registryStatistics {
+        uint64_t loadCount;
+        uint64_t sharedCount;  // Load 时内容与已登记的模块相同的次数
+        uint64_t moduleCount;  // 创建的 VkShaderModule 的个数
+        uint64_t inlineCount;  // 以 maintenance5 内联 SPIR-V 的次数
+    };
+
+private:
+    struct entry {
+        std::span<const uint32_t> code;
+        void* pMappedFile = nullptr;  // 为空时代码存放于 readCode
+        size_t mappedSize = 0;
+        std::vector<uint32_t> readCode;
+        VkShaderModule module = VK_NULL_HANDLE;
+        uint32_t referenceCount = 0;
+    };
+    bool useInlineCode = false;
+    VkPhysicalDeviceMaintenance5FeaturesKHR maintenance5Features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_5_FEATURES_KHR};
+    mutable std::mutex mutex;
+    std::unordered_map<handle_t, entry> entries;
+    std::unordered_map<std::string, handle_t> filepaths;  // 已登记的文件路径
+    registryStatistics statistics = {};
+
+    //--------------------
+    shaderModuleRegistry()
+    {
+        graphicsBase::Base().AddCallback_DestroyDevice([] { Base().Clear(); });
+    }
+    shaderModuleRegistry(shaderModuleRegistry&&) = delete;
+    // Static Function
+    // 映射或读取文件，结果存入 item
+    static VkResult MapFile(const char* filepath, entry& item)
+    {
+        size_t fileSize = 0;
+#ifndef _WIN32
+        int fd = open(filepath, O_RDONLY);
+        struct stat fileStat;
+        if (fd >= 0 && !fstat(fd, &fileStat)) fileSize = size_t(fileStat.st_size);
+        if (fileSize && fileSize % 4 == 0) {
+            void* pFile = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (pFile != MAP_FAILED) {
+                item.pMappedFile = pFile;
+                item.mappedSize = fileSize;
+                item.code = {static_cast<const uint32_t*>(pFile), fileSize / 4};
+            }
+        }
+        if (fd >= 0) close(fd);
+#else
+        std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+        if (file) fileSize = size_t(file.tellg());
+        if (fileSize && fileSize % 4 == 0) {
+            item.readCode.resize(fileSize / 4);
+            file.seekg(0);
+            if (file.read(reinterpret_cast<char*>(item.readCode.data()),
+                          std::streamsize(fileSize)))
+                item.code = item.readCode;
+        }
+#endif
+        if (item.code.empty()) {
+            std::cout << std::format(
+                "[ shaderModuleRegistry ] ERROR\nFailed to load the SPIR-V file: {}\n", filepath);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        return VK_SUCCESS;
+    }
+    static void UnmapFile(entry& item)
+    {
+#ifndef _WIN32
+        if (item.pMappedFile) munmap(item.pMappedFile, item.mappedSize);
+#endif
+        item.pMappedFile = nullptr;
+        item.code = {};
+        item.readCode.clear();
+    }
+    static void Destroy(entry& item)
+    {
+        if (item.module) vkDestroyShaderModule(graphicsBase::Base().Device(), item.module, nullptr);
+        UnmapFile(item);
+    }
+    // Non-const Function
+    // 逻辑设备创建后，确认 maintenance5 特性是否已开启
+    void OnCreateDevice()
+    {
+        useInlineCode = maintenance5Features.maintenance5;
+    }
+    void Clear()
+    {
+        std::lock_guard lock(mutex);
+        for (auto& [hash, item] : entries) Destroy(item);
+        entries.clear();
+        filepaths.clear();
+    }
+
+public:
+    // Getter
+    // 逻辑设备创建后有效
+    bool UseInlineCode() const
+    {
+        return useInlineCode;
+    }
+    registryStatistics Statistics() const
+    {
+        std::lock_guard lock(mutex);
+        return statistics;
+    }
+    size_t ModuleCount() const
+    {
+        std::lock_guard lock(mutex);
+        return entries.size();
+    }
+    // 取得代码，可用于 shaderReflection::Base().Reflect，在 Release 使引用计数归零前有效
+    std::span<const uint32_t> Code(handle_t handle) const
+    {
+        std::lock_guard lock(mutex);
+        auto it = entries.find(handle);
+        return it == entries.end() ? std::span<const uint32_t>{} : it->second.code;
+    }
+    // Non-const Function
+    // 登记 SPIR-V 文件，同一路径或内容相同的文件返回同一个句柄，引用计数加一
+    // 同一路径只在首次登记时读取，文件在此后被修改不会生效（引用计数归零后重新 Load 则会）
+    VkResult Load(const char* filepath, handle_t& handle)
+    {
+        {
+            std::lock_guard lock(mutex);
+            statistics.loadCount++;
+            if (auto it = filepaths.find(filepath); it != filepaths.end()) {
+                handle = it->second;
+                entries[handle].referenceCount++;
+                statistics.sharedCount++;
+                return VK_SUCCESS;
+            }
+        }
+        // 映射与哈希不持有锁，多个线程可同时加载不同的文件
+        entry item;
+        if (VkResult result = MapFile(filepath, item)) return result;
+        handle = HashSpirv(item.code);
+        std::lock_guard lock(mutex);
+        auto [it, inserted] = entries.try_emplace(handle, std::move(item));
+        if (!inserted) {
+            UnmapFile(item);
+            statistics.sharedCount++;
+        }
+        it->second.referenceCount++;
+        filepaths.emplace(filepath, handle);
+        return VK_SUCCESS;
+    }
+    // 填写着色器阶段的创建信息：支持 maintenance5 时 module 为空，以 inlineCreateInfo 内联代码，
+    // 否则使用（按需创建的）共用的 VkShaderModule；inlineCreateInfo 须在创建管线前保持有效
+    VkResult StageCreateInfo(handle_t handle, VkShaderStageFlagBits stage,
+                             VkPipelineShaderStageCreateInfo& stageCreateInfo,
+                             VkShaderModuleCreateInfo& inlineCreateInfo,
+                             const char* entryPoint = "main")
+    {
+        std::lock_guard lock(mutex);
+        auto it = entries.find(handle);
+        if (it == entries.end()) {
+            std::cout << std::format(
+                "[ shaderModuleRegistry ] ERROR\nThe shader module is not loaded: {:#x}\n",
+                handle);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        entry& item = it->second;
+        inlineCreateInfo = {.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+                            .codeSize = item.code.size_bytes(),
+                            .pCode = item.code.data()};
+        stageCreateInfo = {.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                           .stage = stage,
+                           .pName = entryPoint};
+        if (useInlineCode) {
+            stageCreateInfo.pNext = &inlineCreateInfo;
+            statistics.inlineCount++;
+            return VK_SUCCESS;
+        }
+        if (!item.module) {
+            VkResult result = vkCreateShaderModule(graphicsBase::Base().Device(),
+                                                   &inlineCreateInfo, nullptr, &item.module);
+            if (result) {
+                std::cout << std::format(
+                    "[ shaderModuleRegistry ] ERROR\nFailed to create a shader module!\nError "
+                    "code: {}\n",
+                    int32_t(result));
+                return result;
+            }
+            statistics.moduleCount++;
+        }
+        stageCreateInfo.module = item.module;
+        return VK_SUCCESS;
+    }
+    // 引用计数减一，归零时销毁 VkShaderModule 并解除映射；管线创建后不再需要着色器模块
+    void Release(handle_t handle)
+    {
+        std::lock_guard lock(mutex);
+        auto it = entries.find(handle);
+        if (it == entries.end() || --it->second.referenceCount) return;
+        Destroy(it->second);
+        entries.erase(it);
+        std::erase_if(filepaths, [handle](const auto& i) { return i.second == handle; });
+    }
+    // 在 dynamicRendering::Base().Enable() 后、CreateDevice 前调用，设备支持时开启 maintenance5
+    // 不调用或设备不支持时，总是创建 VkShaderModule
+    VkResult Enable()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        static bool callbackAdded = false;
+        if (!callbackAdded) {
+            base.AddCallback_CreateDevice([] { Base().OnCreateDevice(); });
+            callbackAdded = true;
+        }
+        uint32_t deviceApiVersion = base.DeviceApiVersion();
+        // 特性须经由 vkGetPhysicalDeviceFeatures2 查询
+        if (deviceApiVersion < VK_API_VERSION_1_1) return VK_ERROR_FEATURE_NOT_PRESENT;
+        // maintenance5 在 Vulkan 1.4 中成为核心功能，该特性结构体同样有效
+        if (deviceApiVersion < VK_API_VERSION_1_4) {
+            const char* extensionNames[] = {VK_KHR_MAINTENANCE_5_EXTENSION_NAME};
+            if (VkResult result = base.CheckDeviceExtensions(extensionNames)) return result;
+            if (!extensionNames[0]) return VK_ERROR_EXTENSION_NOT_PRESENT;
+            base.AddDeviceExtension(extensionNames[0]);
+        }
+        base.AddNextStructure_PhysicalDeviceFeatures(maintenance5Features);
+        return VK_SUCCESS;
+    }
+    // Static Function
+    static shaderModuleRegistry& Base()
+    {
+        static shaderModuleRegistry singleton;
+        return singleton;
+    }
+};
+}  // namespace vulkan
@@ -0,0 +1,283 @@
+#pragma once
+#include "VKDynamicRendering.h"
+
+namespace vulkan {
+// VK_EXT_shader_object：不创建管线，逐个绑定着色器，所有状态（含顶点输入）均在录制时动态设置
+// 适用于工具、UI 等状态组合繁多而各组合很少用到的绘制：没有管线编译造成的卡顿，管线缓存也不会膨胀
+// 1. 着色器对象只能在动态渲染中使用，须先调用 dynamicRendering::Base().Enable()
+// 2. 绑定着色器后、绘制前须以 SetGraphicsState 设置全部状态，之后可单独调用 Cmd* 改变个别状态
+// 设备支持时由 CreateDevice 开启，否则 Enabled() 为 false，调用方应退回管线路径
+class shaderObject {
+public:
+    // 绘制所需的全部状态，默认值对应不剔除、不做深度测试、不混合的三角形列表
+    struct graphicsState {
+        VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        VkBool32 primitiveRestartEnable = VK_FALSE;
+        VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+        VkCullModeFlags cullMode = VK_CULL_MODE_NONE;
+        VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+        float lineWidth = 1.f;
+        VkBool32 depthBiasEnable = VK_FALSE;
+        VkSampleCountFlagBits rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        VkSampleMask sampleMask = ~VkSampleMask(0);
+        VkBool32 alphaToCoverageEnable = VK_FALSE;
+        VkBool32 depthTestEnable = VK_FALSE;
+        VkBool32 depthWriteEnable = VK_FALSE;
+        VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+        VkBool32 stencilTestEnable = VK_FALSE;
+        VkStencilOpState stencilOpState = {.compareOp = VK_COMPARE_OP_ALWAYS,
+                                           .compareMask = 0xff,
+                                           .writeMask = 0xff};  // 正反面相同
+        // 以下三者应用于所有颜色附件
+        VkBool32 colorBlendEnable = VK_FALSE;
+        VkColorBlendEquationEXT colorBlendEquation = {
+            .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+            .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+            .colorBlendOp = VK_BLEND_OP_ADD,
+            .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+            .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+            .alphaBlendOp = VK_BLEND_OP_ADD};
+        VkColorComponentFlags colorWriteMask =
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+            VK_COLOR_COMPONENT_A_BIT;
+    };
+
+private:
+    bool enabled = false;
+    VkPhysicalDeviceShaderObjectFeaturesEXT shaderObjectFeatures = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT};
+    // 以下动态状态的命令均由 VK_EXT_shader_object 提供，设备低于 Vulkan 1.3 时同样可用
+    PFN_vkCreateShadersEXT pVkCreateShadersEXT = nullptr;
+    PFN_vkDestroyShaderEXT pVkDestroyShaderEXT = nullptr;
+    PFN_vkCmdBindShadersEXT pVkCmdBindShadersEXT = nullptr;
+    PFN_vkCmdSetVertexInputEXT pVkCmdSetVertexInputEXT = nullptr;
+    PFN_vkCmdSetPrimitiveTopologyEXT pVkCmdSetPrimitiveTopologyEXT = nullptr;
+    PFN_vkCmdSetPrimitiveRestartEnableEXT pVkCmdSetPrimitiveRestartEnableEXT = nullptr;
+    PFN_vkCmdSetViewportWithCountEXT pVkCmdSetViewportWithCountEXT = nullptr;
+    PFN_vkCmdSetScissorWithCountEXT pVkCmdSetScissorWithCountEXT = nullptr;
+    PFN_vkCmdSetRasterizerDiscardEnableEXT pVkCmdSetRasterizerDiscardEnableEXT = nullptr;
+    PFN_vkCmdSetPolygonModeEXT pVkCmdSetPolygonModeEXT = nullptr;
+    PFN_vkCmdSetCullModeEXT pVkCmdSetCullModeEXT = nullptr;
+    PFN_vkCmdSetFrontFaceEXT pVkCmdSetFrontFaceEXT = nullptr;
+    PFN_vkCmdSetDepthBiasEnableEXT pVkCmdSetDepthBiasEnableEXT = nullptr;
+    PFN_vkCmdSetRasterizationSamplesEXT pVkCmdSetRasterizationSamplesEXT = nullptr;
+    PFN_vkCmdSetSampleMaskEXT pVkCmdSetSampleMaskEXT = nullptr;
+    PFN_vkCmdSetAlphaToCoverageEnableEXT pVkCmdSetAlphaToCoverageEnableEXT = nullptr;
+    PFN_vkCmdSetAlphaToOneEnableEXT pVkCmdSetAlphaToOneEnableEXT = nullptr;
+    PFN_vkCmdSetDepthTestEnableEXT pVkCmdSetDepthTestEnableEXT = nullptr;
+    PFN_vkCmdSetDepthWriteEnableEXT pVkCmdSetDepthWriteEnableEXT = nullptr;
+    PFN_vkCmdSetDepthCompareOpEXT pVkCmdSetDepthCompareOpEXT = nullptr;
+    PFN_vkCmdSetDepthBoundsTestEnableEXT pVkCmdSetDepthBoundsTestEnableEXT = nullptr;
+    PFN_vkCmdSetDepthClampEnableEXT pVkCmdSetDepthClampEnableEXT = nullptr;
+    PFN_vkCmdSetStencilTestEnableEXT pVkCmdSetStencilTestEnableEXT = nullptr;
+    PFN_vkCmdSetStencilOpEXT pVkCmdSetStencilOpEXT = nullptr;
+    PFN_vkCmdSetLogicOpEnableEXT pVkCmdSetLogicOpEnableEXT = nullptr;
+    PFN_vkCmdSetColorBlendEnableEXT pVkCmdSetColorBlendEnableEXT = nullptr;
+    PFN_vkCmdSetColorBlendEquationEXT pVkCmdSetColorBlendEquationEXT = nullptr;
+    PFN_vkCmdSetColorWriteMaskEXT pVkCmdSetColorWriteMaskEXT = nullptr;
+
+    //--------------------
+    shaderObject() = default;
+    shaderObject(shaderObject&&) = delete;
+    // Non-const Function
+    template <typename T>
+    bool LoadFunction(T& function, const char* name)
+    {
+        function = reinterpret_cast<T>(vkGetDeviceProcAddr(graphicsBase::Base().Device(), name));
+        return function;
+    }
+    // 逻辑设备创建后，确认特性是否已开启，并取得函数指针
+    void OnCreateDevice()
+    {
+        enabled = shaderObjectFeatures.shaderObject &&
+                  LoadFunction(pVkCreateShadersEXT, "vkCreateShadersEXT") &&
+                  LoadFunction(pVkDestroyShaderEXT, "vkDestroyShaderEXT") &&
+                  LoadFunction(pVkCmdBindShadersEXT, "vkCmdBindShadersEXT") &&
+                  LoadFunction(pVkCmdSetVertexInputEXT, "vkCmdSetVertexInputEXT") &&
+                  LoadFunction(pVkCmdSetPrimitiveTopologyEXT, "vkCmdSetPrimitiveTopologyEXT") &&
+                  LoadFunction(pVkCmdSetPrimitiveRestartEnableEXT,
+                               "vkCmdSetPrimitiveRestartEnableEXT") &&
+                  LoadFunction(pVkCmdSetViewportWithCountEXT, "vkCmdSetViewportWithCountEXT") &&
+                  LoadFunction(pVkCmdSetScissorWithCountEXT, "vkCmdSetScissorWithCountEXT") &&
+                  LoadFunction(pVkCmdSetRasterizerDiscardEnableEXT,
+                               "vkCmdSetRasterizerDiscardEnableEXT") &&
+                  LoadFunction(pVkCmdSetPolygonModeEXT, "vkCmdSetPolygonModeEXT") &&
+                  LoadFunction(pVkCmdSetCullModeEXT, "vkCmdSetCullModeEXT") &&
+                  LoadFunction(pVkCmdSetFrontFaceEXT, "vkCmdSetFrontFaceEXT") &&
+                  LoadFunction(pVkCmdSetDepthBiasEnableEXT, "vkCmdSetDepthBiasEnableEXT") &&
+                  LoadFunction(pVkCmdSetRasterizationSamplesEXT,
+                               "vkCmdSetRasterizationSamplesEXT") &&
+                  LoadFunction(pVkCmdSetSampleMaskEXT, "vkCmdSetSampleMaskEXT") &&
+                  LoadFunction(pVkCmdSetAlphaToCoverageEnableEXT,
+                               "vkCmdSetAlphaToCoverageEnableEXT") &&
+                  LoadFunction(pVkCmdSetAlphaToOneEnableEXT, "vkCmdSetAlphaToOneEnableEXT") &&
+                  LoadFunction(pVkCmdSetDepthTestEnableEXT, "vkCmdSetDepthTestEnableEXT") &&
+                  LoadFunction(pVkCmdSetDepthWriteEnableEXT, "vkCmdSetDepthWriteEnableEXT") &&
+                  LoadFunction(pVkCmdSetDepthCompareOpEXT, "vkCmdSetDepthCompareOpEXT") &&
+                  LoadFunction(pVkCmdSetDepthBoundsTestEnableEXT,
+                               "vkCmdSetDepthBoundsTestEnableEXT") &&
+                  LoadFunction(pVkCmdSetDepthClampEnableEXT, "vkCmdSetDepthClampEnableEXT") &&
+                  LoadFunction(pVkCmdSetStencilTestEnableEXT, "vkCmdSetStencilTestEnableEXT") &&
+                  LoadFunction(pVkCmdSetStencilOpEXT, "vkCmdSetStencilOpEXT") &&
+                  LoadFunction(pVkCmdSetLogicOpEnableEXT, "vkCmdSetLogicOpEnableEXT") &&
+                  LoadFunction(pVkCmdSetColorBlendEnableEXT, "vkCmdSetColorBlendEnableEXT") &&
+                  LoadFunction(pVkCmdSetColorBlendEquationEXT, "vkCmdSetColorBlendEquationEXT") &&
+                  LoadFunction(pVkCmdSetColorWriteMaskEXT, "vkCmdSetColorWriteMaskEXT");
+    }
+
+public:
+    // Getter
+    // 逻辑设备创建后有效
+    bool Enabled() const
+    {
+        return enabled;
+    }
+    // Const Function
+    // 以一次调用创建 createInfos 中的所有着色器，shaders 的大小须与 createInfos 相同
+    // 各 createInfo 带 VK_SHADER_CREATE_LINK_STAGE_BIT_EXT 时它们被一同链接，驱动可跨阶段优化
+    VkResult CreateShaders(std::span<const VkShaderCreateInfoEXT> createInfos,
+                           std::span<VkShaderEXT> shaders) const
+    {
+        VkResult result =
+            pVkCreateShadersEXT(graphicsBase::Base().Device(), uint32_t(createInfos.size()),
+                                createInfos.data(), nullptr, shaders.data());
+        if (result)
+            std::cout << std::format(
+                "[ shaderObject ] ERROR\nFailed to create shader objects!\nError code: {}\n",
+                int32_t(result));
+        return result;
+    }
+    void DestroyShader(VkShaderEXT shader) const
+    {
+        if (shader) pVkDestroyShaderEXT(graphicsBase::Base().Device(), shader, nullptr);
+    }
+    // 绑定顶点和片段着色器，并解绑设备支持的其他图形阶段（曲面细分、几何），
+    // 以免沿用之前绑定的着色器
+    void BindGraphicsShaders(VkCommandBuffer commandBuffer, VkShaderEXT vertexShader,
+                             VkShaderEXT fragmentShader) const
+    {
+        const VkPhysicalDeviceFeatures& features = graphicsBase::Base().PhysicalDeviceFeatures();
+        VkShaderStageFlagBits stages[5] = {VK_SHADER_STAGE_VERTEX_BIT,
+                                           VK_SHADER_STAGE_FRAGMENT_BIT};
+        VkShaderEXT shaders[5] = {vertexShader, fragmentShader};
+        uint32_t stageCount = 2;
+        if (features.tessellationShader) {
+            stages[stageCount++] = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+            stages[stageCount++] = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        }
+        if (features.geometryShader) stages[stageCount++] = VK_SHADER_STAGE_GEOMETRY_BIT;
+        pVkCmdBindShadersEXT(commandBuffer, stageCount, stages, shaders);
+    }
+    void BindComputeShader(VkCommandBuffer commandBuffer, VkShaderEXT computeShader) const
+    {
+        VkShaderStageFlagBits stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pVkCmdBindShadersEXT(commandBuffer, 1, &stage, &computeShader);
+    }
+    void CmdSetVertexInput(
+        VkCommandBuffer commandBuffer,
+        std::span<const VkVertexInputBindingDescription2EXT> bindings,
+        std::span<const VkVertexInputAttributeDescription2EXT> attributes) const
+    {
+        pVkCmdSetVertexInputEXT(commandBuffer, uint32_t(bindings.size()), bindings.data(),
+                                uint32_t(attributes.size()), attributes.data());
+    }
+    void CmdSetViewport(VkCommandBuffer commandBuffer, VkExtent2D extent) const
+    {
+        VkViewport viewport = {0, 0, float(extent.width), float(extent.height), 0.f, 1.f};
+        VkRect2D scissor = {{}, extent};
+        pVkCmdSetViewportWithCountEXT(commandBuffer, 1, &viewport);
+        pVkCmdSetScissorWithCountEXT(commandBuffer, 1, &scissor);
+    }
+    void CmdSetPrimitiveTopology(VkCommandBuffer commandBuffer, VkPrimitiveTopology topology) const
+    {
+        pVkCmdSetPrimitiveTopologyEXT(commandBuffer, topology);
+    }
+    void CmdSetCullMode(VkCommandBuffer commandBuffer, VkCullModeFlags cullMode) const
+    {
+        pVkCmdSetCullModeEXT(commandBuffer, cullMode);
+    }
+    void CmdSetDepthTest(VkCommandBuffer commandBuffer, VkBool32 depthTestEnable,
+                         VkBool32 depthWriteEnable,
+                         VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS) const
+    {
+        pVkCmdSetDepthTestEnableEXT(commandBuffer, depthTestEnable);
+        pVkCmdSetDepthWriteEnableEXT(commandBuffer, depthWriteEnable);
+        pVkCmdSetDepthCompareOpEXT(commandBuffer, depthCompareOp);
+    }
+    void CmdSetColorBlend(VkCommandBuffer commandBuffer, uint32_t colorAttachmentCount,
+                          VkBool32 colorBlendEnable,
+                          const VkColorBlendEquationEXT& colorBlendEquation) const
+    {
+        for (uint32_t i = 0; i < colorAttachmentCount; i++) {
+            pVkCmdSetColorBlendEnableEXT(commandBuffer, i, 1, &colorBlendEnable);
+            pVkCmdSetColorBlendEquationEXT(commandBuffer, i, 1, &colorBlendEquation);
+        }
+    }
+    // 设置以着色器对象绘制所需的全部动态状态，extent 为视口和剪裁范围
+    // 顶点输入另以 CmdSetVertexInput 设置（无顶点缓冲区时传入空的 span），开启深度偏移时另需
+    // vkCmdSetDepthBias
+    // 设备开启了 alphaToOne、depthBounds、depthClamp、logicOp 特性时，相应状态设为关闭
+    void SetGraphicsState(VkCommandBuffer commandBuffer, const graphicsState& state,
+                          VkExtent2D extent, uint32_t colorAttachmentCount = 1) const
+    {
+        const VkPhysicalDeviceFeatures& features = graphicsBase::Base().PhysicalDeviceFeatures();
+        CmdSetViewport(commandBuffer, extent);
+        pVkCmdSetRasterizerDiscardEnableEXT(commandBuffer, VK_FALSE);
+        pVkCmdSetPrimitiveTopologyEXT(commandBuffer, state.topology);
+        pVkCmdSetPrimitiveRestartEnableEXT(commandBuffer, state.primitiveRestartEnable);
+        pVkCmdSetPolygonModeEXT(commandBuffer, state.polygonMode);
+        pVkCmdSetCullModeEXT(commandBuffer, state.cullMode);
+        pVkCmdSetFrontFaceEXT(commandBuffer, state.frontFace);
+        vkCmdSetLineWidth(commandBuffer, state.lineWidth);
+        pVkCmdSetDepthBiasEnableEXT(commandBuffer, state.depthBiasEnable);
+        pVkCmdSetRasterizationSamplesEXT(commandBuffer, state.rasterizationSamples);
+        pVkCmdSetSampleMaskEXT(commandBuffer, state.rasterizationSamples, &state.sampleMask);
+        pVkCmdSetAlphaToCoverageEnableEXT(commandBuffer, state.alphaToCoverageEnable);
+        if (features.alphaToOne) pVkCmdSetAlphaToOneEnableEXT(commandBuffer, VK_FALSE);
+        pVkCmdSetDepthTestEnableEXT(commandBuffer, state.depthTestEnable);
+        pVkCmdSetDepthWriteEnableEXT(commandBuffer, state.depthWriteEnable);
+        pVkCmdSetDepthCompareOpEXT(commandBuffer, state.depthCompareOp);
+        if (features.depthBounds) pVkCmdSetDepthBoundsTestEnableEXT(commandBuffer, VK_FALSE);
+        if (features.depthClamp) pVkCmdSetDepthClampEnableEXT(commandBuffer, VK_FALSE);
+        pVkCmdSetStencilTestEnableEXT(commandBuffer, state.stencilTestEnable);
+        const VkStencilOpState& stencil = state.stencilOpState;
+        pVkCmdSetStencilOpEXT(commandBuffer, VK_STENCIL_FACE_FRONT_AND_BACK, stencil.failOp,
+                              stencil.passOp, stencil.depthFailOp, stencil.compareOp);
+        vkCmdSetStencilCompareMask(commandBuffer, VK_STENCIL_FACE_FRONT_AND_BACK,
+                                   stencil.compareMask);
+        vkCmdSetStencilWriteMask(commandBuffer, VK_STENCIL_FACE_FRONT_AND_BACK, stencil.writeMask);
+        vkCmdSetStencilReference(commandBuffer, VK_STENCIL_FACE_FRONT_AND_BACK, stencil.reference);
+        if (features.logicOp) pVkCmdSetLogicOpEnableEXT(commandBuffer, VK_FALSE);
+        CmdSetColorBlend(commandBuffer, colorAttachmentCount, state.colorBlendEnable,
+                         state.colorBlendEquation);
+        for (uint32_t i = 0; i < colorAttachmentCount; i++)
+            pVkCmdSetColorWriteMaskEXT(commandBuffer, i, 1, &state.colorWriteMask);
+    }
+    // Non-const Function
+    // 在 dynamicRendering::Base().Enable() 后、CreateDevice 前调用，设备不支持时返回
+    // VK_ERROR_EXTENSION_NOT_PRESENT
+    VkResult Enable()
+    {
+        graphicsBase& base = graphicsBase::Base();
+        static bool callbackAdded = false;
+        if (!callbackAdded) {
+            base.AddCallback_CreateDevice([] { Base().OnCreateDevice(); });
+            callbackAdded = true;
+        }
+        // 特性须经由 vkGetPhysicalDeviceFeatures2 查询
+        if (base.DeviceApiVersion() < VK_API_VERSION_1_1) return VK_ERROR_FEATURE_NOT_PRESENT;
+        const char* extensionNames[] = {VK_EXT_SHADER_OBJECT_EXTENSION_NAME};
+        if (VkResult result = base.CheckDeviceExtensions(extensionNames)) return result;
+        if (!extensionNames[0]) return VK_ERROR_EXTENSION_NOT_PRESENT;
+        base.AddDeviceExtension(extensionNames[0]);
+        base.AddNextStructure_PhysicalDeviceFeatures(shaderObjectFeatures);
+        return VK_SUCCESS;
+    }
+    // Static Function
+    static shaderObject& Base()
+    {
+        static shaderObject singleton;
+        return singleton;
+    }
+};
+}  // namespace vulkan
@@ -0,0 +1,663 @@
+#pragma once
+#include "VKDescriptorBuffer.h"
+
+namespace vulkan {
+// 以 SPIR-V 的字为单位计算 FNV-1a 哈希值，字数也计入其中，用作反射结果与着色器模块的键
+inline uint64_t HashSpirv(std::span<const uint32_t> code)
+{
+    uint64_t hash = 0xcbf29ce484222325 ^ code.size();
+    for (auto i : code) hash = (hash ^ i) * 0x100000001b3;
+    return hash;
+}
+
+// 从一个着色器模块的 SPIR-V 中反射出的资源接口，只考虑第一个入口点
+struct spirvReflection {
+    struct descriptorBinding {
+        uint32_t set;
+        uint32_t binding;
+        VkDescriptorType descriptorType;
+        uint32_t descriptorCount;  // 为 0 表示运行时数组
+    };
+    struct specializationConstant {
+        uint32_t constantId;
+        uint32_t size;  // bool 按 VkBool32 计为 4
+        uint64_t defaultValue;
+    };
+    VkShaderStageFlagBits stage;
+    std::vector<descriptorBinding> bindings;
+    std::vector<specializationConstant> specializationConstants;
+    uint32_t pushConstantOffset;
+    uint32_t pushConstantSize;  // 为 0 表示没有推送常量
+    // 计算、任务、网格着色器的工作组大小；由特化常量决定时，workgroupSizeSpecIds 为其
+    // constant_id，workgroupSize 为其默认值，否则为 UINT32_MAX
+    uint32_t workgroupSize[3];
+    uint32_t workgroupSizeSpecIds[3];
+};
+
+// SPIR-V 反射，由模块的字直接解析出描述符绑定、推送常量、特化常量、工作组大小，不依赖外部库
+// 1. Reflect 按模块内容的哈希值缓存结果，SaveCache/LoadCache 将缓存存入文件，下次启动时不必再解析
+// 2. CreatePipelineLayout 合并各阶段的反射结果，同一绑定的阶段标志取并集，
+//    布局经由 descriptorBackend::SetLayout、pipelineLayoutCache 创建，内容相同的布局只创建一次，
+//    使用描述符缓冲区时描述符集布局带有相应的标记，除非调用方指明布局用于描述符集
+// 无法从 SPIR-V 得知缓冲区是否为动态的，需要动态偏移量时，
+// 可在合并前修改 bindings 中的 descriptorType
+class shaderReflection {
+    // SPIR-V 规范中用到的常量
+    static constexpr uint32_t spirv_magic = 0x07230203;
+    enum opcode_t : uint32_t {
+        op_entryPoint = 15,
+        op_executionMode = 16,
+        op_typeBool = 20,
+        op_typeInt = 21,
+        op_typeFloat = 22,
+        op_typeVector = 23,
+        op_typeMatrix = 24,
+        op_typeImage = 25,
+        op_typeSampler = 26,
+        op_typeSampledImage = 27,
+        op_typeArray = 28,
+        op_typeRuntimeArray = 29,
+        op_typeStruct = 30,
+        op_typePointer = 32,
+        op_constantTrue = 41,
+        op_constantFalse = 42,
+        op_constant = 43,
+        op_constantComposite = 44,
+        op_specConstantTrue = 48,
+        op_specConstantFalse = 49,
+        op_specConstant = 50,
+        op_specConstantComposite = 51,
+        op_variable = 59,
+        op_decorate = 71,
+        op_memberDecorate = 72,
+        op_executionModeId = 331,
+        op_typeAccelerationStructure = 5341
+    };
+    enum decoration_t : uint32_t {
+        decoration_specId = 1,
+        decoration_block = 2,
+        decoration_bufferBlock = 3,
+        decoration_arrayStride = 6,
+        decoration_matrixStride = 7,
+        decoration_builtIn = 11,
+        decoration_binding = 33,
+        decoration_descriptorSet = 34,
+        decoration_offset = 35
+    };
+    enum storageClass_t : uint32_t {
+        storageClass_uniformConstant = 0,
+        storageClass_uniform = 2,
+        storageClass_pushConstant = 9,
+        storageClass_storageBuffer = 12
+    };
+    static constexpr uint32_t executionMode_localSize = 17;
+    static constexpr uint32_t executionMode_localSizeId = 38;
+    static constexpr uint32_t builtIn_workgroupSize = 25;
+    static constexpr uint32_t dim_buffer = 5;
+    static constexpr uint32_t dim_subpassData = 6;
+    // 解析嵌套类型的最大深度，防止畸形模块造成无限递归
+    static constexpr uint32_t typeDepthLimit = 32;
+
+    // 解析过程中每个 id 的信息
+    struct idInfo {
+        size_t offset = 0;  // 定义该 id 的指令在 code 中的位置，0 表示未定义
+        uint32_t set = UINT32_MAX;
+        uint32_t binding = UINT32_MAX;
+        uint32_t specId = UINT32_MAX;
+        uint32_t builtIn = UINT32_MAX;
+        uint32_t arrayStride = 0;
+        bool block = false;
+        bool bufferBlock = false;
+    };
+    struct parser {
+        std::span<const uint32_t> code;
+        std::vector<idInfo> ids;
+        // 键为结构体 id 与成员序号
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> memberOffsets;
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> memberMatrixStrides;
+        const uint32_t* Instruction(uint32_t id) const
+        {
+            return id < ids.size() && ids[id].offset ? &code[ids[id].offset] : nullptr;
+        }
+        uint32_t Opcode(uint32_t id) const
+        {
+            const uint32_t* instruction = Instruction(id);
+            return instruction ? instruction[0] & 0xffff : 0;
+        }
+        uint32_t WordCount(uint32_t id) const
+        {
+            const uint32_t* instruction = Instruction(id);
+            return instruction ? instruction[0] >> 16 : 0;
+        }
+        // 标量常量或特化常量的值，取低 32 位
+        uint32_t ConstantValue(uint32_t id) const
+        {
+            switch (Opcode(id)) {
+                case op_constant:
+                case op_specConstant:
+                    return WordCount(id) > 3 ? Instruction(id)[3] : 0;
+                case op_constantTrue:
+                case op_specConstantTrue:
+                    return 1;
+                default:
+                    return 0;
+            }
+        }
+        // 类型在推送常量块中所占的字节数
+        uint32_t TypeSize(uint32_t id, uint32_t depth = 0) const
+        {
+            if (depth > typeDepthLimit) return 0;
+            const uint32_t* instruction = Instruction(id);
+            uint32_t wordCount = WordCount(id);
+            switch (Opcode(id)) {
+                case op_typeBool:
+                    return 4;
+                case op_typeInt:
+                case op_typeFloat:
+                    return wordCount > 2 ? instruction[2] / 8 : 0;
+                case op_typeVector:
+                case op_typeMatrix:
+                    return wordCount > 3 ? instruction[3] * TypeSize(instruction[2], depth + 1)
+                                         : 0;
+                case op_typeArray: {
+                    if (wordCount < 4) return 0;
+                    uint32_t stride = ids[id].arrayStride;
+                    return ConstantValue(instruction[3]) *
+                           (stride ? stride : TypeSize(instruction[2], depth + 1));
+                }
+                case op_typePointer:  // PhysicalStorageBuffer 中的缓冲区地址
+                    return 8;
+                case op_typeStruct: {
+                    uint32_t size = 0;
+                    for (uint32_t i = 2; i < wordCount; i++) {
+                        uint32_t member = i - 2;
+                        auto offset = memberOffsets.find({id, member});
+                        uint32_t memberSize;
+                        auto matrixStride = memberMatrixStrides.find({id, member});
+                        if (matrixStride != memberMatrixStrides.end() &&
+                            Opcode(instruction[i]) == op_typeMatrix)
+                            memberSize = Instruction(instruction[i])[3] * matrixStride->second;
+                        else
+                            memberSize = TypeSize(instruction[i], depth + 1);
+                        size = std::max(
+                            size,
+                            (offset == memberOffsets.end() ? 0 : offset->second) + memberSize);
+                    }
+                    return size;
+                }
+                default:
+                    return 0;
+            }
+        }
+        // 结构体中各成员偏移量的最小值
+        uint32_t StructOffset(uint32_t id) const
+        {
+            uint32_t offset = UINT32_MAX;
+            for (auto& [key, value] : memberOffsets)
+                if (key.first == id) offset = std::min(offset, value);
+            return offset == UINT32_MAX ? 0 : offset;
+        }
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<uint64_t, spirvReflection> reflections;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+
+    //--------------------
+    shaderReflection() = default;
+    shaderReflection(shaderReflection&&) = delete;
+    // Static Function
+    static VkResult InvalidModule(const char* reason)
+    {
+        std::cout << std::format("[ shaderReflection ] ERROR\nInvalid SPIR-V module: {}!\n",
+                                 reason);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    static VkShaderStageFlagBits Stage(uint32_t executionModel)
+    {
+        switch (executionModel) {
+            case 0:
+                return VK_SHADER_STAGE_VERTEX_BIT;
+            case 1:
+                return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+            case 2:
+                return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+            case 3:
+                return VK_SHADER_STAGE_GEOMETRY_BIT;
+            case 4:
+                return VK_SHADER_STAGE_FRAGMENT_BIT;
+            case 5:
+                return VK_SHADER_STAGE_COMPUTE_BIT;
+            case 5313:
+                return VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+            case 5314:
+                return VK_SHADER_STAGE_INTERSECTION_BIT_KHR;
+            case 5315:
+                return VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
+            case 5316:
+                return VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+            case 5317:
+                return VK_SHADER_STAGE_MISS_BIT_KHR;
+            case 5318:
+                return VK_SHADER_STAGE_CALLABLE_BIT_KHR;
+            case 5364:
+                return VK_SHADER_STAGE_TASK_BIT_EXT;
+            case 5365:
+                return VK_SHADER_STAGE_MESH_BIT_EXT;
+            default:
+                return VkShaderStageFlagBits(0);
+        }
+    }
+    // 由变量所指向的类型（已去掉数组）与存储类别确定描述符类型，
+    // 不是资源时返回 VK_DESCRIPTOR_TYPE_MAX_ENUM
+    static VkDescriptorType DescriptorType(const parser& parser, uint32_t typeId,
+                                           uint32_t storageClass)
+    {
+        const uint32_t* instruction = parser.Instruction(typeId);
+        switch (storageClass) {
+            case storageClass_storageBuffer:
+                return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            case storageClass_uniform:
+                // 旧式的存储缓冲区以 BufferBlock 修饰，存储类别为 Uniform
+                return parser.ids[typeId].bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+                                                      : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            case storageClass_uniformConstant:
+                switch (parser.Opcode(typeId)) {
+                    case op_typeSampler:
+                        return VK_DESCRIPTOR_TYPE_SAMPLER;
+                    case op_typeSampledImage:
+                        return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    case op_typeAccelerationStructure:
+                        return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+                    case op_typeImage: {
+                        if (parser.WordCount(typeId) < 9) return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+                        uint32_t dim = instruction[3];
+                        bool sampled = instruction[7] == 1;  // 2 表示用作存储图像
+                        if (dim == dim_subpassData) return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                        if (dim == dim_buffer)
+                            return sampled ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+                                           : VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+                        return sampled ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+                                       : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                    }
+                }
+        }
+        return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    }
+
+public:
+    // Getter
+    uint64_t HitCount() const
+    {
+        std::lock_guard lock(mutex);
+        return hitCount;
+    }
+    uint64_t MissCount() const
+    {
+        std::lock_guard lock(mutex);
+        return missCount;
+    }
+    // Const Function
+    // 将缓存的反射结果写入文件
+    VkResult SaveCache(const char* filepath) const
+    {
+        std::ofstream file(filepath, std::ios::binary);
+        if (!file) {
+            std::cout << std::format("[ shaderReflection ] ERROR\nFailed to open the file: {}\n",
+                                     filepath);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        auto Write = [&file](const auto& value) {
+            file.write(reinterpret_cast<const char*>(&value), sizeof value);
+        };
+        std::lock_guard lock(mutex);
+        Write(spirv_magic);
+        Write(uint64_t(reflections.size()));
+        for (auto& [hash, reflection] : reflections) {
+            Write(hash);
+            Write(reflection.stage);
+            Write(reflection.pushConstantOffset);
+            Write(reflection.pushConstantSize);
+            Write(reflection.workgroupSize);
+            Write(reflection.workgroupSizeSpecIds);
+            Write(uint32_t(reflection.bindings.size()));
+            for (auto& i : reflection.bindings) Write(i);
+            Write(uint32_t(reflection.specializationConstants.size()));
+            for (auto& i : reflection.specializationConstants) Write(i);
+        }
+        return file ? VK_SUCCESS : VK_ERROR_INITIALIZATION_FAILED;
+    }
+    // Non-const Function
+    // 按模块内容的哈希值查找缓存，未命中时解析并加入缓存
+    VkResult Reflect(std::span<const uint32_t> code, spirvReflection& reflection)
+    {
+        uint64_t hash = HashSpirv(code);
+        {
+            std::lock_guard lock(mutex);
+            if (auto it = reflections.find(hash); it != reflections.end()) {
+                hitCount++;
+                reflection = it->second;
+                return VK_SUCCESS;
+            }
+            missCount++;
+        }
+        if (VkResult result = Parse(code, reflection)) return result;
+        std::lock_guard lock(mutex);
+        reflections.emplace(hash, reflection);
+        return VK_SUCCESS;
+    }
+    // 从 SaveCache 写入的文件中读取反射结果，文件不存在或格式不符时返回错误，缓存保持原样
+    VkResult LoadCache(const char* filepath)
+    {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file) return VK_ERROR_INITIALIZATION_FAILED;
+        auto Read = [&file](auto& value) {
+            file.read(reinterpret_cast<char*>(&value), sizeof value);
+        };
+        file.seekg(0, std::ios::end);
+        uint64_t fileSize = uint64_t(file.tellg());
+        file.seekg(0, std::ios::beg);
+        // 读出的数量所需的字节数不得超过文件剩余部分，以免损坏的文件引起巨大的内存分配
+        auto Fits = [&file, fileSize](uint64_t count, uint64_t elementSize) {
+            return count <= (fileSize - uint64_t(file.tellg())) / elementSize;
+        };
+        uint32_t magic = 0;
+        uint64_t count = 0;
+        Read(magic);
+        Read(count);
+        if (!file || magic != spirv_magic) return VK_ERROR_INITIALIZATION_FAILED;
+        if (!Fits(count, sizeof(uint64_t))) file.setstate(std::ios::failbit);
+        std::unordered_map<uint64_t, spirvReflection> loaded;
+        for (uint64_t i = 0; i < count && file; i++) {
+            uint64_t hash;
+            spirvReflection reflection;
+            uint32_t bindingCount = 0, specializationConstantCount = 0;
+            Read(hash);
+            Read(reflection.stage);
+            Read(reflection.pushConstantOffset);
+            Read(reflection.pushConstantSize);
+            Read(reflection.workgroupSize);
+            Read(reflection.workgroupSizeSpecIds);
+            Read(bindingCount);
+            if (!file || !Fits(bindingCount, sizeof reflection.bindings[0])) {
+                file.setstate(std::ios::failbit);
+                break;
+            }
+            reflection.bindings.resize(bindingCount);
+            for (auto& j : reflection.bindings) Read(j);
+            Read(specializationConstantCount);
+            if (!file ||
+                !Fits(specializationConstantCount, sizeof reflection.specializationConstants[0])) {
+                file.setstate(std::ios::failbit);
+                break;
+            }
+            reflection.specializationConstants.resize(specializationConstantCount);
+            for (auto& j : reflection.specializationConstants) Read(j);
+            loaded.emplace(hash, std::move(reflection));
+        }
+        if (!file) {
+            std::cout << std::format(
+                "[ shaderReflection ] ERROR\nThe reflection cache file is corrupted: {}\n",
+                filepath);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        std::lock_guard lock(mutex);
+        reflections.merge(loaded);
+        return VK_SUCCESS;
+    }
+    // Static Function
+    // 解析 SPIR-V，不经过缓存
+    static VkResult Parse(std::span<const uint32_t> code, spirvReflection& reflection)
+    {
+        if (code.size() < 5 || code[0] != spirv_magic) return InvalidModule("bad header");
+        parser parser = {.code = code, .ids = std::vector<idInfo>(code[3])};
+        reflection = {};
+        std::ranges::fill(reflection.workgroupSizeSpecIds, UINT32_MAX);
+        uint32_t executionModel = UINT32_MAX;
+        uint32_t entryPoint = 0;
+        uint32_t localSizeIds[3] = {};
+        std::vector<uint32_t> variables;
+        std::vector<uint32_t> specConstants;
+        for (size_t i = 5; i < code.size();) {
+            uint32_t wordCount = code[i] >> 16;
+            uint32_t opcode = code[i] & 0xffff;
+            if (!wordCount || i + wordCount > code.size())
+                return InvalidModule("truncated instruction");
+            const uint32_t* operands = &code[i + 1];
+            // 指令的第 index 个操作数为 id 时，检查其是否越界
+            auto Id = [&](uint32_t index) -> idInfo* {
+                return index + 1 < wordCount && operands[index] < parser.ids.size()
+                           ? &parser.ids[operands[index]]
+                           : nullptr;
+            };
+            switch (opcode) {
+                case op_entryPoint:
+                    if (executionModel == UINT32_MAX && wordCount > 2) {
+                        executionModel = operands[0];
+                        entryPoint = operands[1];
+                    }
+                    break;
+                case op_executionMode:
+                    if (wordCount > 5 && operands[0] == entryPoint &&
+                        operands[1] == executionMode_localSize)
+                        std::copy_n(operands + 2, 3, reflection.workgroupSize);
+                    break;
+                case op_executionModeId:
+                    if (wordCount > 5 && operands[0] == entryPoint &&
+                        operands[1] == executionMode_localSizeId)
+                        std::copy_n(operands + 2, 3, localSizeIds);
+                    break;
+                case op_decorate:
+                    if (idInfo* info = Id(0); info && wordCount > 2) {
+                        uint32_t literal = wordCount > 3 ? operands[2] : 0;
+                        switch (operands[1]) {
+                            case decoration_specId:
+                                info->specId = literal;
+                                break;
+                            case decoration_block:
+                                info->block = true;
+                                break;
+                            case decoration_bufferBlock:
+                                info->bufferBlock = true;
+                                break;
+                            case decoration_arrayStride:
+                                info->arrayStride = literal;
+                                break;
+                            case decoration_builtIn:
+                                info->builtIn = literal;
+                                break;
+                            case decoration_binding:
+                                info->binding = literal;
+                                break;
+                            case decoration_descriptorSet:
+                                info->set = literal;
+                                break;
+                        }
+                    }
+                    break;
+                case op_memberDecorate:
+                    if (wordCount > 4 && operands[2] == decoration_offset)
+                        parser.memberOffsets[{operands[0], operands[1]}] = operands[3];
+                    else if (wordCount > 4 && operands[2] == decoration_matrixStride)
+                        parser.memberMatrixStrides[{operands[0], operands[1]}] = operands[3];
+                    break;
+                case op_variable:
+                    if (idInfo* info = Id(1)) {
+                        info->offset = i;
+                        variables.push_back(operands[1]);
+                    }
+                    break;
+                case op_specConstantTrue:
+                case op_specConstantFalse:
+                case op_specConstant:
+                    if (Id(1)) specConstants.push_back(operands[1]);
+                    [[fallthrough]];
+                case op_constantTrue:
+                case op_constantFalse:
+                case op_constant:
+                case op_constantComposite:
+                case op_specConstantComposite:
+                    if (idInfo* info = Id(1)) info->offset = i;
+                    break;
+                default:
+                    // OpTypeVoid 至 OpTypeForwardPointer 的结果 id 为第一个操作数
+                    if ((opcode >= 19 && opcode <= 39) || opcode == op_typeAccelerationStructure)
+                        if (idInfo* info = Id(0)) info->offset = i;
+            }
+            i += wordCount;
+        }
+        if (executionModel == UINT32_MAX) return InvalidModule("no entry point");
+        reflection.stage = Stage(executionModel);
+        // 工作组大小：以 BuiltIn WorkgroupSize 修饰的常量优先于 LocalSizeId，后者优先于 LocalSize
+        for (uint32_t i = 0; i < 3; i++)
+            if (localSizeIds[i]) {
+                reflection.workgroupSize[i] = parser.ConstantValue(localSizeIds[i]);
+                reflection.workgroupSizeSpecIds[i] = parser.ids[localSizeIds[i]].specId;
+            }
+        for (uint32_t id = 0; id < parser.ids.size(); id++)
+            if (parser.ids[id].builtIn == builtIn_workgroupSize && parser.WordCount(id) > 5)
+                for (uint32_t i = 0; i < 3; i++) {
+                    uint32_t component = parser.Instruction(id)[3 + i];
+                    reflection.workgroupSize[i] = parser.ConstantValue(component);
+                    reflection.workgroupSizeSpecIds[i] =
+                        component < parser.ids.size() ? parser.ids[component].specId : UINT32_MAX;
+                }
+        for (auto id : specConstants) {
+            const idInfo& info = parser.ids[id];
+            if (info.specId == UINT32_MAX) continue;
+            const uint32_t* instruction = parser.Instruction(id);
+            uint32_t size = parser.TypeSize(instruction[1]);
+            uint64_t value = parser.ConstantValue(id);
+            if (size == 8 && parser.WordCount(id) > 4) value |= uint64_t(instruction[4]) << 32;
+            reflection.specializationConstants.push_back({info.specId, size, value});
+        }
+        for (auto id : variables) {
+            if (parser.WordCount(id) < 4) continue;
+            const uint32_t* variable = parser.Instruction(id);
+            uint32_t storageClass = variable[3];
+            const uint32_t* pointer = parser.Instruction(variable[1]);
+            if (!pointer || parser.Opcode(variable[1]) != op_typePointer ||
+                parser.WordCount(variable[1]) < 4)
+                continue;
+            uint32_t typeId = pointer[3];
+            if (storageClass == storageClass_pushConstant) {
+                uint32_t offset = parser.StructOffset(typeId);
+                reflection.pushConstantOffset = offset;
+                reflection.pushConstantSize = parser.TypeSize(typeId) - offset;
+                continue;
+            }
+            const idInfo& info = parser.ids[id];
+            if (info.binding == UINT32_MAX) continue;
+            // 去掉（可能多层的）数组，描述符个数为各层长度之积
+            uint32_t descriptorCount = 1;
+            for (uint32_t depth = 0; depth < typeDepthLimit; depth++) {
+                uint32_t opcode = parser.Opcode(typeId);
+                if (opcode == op_typeArray && parser.WordCount(typeId) > 3) {
+                    descriptorCount *= parser.ConstantValue(parser.Instruction(typeId)[3]);
+                    typeId = parser.Instruction(typeId)[2];
+                } else if (opcode == op_typeRuntimeArray && parser.WordCount(typeId) > 2) {
+                    descriptorCount = 0;
+                    typeId = parser.Instruction(typeId)[2];
+                } else
+                    break;
+            }
+            VkDescriptorType descriptorType = DescriptorType(parser, typeId, storageClass);
+            if (descriptorType == VK_DESCRIPTOR_TYPE_MAX_ENUM) continue;
+            reflection.bindings.push_back({info.set == UINT32_MAX ? 0 : info.set, info.binding,
+                                           descriptorType, descriptorCount});
+        }
+        return VK_SUCCESS;
+    }
+    // 合并各阶段的反射结果，创建各描述符集布局与管线布局，两者均由缓存持有，调用方不可销毁
+    // setLayouts 的下标为 set 序号，中间未使用的 set 对应空的布局
+    // 推送常量合并为一个范围，vkCmdPushConstants 的 stageFlags 须包含所有用到推送常量的阶段
+    // 运行时数组以 runtimeArrayCount 个描述符创建，设备支持时带 PARTIALLY_BOUND 标志
+    // forDescriptorSets 为 true 时不经过 descriptorBackend，布局总是用于分配描述符集，
+    // 以此创建管线时也不可带 VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT
+    static VkResult CreatePipelineLayout(std::span<const spirvReflection> stages,
+                                         VkPipelineLayout& pipelineLayout,
+                                         std::vector<VkDescriptorSetLayout>& setLayouts,
+                                         uint32_t runtimeArrayCount = 1024,
+                                         bool forDescriptorSets = false)
+    {
+        // 每个 set 中的绑定，按 binding 排序
+        std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;
+        VkPushConstantRange pushConstantRange = {.offset = UINT32_MAX};
+        for (auto& stage : stages) {
+            for (auto& i : stage.bindings) {
+                if (i.set >= sets.size()) sets.resize(i.set + 1);
+                auto& bindings = sets[i.set];
+                auto it = std::ranges::find(bindings, i.binding,
+                                            &VkDescriptorSetLayoutBinding::binding);
+                if (it == bindings.end())
+                    bindings.push_back({i.binding, i.descriptorType,
+                                        i.descriptorCount ? i.descriptorCount : runtimeArrayCount,
+                                        VkShaderStageFlags(stage.stage)});
+                else if (it->descriptorType != i.descriptorType) {
+                    std::cout << std::format(
+                        "[ shaderReflection ] ERROR\nDescriptor types of set {} binding {} "
+                        "differ between stages!\n",
+                        i.set, i.binding);
+                    return VK_ERROR_INITIALIZATION_FAILED;
+                } else
+                    it->stageFlags |= stage.stage;
+            }
+            if (stage.pushConstantSize) {
+                uint32_t end = std::max(pushConstantRange.offset + pushConstantRange.size,
+                                        stage.pushConstantOffset + stage.pushConstantSize);
+                if (pushConstantRange.offset == UINT32_MAX)
+                    end = stage.pushConstantOffset + stage.pushConstantSize;
+                pushConstantRange.offset =
+                    std::min(pushConstantRange.offset, stage.pushConstantOffset);
+                pushConstantRange.size = end - pushConstantRange.offset;
+                pushConstantRange.stageFlags |= stage.stage;
+            }
+        }
+        bool partiallyBound =
+            graphicsBase::Base().PhysicalDeviceVulkan12Features().descriptorBindingPartiallyBound;
+        setLayouts.resize(sets.size());
+        for (size_t i = 0; i < sets.size(); i++) {
+            auto& bindings = sets[i];
+            std::ranges::sort(bindings, {}, &VkDescriptorSetLayoutBinding::binding);
+            std::vector<VkDescriptorBindingFlags> bindingFlags(bindings.size());
+            bool hasRuntimeArray = false;
+            for (auto& j : stages)
+                for (auto& k : j.bindings)
+                    if (k.set == i && !k.descriptorCount && partiallyBound) {
+                        bindingFlags[std::ranges::find(bindings, k.binding,
+                                                       &VkDescriptorSetLayoutBinding::binding) -
+                                     bindings.begin()] =
+                            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+                        hasRuntimeArray = true;
+                    }
+            VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo = {
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+                .bindingCount = uint32_t(bindingFlags.size()),
+                .pBindingFlags = bindingFlags.data()};
+            VkDescriptorSetLayoutCreateInfo createInfo = {
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                .pNext = hasRuntimeArray ? &bindingFlagsCreateInfo : nullptr,
+                .bindingCount = uint32_t(bindings.size()),
+                .pBindings = bindings.data()};
+            if (VkResult result =
+                    forDescriptorSets
+                        ? descriptorSetLayoutCache::Base().Get(createInfo, setLayouts[i])
+                        : descriptorBackend::Base().SetLayout(createInfo, setLayouts[i]))
+                return result;
+        }
+        VkPipelineLayoutCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .setLayoutCount = uint32_t(setLayouts.size()),
+            .pSetLayouts = setLayouts.data(),
+            .pushConstantRangeCount = pushConstantRange.stageFlags ? 1u : 0u,
+            .pPushConstantRanges = &pushConstantRange};
+        return pipelineLayoutCache::Base().Get(createInfo, pipelineLayout);
+    }
+    static shaderReflection& Base()
+    {
+        static shaderReflection singleton;
+        return singleton;
+    }
+};
+}  // namespace vulkan
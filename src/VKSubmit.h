@@ -0,0 +1,346 @@
+#pragma once
+#include "VKBase.h"
+
+namespace vulkan {
+// 提交调度器：各子系统在一帧中把命令缓冲区交给调度器，由调度器统一提交
+// 1. 每个队列一个时间线信号量，每批命令完成时将其置为递增的值
+//    跨队列依赖即等待另一队列的信号量到达某个值
+// 2. Flush 时每个队列只调用一次 vkQueueSubmit2，且相邻的无等待的批次会合并为一个 VkSubmitInfo2
+// 3. CPU 端可以等待或查询某个时间线上的值，不再需要为每次提交准备 fence
+// 需开启 timelineSemaphore 特性（Vulkan 1.2），开启了 synchronization2 特性（Vulkan 1.3）时使用
+// vkQueueSubmit2，否则退回 vkQueueSubmit
+class submissionScheduler {
+public:
+    // 某个队列上某一批命令执行完毕的时刻
+    struct timelinePoint {
+        uint32_t queueIndex = UINT32_MAX;  // 队列在调度器中的索引
+        uint64_t value = 0;
+    };
+    // 等待 point 后，dstStageMask 及其后的阶段才开始执行
+    struct dependency {
+        timelinePoint point;
+        VkPipelineStageFlags2 dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    };
+    // 用于与交换链交互的二值信号量，如等待获取图像、完成后通知呈现
+    struct binarySemaphoreInfo {
+        VkSemaphore waitSemaphore = VK_NULL_HANDLE;
+        VkPipelineStageFlags2 waitStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+        VkSemaphore signalSemaphore = VK_NULL_HANDLE;
+    };
+    struct schedulerStatistics {
+        uint64_t batchCount;       // Enqueue 的批次数
+        uint64_t submitInfoCount;  // 合并后的 VkSubmitInfo2 个数
+        uint64_t submitCallCount;  // vkQueueSubmit2 的调用次数
+    };
+
+private:
+    struct batch {
+        std::vector<VkCommandBuffer> commandBuffers;
+        std::vector<dependency> waits;
+        binarySemaphoreInfo binarySemaphores;
+        uint64_t signalValue;
+    };
+    struct queueState {
+        VkQueue queue;
+        timelineSemaphore semaphore;
+        uint64_t lastEnqueuedValue = 0;   // 最近一次 Enqueue 分配的值
+        uint64_t lastSubmittedValue = 0;  // 最近一次 Flush 提交的值
+        uint64_t completedValue = 0;      // 最近一次查询到的已完成的值
+        uint64_t lastFailedValue = 0;     // 提交失败的批次中最大的值，这些值不会被置位
+        VkResult failedResult = VK_SUCCESS;
+        std::vector<batch> pendingBatches;
+    };
+    std::vector<queueState> queues;
+    mutable std::mutex mutex;             // 允许多个线程上的子系统同时 Enqueue、Wait
+    schedulerStatistics statistics = {};  // 由 mutex 保护
+
+    // 将 batches 合并为尽量少的 VkSubmitInfo2，然后一次提交
+    VkResult Submit2(queueState& queue)
+    {
+        size_t batchCount = queue.pendingBatches.size();
+        size_t commandBufferCount = 0, waitCount = 0;
+        for (auto& i : queue.pendingBatches)
+            commandBufferCount += i.commandBuffers.size(), waitCount += i.waits.size() + 1;
+        // 预留足够空间，保证下面取到的指针不会因扩容而失效
+        std::vector<VkCommandBufferSubmitInfo> commandBufferInfos;
+        std::vector<VkSemaphoreSubmitInfo> waitInfos, signalInfos;
+        std::vector<VkSubmitInfo2> submitInfos;
+        commandBufferInfos.reserve(commandBufferCount);
+        waitInfos.reserve(waitCount);
+        signalInfos.reserve(batchCount * 2);
+        submitInfos.reserve(batchCount);
+        for (auto& i : queue.pendingBatches) {
+            // 有等待的批次若并入前一个 VkSubmitInfo2，会让前面的命令也一并等待，可能导致死锁
+            // 前一个 VkSubmitInfo2 置位了二值信号量时也不可合并，否则会推迟该信号量的置位
+            bool merge = !submitInfos.empty() && i.waits.empty() &&
+                         !i.binarySemaphores.waitSemaphore &&
+                         submitInfos.back().signalSemaphoreInfoCount == 1;
+            if (!merge) {
+                submitInfos.push_back({.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+                                       .pWaitSemaphoreInfos = waitInfos.data() + waitInfos.size(),
+                                       .pCommandBufferInfos =
+                                           commandBufferInfos.data() + commandBufferInfos.size(),
+                                       .pSignalSemaphoreInfos =
+                                           signalInfos.data() + signalInfos.size()});
+                for (auto& j : i.waits)
+                    waitInfos.push_back({.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                                         .semaphore = queues[j.point.queueIndex].semaphore,
+                                         .value = j.point.value,
+                                         .stageMask = j.dstStageMask});
+                if (i.binarySemaphores.waitSemaphore)
+                    waitInfos.push_back({.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                                         .semaphore = i.binarySemaphores.waitSemaphore,
+                                         .stageMask = i.binarySemaphores.waitStageMask});
+                submitInfos.back().waitSemaphoreInfoCount =
+                    uint32_t(waitInfos.data() + waitInfos.size() -
+                             submitInfos.back().pWaitSemaphoreInfos);
+                signalInfos.push_back({.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                                       .semaphore = queue.semaphore,
+                                       .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT});
+                submitInfos.back().signalSemaphoreInfoCount = 1;
+            }
+            VkSubmitInfo2& submitInfo = submitInfos.back();
+            for (auto j : i.commandBuffers)
+                commandBufferInfos.push_back(
+                    {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO, .commandBuffer = j});
+            submitInfo.commandBufferInfoCount += uint32_t(i.commandBuffers.size());
+            // 合并后只需置位其中最大的值
+            signalInfos.back().value = i.signalValue;
+            if (i.binarySemaphores.signalSemaphore) {
+                signalInfos.push_back({.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                                       .semaphore = i.binarySemaphores.signalSemaphore,
+                                       .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT});
+                submitInfo.signalSemaphoreInfoCount++;
+            }
+        }
+        statistics.submitInfoCount += submitInfos.size();
+        statistics.submitCallCount++;
+        VkResult result = vkQueueSubmit2(queue.queue, uint32_t(submitInfos.size()),
+                                         submitInfos.data(), VK_NULL_HANDLE);
+        if (result)
+            std::cout << std::format(
+                "[ submissionScheduler ] ERROR\nFailed to submit the command buffers!\nError code: "
+                "{}\n",
+                int32_t(result));
+        return result;
+    }
+    // 未开启 synchronization2 时的退路，每个批次一个 VkSubmitInfo，同样只调用一次 vkQueueSubmit
+    VkResult Submit(queueState& queue)
+    {
+        size_t batchCount = queue.pendingBatches.size();
+        std::vector<VkSubmitInfo> submitInfos(batchCount);
+        std::vector<VkTimelineSemaphoreSubmitInfo> timelineInfos(batchCount);
+        // 每个批次的等待信号量、值、阶段，以及置位的信号量与值
+        struct batchSemaphores {
+            std::vector<VkSemaphore> waitSemaphores;
+            std::vector<uint64_t> waitValues;
+            std::vector<VkPipelineStageFlags> waitStageMasks;
+            VkSemaphore signalSemaphores[2];
+            uint64_t signalValues[2];
+        };
+        std::vector<batchSemaphores> semaphores(batchCount);
+        for (size_t i = 0; i < batchCount; i++) {
+            batch& b = queue.pendingBatches[i];
+            batchSemaphores& s = semaphores[i];
+            // VkPipelineStageFlags2 中低 32 位的阶段与 VkPipelineStageFlags 一致
+            for (auto& j : b.waits) {
+                s.waitSemaphores.push_back(queues[j.point.queueIndex].semaphore);
+                s.waitValues.push_back(j.point.value);
+                s.waitStageMasks.push_back(VkPipelineStageFlags(j.dstStageMask));
+            }
+            if (b.binarySemaphores.waitSemaphore) {
+                s.waitSemaphores.push_back(b.binarySemaphores.waitSemaphore);
+                s.waitValues.push_back(0);
+                s.waitStageMasks.push_back(
+                    VkPipelineStageFlags(b.binarySemaphores.waitStageMask));
+            }
+            uint32_t signalCount = 1;
+            s.signalSemaphores[0] = queue.semaphore;
+            s.signalValues[0] = b.signalValue;
+            if (b.binarySemaphores.signalSemaphore)
+                s.signalSemaphores[signalCount] = b.binarySemaphores.signalSemaphore,
+                s.signalValues[signalCount++] = 0;
+            timelineInfos[i] = {.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                                .waitSemaphoreValueCount = uint32_t(s.waitValues.size()),
+                                .pWaitSemaphoreValues = s.waitValues.data(),
+                                .signalSemaphoreValueCount = signalCount,
+                                .pSignalSemaphoreValues = s.signalValues};
+            submitInfos[i] = {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                              .pNext = &timelineInfos[i],
+                              .waitSemaphoreCount = uint32_t(s.waitSemaphores.size()),
+                              .pWaitSemaphores = s.waitSemaphores.data(),
+                              .pWaitDstStageMask = s.waitStageMasks.data(),
+                              .commandBufferCount = uint32_t(b.commandBuffers.size()),
+                              .pCommandBuffers = b.commandBuffers.data(),
+                              .signalSemaphoreCount = signalCount,
+                              .pSignalSemaphores = s.signalSemaphores};
+        }
+        statistics.submitInfoCount += batchCount;
+        statistics.submitCallCount++;
+        VkResult result =
+            vkQueueSubmit(queue.queue, uint32_t(batchCount), submitInfos.data(), VK_NULL_HANDLE);
+        if (result)
+            std::cout << std::format(
+                "[ submissionScheduler ] ERROR\nFailed to submit the command buffers!\nError code: "
+                "{}\n",
+                int32_t(result));
+        return result;
+    }
+
+public:
+    submissionScheduler() = default;
+    submissionScheduler(submissionScheduler&&) = delete;
+    // Getter
+    uint32_t QueueCount() const
+    {
+        return uint32_t(queues.size());
+    }
+    VkQueue Queue(uint32_t queueIndex) const
+    {
+        return queues[queueIndex].queue;
+    }
+    VkSemaphore Semaphore(uint32_t queueIndex) const
+    {
+        return queues[queueIndex].semaphore;
+    }
+    uint64_t LastSubmittedValue(uint32_t queueIndex) const
+    {
+        std::lock_guard lock(mutex);
+        return queues[queueIndex].lastSubmittedValue;
+    }
+    // 计数器在锁内更新，此处在锁内复制一份，以免读到其他线程正在写入的值
+    schedulerStatistics Statistics() const
+    {
+        std::lock_guard lock(mutex);
+        return statistics;
+    }
+    // Non-const Function
+    // 注册 graphicsBase 的 图形/计算 队列，二者相同时只注册一次
+    VkResult Create()
+    {
+        if (!graphicsBase::Base().PhysicalDeviceVulkan12Features().timelineSemaphore) {
+            std::cout << std::format(
+                "[ submissionScheduler ] ERROR\nTimeline semaphores are not supported!\n");
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        queues.clear();
+        statistics = {};
+        uint32_t queueIndex;
+        if (VkQueue queue = graphicsBase::Base().Queue_Graphics())
+            if (VkResult result = AddQueue(queue, queueIndex)) return result;
+        if (VkQueue queue = graphicsBase::Base().Queue_Compute())
+            if (VkResult result = AddQueue(queue, queueIndex)) return result;
+        return VK_SUCCESS;
+    }
+    // 注册一个队列并为其创建时间线信号量，已注册过则直接返回其索引
+    // 应在各子系统开始 Enqueue 前完成注册
+    VkResult AddQueue(VkQueue queue, uint32_t& queueIndex)
+    {
+        for (queueIndex = 0; queueIndex < queues.size(); queueIndex++)
+            if (queues[queueIndex].queue == queue) return VK_SUCCESS;
+        queues.emplace_back().queue = queue;
+        return queues.back().semaphore.Create();
+    }
+    // 返回 queue 在调度器中的索引，未注册时返回 UINT32_MAX
+    uint32_t QueueIndex(VkQueue queue) const
+    {
+        for (uint32_t i = 0; i < queues.size(); i++)
+            if (queues[i].queue == queue) return i;
+        return UINT32_MAX;
+    }
+    // 加入一批命令，返回其执行完毕的时刻，可作为其他批次的依赖或供 CPU 等待
+    // 同一队列上的批次按 Enqueue 的顺序提交
+    timelinePoint Enqueue(uint32_t queueIndex, std::span<const VkCommandBuffer> commandBuffers,
+                          std::span<const dependency> waits = {})
+    {
+        return Enqueue(queueIndex, commandBuffers, waits, binarySemaphoreInfo());
+    }
+    timelinePoint Enqueue(uint32_t queueIndex, std::span<const VkCommandBuffer> commandBuffers,
+                          std::span<const dependency> waits,
+                          const binarySemaphoreInfo& binarySemaphores)
+    {
+        std::lock_guard lock(mutex);
+        queueState& queue = queues[queueIndex];
+        queue.pendingBatches.push_back(
+            {.commandBuffers = {commandBuffers.begin(), commandBuffers.end()},
+             .waits = {waits.begin(), waits.end()},
+             .binarySemaphores = binarySemaphores,
+             .signalValue = ++queue.lastEnqueuedValue});
+        statistics.batchCount++;
+        return {queueIndex, queue.lastEnqueuedValue};
+    }
+    timelinePoint Enqueue(VkQueue queue, std::span<const VkCommandBuffer> commandBuffers,
+                          std::span<const dependency> waits = {})
+    {
+        return Enqueue(QueueIndex(queue), commandBuffers, waits, binarySemaphoreInfo());
+    }
+    timelinePoint Enqueue(VkQueue queue, std::span<const VkCommandBuffer> commandBuffers,
+                          std::span<const dependency> waits,
+                          const binarySemaphoreInfo& binarySemaphores)
+    {
+        return Enqueue(QueueIndex(queue), commandBuffers, waits, binarySemaphores);
+    }
+    // 提交所有已加入的批次，每个队列至多一次提交调用
+    // 需在 vkQueuePresentKHR 前调用，以保证置位呈现所等待的二值信号量的批次已提交
+    VkResult Flush()
+    {
+        std::lock_guard lock(mutex);
+        bool useSubmit2 = graphicsBase::Base().PhysicalDeviceVulkan13Features().synchronization2;
+        VkResult result = VK_SUCCESS;
+        // 跨队列的等待可能先于对应值的置位被提交，时间线信号量允许这种情况
+        for (auto& i : queues) {
+            if (i.pendingBatches.empty()) continue;
+            if (VkResult r = useSubmit2 ? Submit2(i) : Submit(i)) {
+                // 这些批次的值已交给调用方，记下以免 Wait 永远等待
+                result = r;
+                i.lastFailedValue = i.pendingBatches.back().signalValue;
+                i.failedResult = r;
+                i.pendingBatches.clear();
+                continue;
+            }
+            i.lastSubmittedValue = i.pendingBatches.back().signalValue;
+            i.pendingBatches.clear();
+        }
+        return result;
+    }
+    // 查询 point 是否已执行完毕，不阻塞
+    bool IsComplete(timelinePoint point)
+    {
+        return CompletedValue(point.queueIndex) >= point.value;
+    }
+    // 队列上已执行完毕的最大值
+    uint64_t CompletedValue(uint32_t queueIndex)
+    {
+        std::lock_guard lock(mutex);
+        queueState& queue = queues[queueIndex];
+        uint64_t value;
+        if (!queue.semaphore.Value(value))
+            queue.completedValue = std::max(queue.completedValue, value);
+        return queue.completedValue;
+    }
+    // 阻塞直到 point 执行完毕，超时返回 VK_TIMEOUT
+    // point 尚未被 Flush 时返回 VK_NOT_READY
+    // 其所在的批次提交失败、且此后没有成功提交更大的值时，返回提交时的错误码，而不是一直等待
+    VkResult Wait(timelinePoint point, uint64_t timeout = UINT64_MAX)
+    {
+        std::unique_lock lock(mutex);
+        queueState& queue = queues[point.queueIndex];
+        if (queue.completedValue >= point.value) return VK_SUCCESS;
+        if (point.value > queue.lastSubmittedValue)
+            return point.value <= queue.lastFailedValue ? queue.failedResult : VK_NOT_READY;
+        // 等待时不持有锁，以免阻塞其他线程的 Enqueue 与 Flush
+        lock.unlock();
+        VkResult result = queue.semaphore.Wait(point.value, timeout);
+        lock.lock();
+        if (!result) queue.completedValue = std::max(queue.completedValue, point.value);
+        return result;
+    }
+    // 等待所有队列上已提交的命令执行完毕
+    VkResult WaitAll(uint64_t timeout = UINT64_MAX)
+    {
+        for (uint32_t i = 0; i < queues.size(); i++)
+            if (VkResult result = Wait({i, LastSubmittedValue(i)}, timeout)) return result;
+        return VK_SUCCESS;
+    }
+};
+}  // namespace vulkan
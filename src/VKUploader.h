@@ -0,0 +1,548 @@
+#pragma once
+#include "VKBase.h"
+
+namespace vulkan {
+// 经由固定大小的暂存环形缓冲区，将顶点、索引、纹理等数据上传到设备本地内存
+// 1. 暂存缓冲区持续映射，上传时只把数据复制到其中并记下复制命令；Flush 时将两次 Flush 之间的
+//    全部复制录制到一个命令缓冲区，同一目标的复制合并为一次 vkCmdCopyBuffer(ToImage)，一次提交
+// 2. 暂存空间按批次依次回收，空间不足时先提交当前批次，再等待最早的批次完成，等待计入统计
+// 3. 传输队列族与图形队列族不同时，在传输队列上释放所有权，再向图形队列提交一个等待传输完成、
+//    获取所有权的命令缓冲区，此后提交到图形队列的命令可直接使用上传的资源
+// 4. 每个批次完成时将时间线信号量置为该批次的值，调用方可据此查询或等待
+// 需开启 timelineSemaphore 特性（Vulkan 1.2）；非线程安全，且 Flush 会提交到图形队列，
+// 应在提交图形命令的线程上使用
+class stagingUploader {
+public:
+    struct uploadStatistics {
+        uint64_t uploadedBytes;   // 已写入暂存缓冲区的字节数
+        uint64_t copyCount;       // vkCmdCopyBuffer 与 vkCmdCopyBufferToImage 的调用次数
+        uint64_t batchCount;      // 提交的批次数
+        uint64_t stallCount;      // 因暂存空间不足而等待批次完成的次数
+        double stallTime;         // 等待暂存空间的总时长，单位为毫秒
+        VkDeviceSize peakUsage;   // 暂存缓冲区被占用的峰值（含对齐与回绕浪费的空间）
+        uint64_t completedBytes;  // 已完成的批次的字节数
+        double transferTime;      // 已完成的批次自提交至被观察到完成的总时长，单位为毫秒
+    };
+
+private:
+    struct bufferCopy {
+        VkBuffer dstBuffer;
+        VkBufferCopy region;
+        VkPipelineStageFlags dstStageMask;
+        VkAccessFlags dstAccessMask;
+    };
+    struct imageCopy {
+        VkImage dstImage;
+        VkBufferImageCopy region;
+        VkImageLayout finalLayout;
+        VkPipelineStageFlags dstStageMask;
+        VkAccessFlags dstAccessMask;
+    };
+    struct batch {
+        VkCommandBuffer transferCommandBuffer;
+        VkCommandBuffer acquireCommandBuffer;  // 队列族相同时为 VK_NULL_HANDLE
+        VkDeviceSize ringEnd;                  // 该批次最后一次分配的末尾
+        VkDeviceSize byteCount;
+        uint64_t value;  // 该批次完成时时间线信号量的值
+        std::chrono::steady_clock::time_point submitTime;
+    };
+    buffer stagingBuffer;
+    deviceMemory stagingMemory;
+    uint8_t* pMappedData = nullptr;
+    VkDeviceSize capacity = 0;
+    VkDeviceSize copyAlignment = 16;
+    VkDeviceSize head = 0;  // 下一次分配的起点
+    VkDeviceSize tail = 0;  // 最早的未完成批次的起点
+    uint32_t transferQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    uint32_t graphicsQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    commandPool transferCommandPool;
+    commandPool graphicsCommandPool;  // 仅在队列族不同时创建，用于获取所有权
+    std::vector<VkCommandBuffer> freeTransferCommandBuffers;
+    std::vector<VkCommandBuffer> freeAcquireCommandBuffers;
+    timelineSemaphore semaphore;
+    uint64_t lastSubmittedValue = 0;
+    uint64_t completedValue = 0;
+    std::deque<batch> inFlightBatches;
+    std::vector<bufferCopy> pendingBufferCopies;
+    std::vector<imageCopy> pendingImageCopies;
+    VkDeviceSize pendingByteCount = 0;
+    uploadStatistics statistics = {};
+
+    //--------------------
+    bool SeparateQueueFamilies() const
+    {
+        return transferQueueFamilyIndex != graphicsQueueFamilyIndex;
+    }
+    bool HasPendingCopies() const
+    {
+        return pendingBufferCopies.size() || pendingImageCopies.size();
+    }
+    void Retire(const batch& finished)
+    {
+        statistics.completedBytes += finished.byteCount;
+        statistics.transferTime += std::chrono::duration<double, std::milli>(
+                                       std::chrono::steady_clock::now() - finished.submitTime)
+                                       .count();
+        tail = finished.ringEnd;
+        freeTransferCommandBuffers.push_back(finished.transferCommandBuffer);
+        if (finished.acquireCommandBuffer)
+            freeAcquireCommandBuffers.push_back(finished.acquireCommandBuffer);
+    }
+    // 回收已完成的批次占用的暂存空间与命令缓冲区
+    void Reclaim()
+    {
+        if (inFlightBatches.empty()) return;
+        CompletedValue();
+        while (inFlightBatches.size() && inFlightBatches.front().value <= completedValue)
+            Retire(inFlightBatches.front()), inFlightBatches.pop_front();
+    }
+    // 空闲区域为 [head, tail)，或未回绕时的 [head, capacity) 与 [0, tail)
+    bool TryAllocate(VkDeviceSize size, VkDeviceSize& offset)
+    {
+        bool empty = inFlightBatches.empty() && !HasPendingCopies();
+        if (empty) head = tail = 0;
+        VkDeviceSize alignedHead = (head + copyAlignment - 1) / copyAlignment * copyAlignment;
+        if (empty || head > tail) {
+            if (alignedHead + size <= capacity)
+                offset = alignedHead;
+            else if (size <= tail)
+                offset = 0;
+            else
+                return false;
+        } else if (alignedHead + size <= tail)
+            offset = alignedHead;
+        else
+            return false;
+        head = offset + size;
+        return true;
+    }
+    // 分配暂存空间并写入数据，空间不足时提交当前批次并等待最早的批次完成
+    VkResult Stage(const void* pData, VkDeviceSize size, VkDeviceSize& offset)
+    {
+        if (size > capacity) {
+            std::cout << std::format(
+                "[ stagingUploader ] ERROR\nData size exceeds the staging capacity!\nData size: "
+                "{}\nCapacity: {}\n",
+                size, capacity);
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+        Reclaim();
+        while (!TryAllocate(size, offset)) {
+            // 当前批次占用的空间须先提交，才能在完成后回收
+            if (HasPendingCopies())
+                if (VkResult result = Flush()) return result;
+            auto time0 = std::chrono::steady_clock::now();
+            if (VkResult result = Wait(inFlightBatches.front().value)) return result;
+            statistics.stallCount++;
+            statistics.stallTime +=
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time0)
+                    .count();
+            Reclaim();
+        }
+        memcpy(pMappedData + offset, pData, size_t(size));
+        statistics.peakUsage = std::max(
+            statistics.peakUsage, head > tail ? head - tail : capacity - tail + head);
+        statistics.uploadedBytes += size;
+        pendingByteCount += size;
+        return VK_SUCCESS;
+    }
+    VkResult GetCommandBuffer(const commandPool& pool, std::vector<VkCommandBuffer>& freeBuffers,
+                              VkCommandBuffer& handle)
+    {
+        if (freeBuffers.empty())
+            if (VkResult result = pool.AllocateBuffers({&freeBuffers.emplace_back(), 1})) {
+                freeBuffers.pop_back();
+                return result;
+            }
+        handle = freeBuffers.back();
+        freeBuffers.pop_back();
+        // 命令池带 RESET_COMMAND_BUFFER_BIT，Begin 会隐式重置
+        return commandBuffer(handle).Begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    }
+    static VkImageSubresourceRange SubresourceRange(const VkImageSubresourceLayers& subresource)
+    {
+        return {subresource.aspectMask, subresource.mipLevel, 1, subresource.baseArrayLayer,
+                subresource.layerCount};
+    }
+    // 将当前批次的图像转换到 TRANSFER_DST_OPTIMAL，然后录制全部复制
+    void RecordCopies(VkCommandBuffer commandBuffer)
+    {
+        // 按目标排序（稳定排序不改变对同一目标的复制的先后），相邻的同一目标合并为一次调用
+        std::ranges::stable_sort(pendingBufferCopies, {}, &bufferCopy::dstBuffer);
+        std::ranges::stable_sort(pendingImageCopies, {}, &imageCopy::dstImage);
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        for (auto& i : pendingImageCopies)
+            imageBarriers.push_back(
+                {.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                 .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                 .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                 .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                 .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                 .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                 .image = i.dstImage,
+                 .subresourceRange = SubresourceRange(i.region.imageSubresource)});
+        if (imageBarriers.size())
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                                 uint32_t(imageBarriers.size()), imageBarriers.data());
+        std::vector<VkBufferCopy> bufferRegions;
+        for (size_t i = 0; i < pendingBufferCopies.size(); i++) {
+            bufferRegions.push_back(pendingBufferCopies[i].region);
+            if (i + 1 < pendingBufferCopies.size() &&
+                pendingBufferCopies[i + 1].dstBuffer == pendingBufferCopies[i].dstBuffer)
+                continue;
+            vkCmdCopyBuffer(commandBuffer, stagingBuffer, pendingBufferCopies[i].dstBuffer,
+                            uint32_t(bufferRegions.size()), bufferRegions.data());
+            bufferRegions.clear();
+            statistics.copyCount++;
+        }
+        std::vector<VkBufferImageCopy> imageRegions;
+        for (size_t i = 0; i < pendingImageCopies.size(); i++) {
+            imageRegions.push_back(pendingImageCopies[i].region);
+            if (i + 1 < pendingImageCopies.size() &&
+                pendingImageCopies[i + 1].dstImage == pendingImageCopies[i].dstImage)
+                continue;
+            vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, pendingImageCopies[i].dstImage,
+                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   uint32_t(imageRegions.size()), imageRegions.data());
+            imageRegions.clear();
+            statistics.copyCount++;
+        }
+    }
+    // 录制复制之后的屏障，队列族不同时 acquireCommandBuffer 有效
+    // 释放（传输队列）与获取（图形队列）所有权的屏障，除访问掩码外须完全一致
+    void RecordBarriers(VkCommandBuffer transferCommandBuffer,
+                        VkCommandBuffer acquireCommandBuffer, VkPipelineStageFlags& dstStageMask)
+    {
+        bool separate = SeparateQueueFamilies();
+        uint32_t srcFamily = separate ? transferQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dstFamily = separate ? graphicsQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+        std::vector<VkBufferMemoryBarrier> bufferBarriers;
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        VkAccessFlags bufferDstAccessMask = 0;
+        dstStageMask = 0;
+        for (auto& i : pendingBufferCopies) {
+            dstStageMask |= i.dstStageMask;
+            bufferDstAccessMask |= i.dstAccessMask;
+            if (separate)
+                bufferBarriers.push_back({.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                                          .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                                          .srcQueueFamilyIndex = srcFamily,
+                                          .dstQueueFamilyIndex = dstFamily,
+                                          .buffer = i.dstBuffer,
+                                          .offset = i.region.dstOffset,
+                                          .size = i.region.size});
+        }
+        for (auto& i : pendingImageCopies) {
+            dstStageMask |= i.dstStageMask;
+            imageBarriers.push_back({.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                                     .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                                     .dstAccessMask = separate ? 0 : i.dstAccessMask,
+                                     .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                     .newLayout = i.finalLayout,
+                                     .srcQueueFamilyIndex = srcFamily,
+                                     .dstQueueFamilyIndex = dstFamily,
+                                     .image = i.dstImage,
+                                     .subresourceRange =
+                                         SubresourceRange(i.region.imageSubresource)});
+        }
+        if (!separate) {
+            // 同一队列族，缓冲区只需一个全局的内存屏障
+            VkMemoryBarrier memoryBarrier = {.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                                             .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                                             .dstAccessMask = bufferDstAccessMask};
+            vkCmdPipelineBarrier(transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 dstStageMask, 0, pendingBufferCopies.size() ? 1 : 0,
+                                 &memoryBarrier, 0, nullptr, uint32_t(imageBarriers.size()),
+                                 imageBarriers.data());
+            return;
+        }
+        // 释放，传输队列上的 dstStageMask 与 dstAccessMask 被忽略
+        vkCmdPipelineBarrier(transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                             uint32_t(bufferBarriers.size()), bufferBarriers.data(),
+                             uint32_t(imageBarriers.size()), imageBarriers.data());
+        // 获取，信号量的等待已保证复制完成且写入可见，srcAccessMask 为 0
+        // 信号量在 dstStageMask 处等待，srcStageMask 须同为 dstStageMask，屏障（及布局转换）
+        // 才排在等待之后，否则可能在传输队列仍在复制时执行
+        for (size_t i = 0; i < bufferBarriers.size(); i++)
+            bufferBarriers[i].srcAccessMask = 0,
+            bufferBarriers[i].dstAccessMask = pendingBufferCopies[i].dstAccessMask;
+        for (size_t i = 0; i < imageBarriers.size(); i++)
+            imageBarriers[i].srcAccessMask = 0,
+            imageBarriers[i].dstAccessMask = pendingImageCopies[i].dstAccessMask;
+        vkCmdPipelineBarrier(acquireCommandBuffer, dstStageMask, dstStageMask, 0, 0, nullptr,
+                             uint32_t(bufferBarriers.size()), bufferBarriers.data(),
+                             uint32_t(imageBarriers.size()), imageBarriers.data());
+    }
+    VkResult SubmitTransfer(VkCommandBuffer transferCommandBuffer,
+                            VkCommandBuffer acquireCommandBuffer, VkPipelineStageFlags dstStageMask)
+    {
+        uint64_t transferValue = lastSubmittedValue + 1;
+        VkTimelineSemaphoreSubmitInfo timelineInfo = {
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .signalSemaphoreValueCount = 1,
+            .pSignalSemaphoreValues = &transferValue};
+        VkSubmitInfo submitInfo = {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                                   .pNext = &timelineInfo,
+                                   .commandBufferCount = 1,
+                                   .pCommandBuffers = &transferCommandBuffer,
+                                   .signalSemaphoreCount = 1,
+                                   .pSignalSemaphores = semaphore.Address()};
+        VkResult result = vkQueueSubmit(graphicsBase::Base().Queue_Transfer(), 1, &submitInfo,
+                                        VK_NULL_HANDLE);
+        if (!result && acquireCommandBuffer) {
+            // 获取所有权的命令缓冲区等待传输完成后执行，完成时置为下一个值
+            uint64_t acquireValue = transferValue + 1;
+            VkTimelineSemaphoreSubmitInfo acquireTimelineInfo = {
+                .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                .waitSemaphoreValueCount = 1,
+                .pWaitSemaphoreValues = &transferValue,
+                .signalSemaphoreValueCount = 1,
+                .pSignalSemaphoreValues = &acquireValue};
+            VkSubmitInfo acquireSubmitInfo = {.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                                              .pNext = &acquireTimelineInfo,
+                                              .waitSemaphoreCount = 1,
+                                              .pWaitSemaphores = semaphore.Address(),
+                                              .pWaitDstStageMask = &dstStageMask,
+                                              .commandBufferCount = 1,
+                                              .pCommandBuffers = &acquireCommandBuffer,
+                                              .signalSemaphoreCount = 1,
+                                              .pSignalSemaphores = semaphore.Address()};
+            result = vkQueueSubmit(graphicsBase::Base().Queue_Graphics(), 1, &acquireSubmitInfo,
+                                   VK_NULL_HANDLE);
+        }
+        if (result)
+            std::cout << std::format(
+                "[ stagingUploader ] ERROR\nFailed to submit the upload commands!\nError code: "
+                "{}\n",
+                int32_t(result));
+        return result;
+    }
+
+public:
+    stagingUploader() = default;
+    stagingUploader(VkDeviceSize capacity)
+    {
+        Create(capacity);
+    }
+    stagingUploader(stagingUploader&&) = delete;
+    ~stagingUploader()
+    {
+        Destroy();
+    }
+    // Getter
+    VkDeviceSize Capacity() const
+    {
+        return capacity;
+    }
+    VkSemaphore Semaphore() const
+    {
+        return semaphore;
+    }
+    // 当前批次完成时时间线信号量的值，上传函数返回后调用即得到该次上传完成时的值
+    uint64_t PendingValue() const
+    {
+        return lastSubmittedValue + (SeparateQueueFamilies() ? 2 : 1);
+    }
+    uint64_t LastSubmittedValue() const
+    {
+        return lastSubmittedValue;
+    }
+    const uploadStatistics& Statistics() const
+    {
+        return statistics;
+    }
+    // 已完成批次的平均吞吐量，单位为 MB/s
+    // 完成时刻以 CPU 观察到的为准，所以偏低，查询越频繁越接近实际值
+    double Throughput() const
+    {
+        if (statistics.transferTime <= 0) return 0;
+        return statistics.completedBytes / double(1 << 20) / (statistics.transferTime / 1000);
+    }
+    // Non-const Function
+    // capacity 为暂存缓冲区的大小，单次上传的数据（图像的一个 mip 等级）不能超过该值
+    VkResult Create(VkDeviceSize capacity)
+    {
+        Destroy();
+        graphicsBase& base = graphicsBase::Base();
+        if (!base.PhysicalDeviceVulkan12Features().timelineSemaphore) {
+            std::cout << std::format(
+                "[ stagingUploader ] ERROR\nTimeline semaphores are not supported!\n");
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        transferQueueFamilyIndex = base.QueueFamilyIndex_Transfer();
+        graphicsQueueFamilyIndex = base.QueueFamilyIndex_Graphics();
+        if (graphicsQueueFamilyIndex == VK_QUEUE_FAMILY_IGNORED) {
+            std::cout << std::format("[ stagingUploader ] ERROR\nNo graphics queue!\n");
+            return VK_RESULT_MAX_ENUM;
+        }
+        copyAlignment = std::max(
+            base.PhysicalDeviceProperties().limits.optimalBufferCopyOffsetAlignment,
+            VkDeviceSize(16));
+        this->capacity = capacity;
+        VkBufferCreateInfo bufferCreateInfo = {.size = capacity,
+                                               .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT};
+        if (VkResult result = stagingBuffer.Create(bufferCreateInfo)) return result;
+        // 暂存数据放在主机内存，由传输队列经 PCIe 读取
+        // 必然存在 host coherent 的内存类型，使用它则写入后无需刷新
+        if (VkResult result = stagingMemory.Allocate(
+                stagingBuffer.MemoryRequirements(),
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+            return result;
+        if (VkResult result = stagingBuffer.BindMemory(stagingMemory)) return result;
+        void* pData;
+        if (VkResult result = stagingMemory.MapMemory(pData, VK_WHOLE_SIZE)) return result;
+        pMappedData = static_cast<uint8_t*>(pData);
+        constexpr VkCommandPoolCreateFlags poolFlags =
+            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        if (VkResult result = transferCommandPool.Create(transferQueueFamilyIndex, poolFlags))
+            return result;
+        if (SeparateQueueFamilies())
+            if (VkResult result = graphicsCommandPool.Create(graphicsQueueFamilyIndex, poolFlags))
+                return result;
+        return semaphore.Create();
+    }
+    // 上传到 dstBuffer 的 [dstOffset, dstOffset + size)，超过暂存容量一半的数据会被分块上传
+    // dstStageMask 与 dstAccessMask 为图形队列上之后使用该数据的阶段与访问方式
+    VkResult UploadBuffer(VkBuffer dstBuffer, const void* pData, VkDeviceSize size,
+                          VkDeviceSize dstOffset = 0,
+                          VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                          VkAccessFlags dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                                                        VK_ACCESS_INDEX_READ_BIT)
+    {
+        // 分块使前一块的传输与后一块的写入可以重叠
+        VkDeviceSize maxChunkSize = std::max(capacity / 2, VkDeviceSize(1));
+        for (VkDeviceSize done = 0; done < size;) {
+            VkDeviceSize chunkSize = std::min(size - done, maxChunkSize);
+            VkDeviceSize offset;
+            if (VkResult result =
+                    Stage(static_cast<const uint8_t*>(pData) + done, chunkSize, offset))
+                return result;
+            pendingBufferCopies.push_back({.dstBuffer = dstBuffer,
+                                           .region = {offset, dstOffset + done, chunkSize},
+                                           .dstStageMask = dstStageMask,
+                                           .dstAccessMask = dstAccessMask});
+            done += chunkSize;
+        }
+        return VK_SUCCESS;
+    }
+    // 上传图像的一个 mip 等级（可含多个图层），该子资源原有的内容会被丢弃，完成后处于 finalLayout
+    // 数据紧密排列；extent 须为该 mip 等级的完整尺寸，以满足传输队列的 minImageTransferGranularity
+    VkResult UploadImage(VkImage dstImage, const void* pData, VkDeviceSize size, VkExtent3D extent,
+                         VkImageSubresourceLayers subresource,
+                         VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         VkAccessFlags dstAccessMask = VK_ACCESS_SHADER_READ_BIT)
+    {
+        // 同一批次中对同一子资源的布局转换只能有一次，重复上传时先提交之前的
+        for (auto& i : pendingImageCopies) {
+            const VkImageSubresourceLayers& pending = i.region.imageSubresource;
+            if (i.dstImage == dstImage && pending.mipLevel == subresource.mipLevel &&
+                pending.baseArrayLayer < subresource.baseArrayLayer + subresource.layerCount &&
+                subresource.baseArrayLayer < pending.baseArrayLayer + pending.layerCount) {
+                if (VkResult result = Flush()) return result;
+                break;
+            }
+        }
+        VkDeviceSize offset;
+        if (VkResult result = Stage(pData, size, offset)) return result;
+        pendingImageCopies.push_back({.dstImage = dstImage,
+                                      .region = {.bufferOffset = offset,
+                                                 .imageSubresource = subresource,
+                                                 .imageExtent = extent},
+                                      .finalLayout = finalLayout,
+                                      .dstStageMask = dstStageMask,
+                                      .dstAccessMask = dstAccessMask});
+        return VK_SUCCESS;
+    }
+    // 录制并提交当前批次，之后可用 PendingValue() 之前的值查询完成情况
+    // 通常每帧调用一次，且在提交使用这些资源的图形命令之前
+    VkResult Flush()
+    {
+        if (!HasPendingCopies()) return VK_SUCCESS;
+        batch current = {.ringEnd = head, .byteCount = pendingByteCount};
+        if (VkResult result = GetCommandBuffer(transferCommandPool, freeTransferCommandBuffers,
+                                               current.transferCommandBuffer))
+            return result;
+        if (SeparateQueueFamilies())
+            if (VkResult result = GetCommandBuffer(graphicsCommandPool, freeAcquireCommandBuffers,
+                                                   current.acquireCommandBuffer)) {
+                freeTransferCommandBuffers.push_back(current.transferCommandBuffer);
+                return result;
+            }
+        VkPipelineStageFlags dstStageMask;
+        RecordCopies(current.transferCommandBuffer);
+        RecordBarriers(current.transferCommandBuffer, current.acquireCommandBuffer, dstStageMask);
+        VkResult result = commandBuffer(current.transferCommandBuffer).End();
+        if (!result && current.acquireCommandBuffer)
+            result = commandBuffer(current.acquireCommandBuffer).End();
+        if (!result)
+            result = SubmitTransfer(current.transferCommandBuffer, current.acquireCommandBuffer,
+                                    dstStageMask);
+        // 失败时丢弃当前批次，其占用的暂存空间随之释放
+        pendingBufferCopies.clear();
+        pendingImageCopies.clear();
+        pendingByteCount = 0;
+        if (result) {
+            head = inFlightBatches.size() ? inFlightBatches.back().ringEnd : tail;
+            freeTransferCommandBuffers.push_back(current.transferCommandBuffer);
+            if (current.acquireCommandBuffer)
+                freeAcquireCommandBuffers.push_back(current.acquireCommandBuffer);
+            return result;
+        }
+        current.value = lastSubmittedValue = PendingValue();
+        current.submitTime = std::chrono::steady_clock::now();
+        inFlightBatches.push_back(current);
+        statistics.batchCount++;
+        return VK_SUCCESS;
+    }
+    // 阻塞直到时间线信号量的值不小于 value，超时返回 VK_TIMEOUT
+    VkResult Wait(uint64_t value, uint64_t timeout = UINT64_MAX)
+    {
+        if (completedValue >= value) return VK_SUCCESS;
+        VkResult result = semaphore.Wait(value, timeout);
+        if (!result) completedValue = std::max(completedValue, value);
+        return result;
+    }
+    // 查询 value 对应的批次是否已完成，不阻塞
+    bool IsComplete(uint64_t value)
+    {
+        return CompletedValue() >= value;
+    }
+    uint64_t CompletedValue()
+    {
+        uint64_t value;
+        if (completedValue < lastSubmittedValue && !semaphore.Value(value)) completedValue = value;
+        return completedValue;
+    }
+    // 提交当前批次并等待所有批次完成
+    VkResult WaitIdle()
+    {
+        if (VkResult result = Flush()) return result;
+        if (VkResult result = Wait(lastSubmittedValue)) return result;
+        Reclaim();
+        return VK_SUCCESS;
+    }
+    // 等待所有已提交的批次完成后销毁，未提交的上传会被丢弃
+    void Destroy()
+    {
+        if (inFlightBatches.size()) semaphore.Wait(lastSubmittedValue);
+        if (pMappedData) vkUnmapMemory(graphicsBase::Base().Device(), stagingMemory);
+        pMappedData = nullptr;
+        // 移出到临时对象，由其析构函数销毁
+        buffer(std::move(stagingBuffer));
+        deviceMemory(std::move(stagingMemory));
+        commandPool(std::move(transferCommandPool));
+        commandPool(std::move(graphicsCommandPool));
+        timelineSemaphore(std::move(semaphore));
+        freeTransferCommandBuffers.clear();
+        freeAcquireCommandBuffers.clear();
+        inFlightBatches.clear();
+        pendingBufferCopies.clear();
+        pendingImageCopies.clear();
+        capacity = head = tail = pendingByteCount = 0;
+        lastSubmittedValue = completedValue = 0;
+    }
+};
+}  // namespace vulkan
@@ -1,8 +1,27 @@
 #include "GlfwGeneral.hpp"
+#include "VKPrimitives.h"
+
+// 以一次 reduce 确认计算核可在当前的描述符后端下调度，
+// descriptorBackend 使用描述符缓冲区时，计算核仍经由描述符集绑定资源
+// 需要 shader 目录下编译好的 SPIR-V 文件
+void CheckComputeDispatch()
+{
+    using namespace vulkan;
+    computeContext context;
+    parallelPrimitives primitives;
+    parallelPrimitives::benchmarkResult result;
+    if (context.Create() || primitives.Create(context, 1 << 20) ||
+        primitives.Benchmark(parallelPrimitives::primitive_reduce, 1 << 20, result))
+        return;
+    std::cout << std::format("[ CheckComputeDispatch ]\nDescriptor {}: reduce {} in {:.3f} ms\n",
+                             descriptorBackend::Base().UseDescriptorBuffer() ? "buffer" : "sets",
+                             result.correct ? "correct" : "INCORRECT", result.time);
+}
 
 int main()
 {
     if (!InitializeWindow({1280, 720})) return -1;
+    CheckComputeDispatch();
     while (!glfwWindowShouldClose(pWindow)) {
         TitleFps();
         glfwPollEvents();